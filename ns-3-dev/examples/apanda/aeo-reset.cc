@@ -0,0 +1,102 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// Time how long resetting every node's DDC state takes, with one AEO per
+// address against the batched AEO SendHeartbeats uses. Prints
+// R,<mode>,<round>,<wall clock ms> for every reset.
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/point-to-point-module.h"
+#include "ns3/topology-read-module.h"
+#include "ns3/global-route-manager-impl.h"
+#include "ns3/system-wall-clock-ms.h"
+#include <iostream>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("DDC-AEO-RESET");
+
+void PopulateGraph(const std::string& filename, TopologyGraph &graph)
+{
+  NS_LOG_INFO("Entering PopulateGraph with file " << filename);
+  Ptr<EdgeListTopologyReader> reader = CreateObject<EdgeListTopologyReader> ();
+  reader->SetFileName(filename);
+  NS_ABORT_MSG_UNLESS(reader->ReadGraph(), "Cannot read topology " << filename);
+  graph = reader->GetGraph();
+}
+
+// What SendHeartbeats did before AEO was batched: one event and one AEO
+// per address
+void ResetPerAddress (NodeContainer &nodes)
+{
+  for (uint32_t i = 0; i < nodes.GetN(); i++) {
+    Ptr<Ipv4> ipv4 = nodes.Get(i)->GetObject<Ipv4>();
+    Ptr<Ipv4GlobalRouting> gr = nodes.Get(i)->GetObject<GlobalRouter>()->GetRoutingProtocol();
+    for (uint32_t iface = 1; iface < ipv4->GetNInterfaces(); iface++) {
+      for (uint32_t addr = 0; addr < ipv4->GetNAddresses(iface); addr++) {
+        Ipv4Address local = ipv4->GetAddress(iface, addr).GetLocal();
+        if (gr->GetDestinationKey(local) != local) {
+          continue;
+        }
+        Simulator::ScheduleNow(&Ipv4GlobalRouting::SendInitialHeartbeat, gr, local);
+      }
+    }
+  }
+}
+
+void ResetBatched (NodeContainer &nodes)
+{
+  SimulationSingleton<GlobalRouteManagerImpl>::Get ()->SendHeartbeats();
+}
+
+int
+main (int argc, char *argv[])
+{
+  std::string topology;
+  uint32_t rounds = 3;
+  CommandLine cmd;
+  cmd.AddValue("topology", "Topology file", topology);
+  cmd.AddValue("rounds", "Number of resets to time for each mode", rounds);
+  cmd.Parse(argc, argv);
+
+  TopologyGraph graph;
+  PopulateGraph(topology, graph);
+  PointToPointTopologyHelper links;
+  links.SetDeviceAttribute ("DataRate", StringValue ("10Gbps"));
+  links.SetChannelAttribute ("Delay", StringValue ("1ms"));
+  NodeContainer nodes = links.Install(graph);
+  SystemWallClockMs clock;
+  clock.Start();
+  Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
+  // Let the initial heartbeats finish, creating all of the DDC state
+  Simulator::Run ();
+  std::cout << "S," << nodes.GetN() << "," << links.GetNLinks() << "," << clock.End() << std::endl;
+
+  for (uint32_t round = 0; round < rounds; round++) {
+    clock.Start();
+    ResetPerAddress(nodes);
+    Simulator::Run ();
+    std::cout << "R,address," << round << "," << clock.End() << std::endl;
+    clock.Start();
+    ResetBatched(nodes);
+    Simulator::Run ();
+    std::cout << "R,batched," << round << "," << clock.End() << std::endl;
+  }
+  Simulator::Destroy ();
+  return 0;
+}
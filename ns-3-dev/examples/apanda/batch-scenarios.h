@@ -0,0 +1,333 @@
+#pragma once
+// Batch mode for the DDC drivers: build the topology once, then run a file
+// of scenarios back to back in the same process. The simulator clock cannot
+// be rewound without destroying the nodes, so each scenario starts where the
+// last one stopped, with the routing state restored to what it was before
+// the first scenario, and drivers print times relative to the scenario start.
+// With more than one job, each scenario instead runs in a process forked
+// from the settled simulation, so every scenario shares the topology and
+// routing tables copy-on-write and starts from the same state.
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/rng-stream.h"
+#include "ns3/system-path.h"
+#include "ns3/system-wall-clock-ms.h"
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+#include "boost/algorithm/string.hpp"
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace ns3;
+
+// One line of a scenario file: whitespace separated key=value pairs, with
+// the keys named after the driver's command line options, e.g.
+//   name=two-links links=2=4,2=10 paths=1=4,10=1 delay=0.5
+// Options a scenario leaves out keep the value the command line gave them.
+class BatchScenario {
+public:
+  std::string m_name;
+  std::map<std::string, std::string> m_options;
+
+  bool Has (const std::string& key) const {
+    return m_options.find(key) != m_options.end();
+  }
+
+  std::string Get (const std::string& key, const std::string& def = "") const {
+    std::map<std::string, std::string>::const_iterator it = m_options.find(key);
+    return it == m_options.end() ? def : it->second;
+  }
+
+  double GetDouble (const std::string& key, double def) const {
+    return Has(key) ? std::atof(Get(key).c_str()) : def;
+  }
+
+  void Set (const std::string& key, const std::string& value) {
+    m_options[key] = value;
+  }
+};
+
+// Blank lines and lines starting with # are skipped; scenarios without a
+// name are named after their position in the file. Names must be unique,
+// since each scenario's results are written to <name>.txt
+inline std::vector<BatchScenario> ReadBatchScenarios (const std::string& filename) {
+  std::vector<BatchScenario> scenarios;
+  std::set<std::string> names;
+  std::ifstream file(filename.c_str());
+  NS_ABORT_MSG_UNLESS(file.is_open(), "Cannot open scenario file " << filename);
+  std::string line;
+  uint32_t lineNumber = 0;
+  while (getline(file, line)) {
+    lineNumber++;
+    std::istringstream tokens(line);
+    std::string token;
+    BatchScenario scenario;
+    while (tokens >> token) {
+      if (scenario.m_options.empty() && token[0] == '#') {
+        break;
+      }
+      // Values contain '=' themselves (links=2=4), so split on the first one
+      size_t split = token.find('=');
+      NS_ABORT_MSG_IF(split == std::string::npos, "Scenario option " << token << " is not key=value");
+      scenario.Set(token.substr(0, split), token.substr(split + 1));
+    }
+    if (scenario.m_options.empty()) {
+      continue;
+    }
+    std::ostringstream name;
+    name << scenarios.size();
+    scenario.m_name = scenario.Get("name", name.str());
+    NS_ABORT_MSG_UNLESS(names.insert(scenario.m_name).second,
+                        "Scenario " << scenario.m_name << " on line " << lineNumber << " of " << filename << " is named twice");
+    scenarios.push_back(scenario);
+  }
+  return scenarios;
+}
+
+// Writes a scenario as one line ReadBatchScenarios reads back, name first
+inline void WriteBatchScenario (std::ostream& out, const BatchScenario& scenario) {
+  out << "name=" << scenario.m_name;
+  for (std::map<std::string, std::string>::const_iterator it = scenario.m_options.begin();
+       it != scenario.m_options.end();
+       it++) {
+    if (it->first != "name") {
+      out << " " << it->first << "=" << it->second;
+    }
+  }
+  out << std::endl;
+}
+
+// Adds the pairs of node ids in a list like 2=4,2=10 to results; an empty
+// list adds none
+inline void ParseLinks (const std::string& links, std::vector<std::pair<uint32_t, uint32_t> >& results) {
+  if (links.empty()) {
+    return;
+  }
+  std::vector<std::string> linkParts;
+  boost::split(linkParts, links, boost::is_any_of(","));
+  for (std::vector<std::string>::iterator it = linkParts.begin();
+       it != linkParts.end(); it++) {
+    std::vector<std::string> nodeParts;
+    boost::split(nodeParts, *it, boost::is_any_of("="));
+    NS_ASSERT(nodeParts.size() == 2);
+    results.push_back(std::pair<uint32_t, uint32_t>(std::atoi(nodeParts[0].c_str()), std::atoi(nodeParts[1].c_str())));
+  }
+}
+
+// The options every driver's topology handles the same way, on the command
+// line and in scenarios: when the applications stop, when the scenario
+// started, and how long DDC waits to reverse links, in units of delayUnit.
+// A scenario that leaves out the delay gets the command line's, whatever
+// the scenario before it used.
+// A driver's StartScenario calls BeginScenario and then schedules its own
+// failures and traffic.
+class BatchTopology {
+protected:
+  Time m_simulationEnd;
+  Time m_scenarioStart;
+  double m_delay;
+  double m_defaultDelay;
+  Time::Unit m_delayUnit;
+
+public:
+  BatchTopology (Time simulationEnd, Time::Unit delayUnit) :
+    m_simulationEnd(simulationEnd),
+    m_delay(0.0),
+    m_defaultDelay(0.0),
+    m_delayUnit(delayUnit) {
+  }
+
+  // Zero leaves the applications running until the simulation runs out of
+  // events, which batch mode needs to run more than once
+  void SetSimulationEnd (Time end) {
+    m_simulationEnd = end;
+  }
+
+  void SetDelay (double delay) {
+    m_delay = delay;
+    m_defaultDelay = delay;
+  }
+
+  void SetRepairDelay (Ptr<Ipv4GlobalRouting> gr) const {
+    Time delay = Time::FromDouble(m_delay, m_delayUnit);
+    gr->SetAttribute("ReverseOutputToInputDelay", TimeValue(delay));
+    gr->SetAttribute("ReverseInputToOutputDelay", TimeValue(delay));
+  }
+
+  // Times are printed relative to the start of the scenario, which is
+  // time zero unless this is a later scenario of a batch
+  Time ScenarioTime () const {
+    return Simulator::Now() - m_scenarioStart;
+  }
+
+  // Starts the scenario's clock now, and gives every node the scenario's
+  // delay if it differs from the current one. Random variables take the package's next stream
+  // when they first draw, so a scenario would otherwise see different
+  // numbers depending on which scenarios ran before it in the process;
+  // instead every scenario hands out streams from the start of RngSeed
+  // again, as a fresh process would. Drivers recreate any variable they
+  // keep across scenarios after calling this.
+  void BeginScenario (const BatchScenario& scenario, NodeContainer& nodes) {
+    m_scenarioStart = Simulator::Now();
+    // The first stream created reads RngSeed over whatever was set before,
+    // so make sure that has happened
+    RngStream first;
+    RngStream::SetPackageSeed(SeedManager::GetSeed());
+    double delay = scenario.GetDouble("delay", m_defaultDelay);
+    if (delay != m_delay) {
+      m_delay = delay;
+      for (uint32_t i = 0; i < nodes.GetN(); i++) {
+        SetRepairDelay(nodes.Get(i)->GetObject<GlobalRouter>()->GetRoutingProtocol());
+      }
+    }
+  }
+};
+
+// Sends std::cout to <directory>/<scenario>.txt for as long as it lives, or
+// leaves it alone and marks the start of the scenario with a B,<scenario>
+// line when there is no directory
+class BatchOutput {
+  std::ofstream m_file;
+  std::streambuf* m_saved;
+public:
+  BatchOutput (const std::string& directory, const std::string& name) : m_saved(0) {
+    if (directory.empty()) {
+      std::cout << "B," << name << std::endl;
+      return;
+    }
+    std::string filename = SystemPath::Append(directory, name + ".txt");
+    m_file.open(filename.c_str());
+    NS_ABORT_MSG_UNLESS(m_file.is_open(), "Cannot write scenario output " << filename);
+    m_saved = std::cout.rdbuf(m_file.rdbuf());
+  }
+
+  ~BatchOutput () {
+    std::cout.flush();
+    if (m_saved) {
+      std::cout.rdbuf(m_saved);
+    }
+  }
+};
+
+// Runs one scenario in a child forked from the settled simulation, and
+// exits without running any destructors, which belong to the parent
+template <class T>
+pid_t ForkBatchScenario (T& topology, const BatchScenario& scenario, const std::string& directory) {
+  std::cout.flush();
+  std::cerr.flush();
+  pid_t pid = fork();
+  NS_ABORT_MSG_IF(pid < 0, "Cannot fork scenario " << scenario.m_name);
+  if (pid != 0) {
+    return pid;
+  }
+  SystemWallClockMs clock;
+  clock.Start();
+  {
+    BatchOutput output(directory, scenario.m_name);
+    topology.StartScenario(scenario);
+    Simulator::Run ();
+    topology.EndScenario();
+  }
+  // One write, so that lines from concurrent scenarios do not interleave
+  std::ostringstream line;
+  line << "B," << scenario.m_name << "," << clock.End() << std::endl;
+  std::cerr << line.str();
+  _exit(0);
+}
+
+// Runs every scenario against a topology whose simulation has been hooked
+// up but not run. The topology provides
+// StartScenario (const BatchScenario&), which schedules the scenario's
+// failures and traffic relative to now, and EndScenario (), which prints
+// anything reported once the scenario is over. Prints
+// B,<scenario>,<wall clock ms> to stderr for every scenario. Up to jobs
+// scenarios run at once, one per core if jobs is 0; their results are
+// merged on stdout in scenario order unless they go to a directory.
+template <class T>
+void RunBatchScenarios (T& topology, const std::vector<BatchScenario>& scenarios, const std::string& directory, uint32_t jobs = 1) {
+  if (!directory.empty()) {
+    SystemPath::MakeDirectories(directory);
+  }
+  if (jobs == 0) {
+    jobs = sysconf(_SC_NPROCESSORS_ONLN);
+  }
+  // Let the initial heartbeats finish and the servers start, and keep the
+  // routing state every scenario starts from
+  Simulator::Run ();
+  Ipv4GlobalRoutingHelper::SaveRoutingState ();
+  SystemWallClockMs clock;
+  if (jobs <= 1) {
+    for (std::vector<BatchScenario>::const_iterator it = scenarios.begin(); it != scenarios.end(); it++) {
+      clock.Start();
+      {
+        BatchOutput output(directory, it->m_name);
+        topology.StartScenario(*it);
+        Simulator::Run ();
+        topology.EndScenario();
+      }
+      std::cerr << "B," << it->m_name << "," << clock.End() << std::endl;
+      Ipv4GlobalRoutingHelper::RestoreRoutingState ();
+    }
+    return;
+  }
+
+  // Children cannot share stdout, so without a directory they write to a
+  // temporary one that is copied out once they are all done
+  std::string outputDirectory = directory;
+  if (outputDirectory.empty()) {
+    outputDirectory = SystemPath::MakeTemporaryDirectoryName();
+    SystemPath::MakeDirectories(outputDirectory);
+  }
+  clock.Start();
+  std::map<pid_t, uint32_t> running;
+  uint32_t next = 0;
+  uint32_t failed = 0;
+  while (next < scenarios.size() || !running.empty()) {
+    if (next < scenarios.size() && running.size() < jobs) {
+      running[ForkBatchScenario(topology, scenarios[next], outputDirectory)] = next;
+      next++;
+      continue;
+    }
+    int status;
+    pid_t pid = wait(&status);
+    NS_ABORT_MSG_IF(pid < 0, "Lost track of the scenario processes");
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+      std::cerr << "B," << scenarios[running[pid]].m_name << ",failed" << std::endl;
+      failed++;
+    }
+    running.erase(pid);
+  }
+  std::cerr << "B,total," << scenarios.size() << "," << failed << "," << clock.End() << std::endl;
+
+  if (directory.empty()) {
+    for (std::vector<BatchScenario>::const_iterator it = scenarios.begin(); it != scenarios.end(); it++) {
+      std::string result = SystemPath::Append(outputDirectory, it->m_name + ".txt");
+      std::ifstream file(result.c_str());
+      std::cout << "B," << it->m_name << std::endl;
+      // Streaming an empty file would leave std::cout failed
+      if (file.is_open() && file.peek() != std::ifstream::traits_type::eof()) {
+        std::cout << file.rdbuf();
+      }
+      file.close();
+      std::remove(result.c_str());
+    }
+    std::cout.flush();
+    std::remove(outputDirectory.c_str());
+  }
+}
+
+// Runs every scenario in filename, as above
+template <class T>
+void RunBatchScenarios (T& topology, const std::string& filename, const std::string& directory, uint32_t jobs = 1) {
+  RunBatchScenarios(topology, ReadBatchScenarios(filename), directory, jobs);
+}
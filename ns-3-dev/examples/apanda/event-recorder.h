@@ -0,0 +1,107 @@
+#pragma once
+// Binary event log for the DDC drivers. Per packet text lines flushed with
+// std::endl dominate the run time of long bursts, so drivers given an event
+// file append fixed size records to a buffer instead and write it out in
+// large blocks. read_events.py in the repository root reads the files back.
+//
+// A file is a 16 byte header (the magic "DDCEVT1" and a NUL, then the
+// record size and a reserved word, both uint32) followed by records in
+// host byte order, with times relative to when the file was opened.
+#include "ns3/core-module.h"
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace ns3;
+
+enum EventType {
+  EVENT_RX = 0,        // echo reply back at the client: src, node, seq
+  EVENT_SERVER_RX = 1, // echo request at the server: src, node, seq
+  EVENT_REVERSAL = 2,  // node reversed interface seq towards dst
+  EVENT_DROP = 3,      // IP drop at node of a src to dst packet with ttl
+  EVENT_PHY_DROP = 4,  // device queue drop at node
+  EVENT_FAIL = 5,      // link between src and dst failed
+  EVENT_TCP_RX = 6     // TCP sink received seq bytes from node
+};
+
+struct EventRecord {
+  int64_t time;  // nanoseconds
+  uint32_t node;
+  uint32_t src;
+  uint32_t dst;
+  uint32_t seq;
+  uint8_t type;
+  uint8_t ttl;
+  uint8_t pad[6];
+};
+
+class EventRecorder {
+  static const uint32_t BUFFER_RECORDS = 65536;
+  FILE* m_file;
+  std::vector<EventRecord> m_buffer;
+  Time m_start;
+  uint64_t m_records;
+public:
+  EventRecorder () : m_file(0), m_records(0) {}
+
+  ~EventRecorder () {
+    Close();
+  }
+
+  void Open (const std::string& filename) {
+    Close();
+    m_file = std::fopen(filename.c_str(), "wb");
+    NS_ABORT_MSG_UNLESS(m_file, "Cannot write events to " << filename);
+    char header[16];
+    std::memset(header, 0, sizeof(header));
+    std::memcpy(header, "DDCEVT1", 8);
+    uint32_t size = sizeof(EventRecord);
+    std::memcpy(header + 8, &size, sizeof(size));
+    std::fwrite(header, sizeof(header), 1, m_file);
+    m_buffer.reserve(BUFFER_RECORDS);
+    m_start = Simulator::Now();
+    m_records = 0;
+  }
+
+  bool IsOpen () const {
+    return m_file != 0;
+  }
+
+  uint64_t GetNRecords () const {
+    return m_records;
+  }
+
+  void Record (EventType type, uint32_t node, uint32_t src, uint32_t dst, uint32_t seq = 0, uint8_t ttl = 0) {
+    EventRecord record;
+    std::memset(&record, 0, sizeof(record));
+    record.time = (Simulator::Now() - m_start).GetNanoSeconds();
+    record.node = node;
+    record.src = src;
+    record.dst = dst;
+    record.seq = seq;
+    record.type = type;
+    record.ttl = ttl;
+    m_buffer.push_back(record);
+    m_records++;
+    if (m_buffer.size() == BUFFER_RECORDS) {
+      Flush();
+    }
+  }
+
+  void Flush () {
+    if (m_file && !m_buffer.empty()) {
+      std::fwrite(&m_buffer[0], sizeof(EventRecord), m_buffer.size(), m_file);
+    }
+    m_buffer.clear();
+  }
+
+  void Close () {
+    if (!m_file) {
+      return;
+    }
+    Flush();
+    std::fclose(m_file);
+    m_file = 0;
+  }
+};
@@ -0,0 +1,297 @@
+#pragma once
+// Failure scenarios for the DDC drivers, sampled rather than enumerated:
+// pick k links uniformly at random, keep them if failing them leaves the
+// network as connected as it was and cuts the shortest paths of enough node
+// pairs, and turn them into a BatchScenario that fails those links and tests
+// some of those pairs. stretch-test.py and traffic-test.py list every
+// combination of k links instead, which is out of reach past two or three
+// failures on the larger Rocketfuel topologies. Drivers that have already
+// populated global routing pass its DdcDistanceTable in as the distance
+// callback; failure-scenarios has no simulation and counts hops itself.
+#include "ns3/core-module.h"
+#include "ns3/random-variable.h"
+#include "ns3/topology-graph.h"
+#include "batch-scenarios.h"
+#include <algorithm>
+#include <iostream>
+#include <set>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace ns3;
+
+class FailureSampler {
+public:
+  // Distance from one node to another, by graph index, or UNREACHABLE
+  typedef Callback<uint32_t, uint32_t, uint32_t> DistanceCallback;
+  static const uint32_t UNREACHABLE = 0xffffffff;
+
+private:
+  const TopologyGraph& m_graph;
+  uint32_t m_nNodes;
+  // Every pair of neighbours once, lower node first
+  std::vector<std::pair<uint32_t, uint32_t> > m_links;
+  // Links on a spanning forest; failing none of them can't disconnect anything
+  std::vector<bool> m_forest;
+  uint32_t m_components;
+  DistanceCallback m_distance;
+  // Without a distance callback, hop counts between all pairs of nodes, row
+  // major. Every link has metric 1, so these are the distances global
+  // routing fills its DdcDistanceTable with.
+  std::vector<uint16_t> m_distances;
+  UniformVariable m_random;
+  // Link sets drawn so far, so that no scenario is emitted twice
+  std::set<std::vector<uint32_t> > m_drawn;
+  std::vector<uint32_t> m_parent;
+  std::vector<bool> m_failed;
+
+  static const uint16_t NO_PATH = 0xffff;
+
+  uint32_t Find (uint32_t node) {
+    while (m_parent[node] != node) {
+      m_parent[node] = m_parent[m_parent[node]];
+      node = m_parent[node];
+    }
+    return node;
+  }
+
+  void ResetComponents () {
+    for (uint32_t node = 0; node < m_nNodes; node++) {
+      m_parent[node] = node;
+    }
+  }
+
+  uint32_t Distance (uint32_t from, uint32_t to) const {
+    if (!m_distance.IsNull()) {
+      return m_distance(from, to);
+    }
+    uint16_t distance = m_distances[uint64_t(from) * m_nNodes + to];
+    if (distance == NO_PATH) {
+      return UNREACHABLE;
+    }
+    return distance;
+  }
+
+  void ComputeDistances () {
+    const std::vector<uint32_t>& offsets = m_graph.GetOffsets();
+    const std::vector<uint32_t>& neighbours = m_graph.GetNeighbours();
+    NS_ABORT_MSG_IF(m_nNodes >= NO_PATH, "Too many nodes to count hops between: " << m_nNodes);
+    m_distances.assign(uint64_t(m_nNodes) * m_nNodes, uint16_t(NO_PATH));
+    std::vector<uint32_t> queue(m_nNodes);
+    for (uint32_t source = 0; source < m_nNodes; source++) {
+      uint16_t* row = &m_distances[uint64_t(source) * m_nNodes];
+      uint32_t head = 0;
+      uint32_t tail = 0;
+      row[source] = 0;
+      queue[tail++] = source;
+      while (head < tail) {
+        uint32_t node = queue[head++];
+        for (uint32_t slot = offsets[node]; slot < offsets[node + 1]; slot++) {
+          uint32_t next = neighbours[slot];
+          if (row[next] == NO_PATH) {
+            row[next] = row[node] + 1;
+            queue[tail++] = next;
+          }
+        }
+      }
+    }
+  }
+
+  // Floyd's algorithm: every set of k links is equally likely, with k draws
+  void DrawLinks (uint32_t k, std::vector<uint32_t>& links) {
+    std::set<uint32_t> drawn;
+    uint32_t nLinks = m_links.size();
+    for (uint32_t j = nLinks - k; j < nLinks; j++) {
+      uint32_t t = std::min(j, uint32_t(m_random.GetValue(0, j + 1)));
+      if (!drawn.insert(t).second) {
+        drawn.insert(j);
+      }
+    }
+    links.assign(drawn.begin(), drawn.end());
+  }
+
+public:
+  // What happened to the draws so far
+  uint32_t m_nDrawn;
+  uint32_t m_nRepeated;
+  uint32_t m_nDisconnected;
+  uint32_t m_nUncovered;
+
+  // Without a distance callback, the sampler keeps its own distance table,
+  // which takes two bytes per pair of nodes
+  FailureSampler (const TopologyGraph& graph, DistanceCallback distance = DistanceCallback()) :
+    m_graph(graph),
+    m_nNodes(graph.GetNNodes()),
+    m_components(graph.GetNNodes()),
+    m_distance(distance),
+    m_parent(graph.GetNNodes()),
+    m_nDrawn(0),
+    m_nRepeated(0),
+    m_nDisconnected(0),
+    m_nUncovered(0) {
+    const std::vector<uint32_t>& offsets = m_graph.GetOffsets();
+    const std::vector<uint32_t>& neighbours = m_graph.GetNeighbours();
+    std::vector<uint32_t> seen(m_nNodes, TopologyGraph::NO_NODE);
+    ResetComponents();
+    for (uint32_t node = 0; node < m_nNodes; node++) {
+      for (uint32_t slot = offsets[node]; slot < offsets[node + 1]; slot++) {
+        uint32_t next = neighbours[slot];
+        if (next <= node || seen[next] == node) {
+          continue;
+        }
+        seen[next] = node;
+        uint32_t a = Find(node);
+        uint32_t b = Find(next);
+        m_forest.push_back(a != b);
+        if (a != b) {
+          m_parent[a] = b;
+          m_components--;
+        }
+        m_links.push_back(std::make_pair(node, next));
+      }
+    }
+    m_failed.assign(m_links.size(), false);
+    if (m_distance.IsNull()) {
+      ComputeDistances();
+    }
+  }
+
+  uint32_t GetNLinks () const {
+    return m_links.size();
+  }
+
+  // Whether the network has as many components without links as with them
+  bool IsConnected (const std::vector<uint32_t>& links) {
+    bool forest = false;
+    for (uint32_t i = 0; i < links.size(); i++) {
+      forest = forest || m_forest[links[i]];
+      m_failed[links[i]] = true;
+    }
+    uint32_t components = m_nNodes;
+    if (!forest) {
+      components = m_components;
+    }
+    else {
+      // Join components link by link, until there are no more than before
+      ResetComponents();
+      for (uint32_t link = 0; link < m_links.size() && components > m_components; link++) {
+        if (m_failed[link]) {
+          continue;
+        }
+        uint32_t a = Find(m_links[link].first);
+        uint32_t b = Find(m_links[link].second);
+        if (a != b) {
+          m_parent[a] = b;
+          components--;
+        }
+      }
+    }
+    for (uint32_t i = 0; i < links.size(); i++) {
+      m_failed[links[i]] = false;
+    }
+    return components == m_components;
+  }
+
+  // Pairs of nodes, lower node first, with one of links on a shortest path
+  // between them
+  void AffectedPairs (const std::vector<uint32_t>& links, std::vector<std::pair<uint32_t, uint32_t> >& pairs) const {
+    pairs.clear();
+    for (uint32_t source = 0; source < m_nNodes; source++) {
+      for (uint32_t dest = source + 1; dest < m_nNodes; dest++) {
+        uint32_t distance = Distance(source, dest);
+        if (distance == UNREACHABLE) {
+          continue;
+        }
+        for (uint32_t i = 0; i < links.size(); i++) {
+          uint32_t u = m_links[links[i]].first;
+          uint32_t v = m_links[links[i]].second;
+          // In 64 bits, so that UNREACHABLE doesn't wrap around
+          if (uint64_t(Distance(source, u)) + 1 + Distance(v, dest) == distance ||
+              uint64_t(Distance(source, v)) + 1 + Distance(u, dest) == distance) {
+            pairs.push_back(std::make_pair(source, dest));
+            break;
+          }
+        }
+      }
+    }
+  }
+
+  // Draws k links. If failing them keeps the network connected and touches
+  // the shortest paths of at least coverage of all pairs of nodes, fills in
+  // the scenario's links and up to paths of those pairs (all of them for 0)
+  // and returns true
+  bool Sample (uint32_t k, double coverage, uint32_t paths, BatchScenario& scenario) {
+    NS_ABORT_MSG_IF(k == 0 || k > m_links.size(), "Cannot fail " << k << " of " << m_links.size() << " links");
+    m_nDrawn++;
+    std::vector<uint32_t> links;
+    DrawLinks(k, links);
+    if (!m_drawn.insert(links).second) {
+      m_nRepeated++;
+      return false;
+    }
+    if (!IsConnected(links)) {
+      m_nDisconnected++;
+      return false;
+    }
+    std::vector<std::pair<uint32_t, uint32_t> > pairs;
+    AffectedPairs(links, pairs);
+    uint64_t nPairs = uint64_t(m_nNodes) * (m_nNodes - 1) / 2;
+    if (pairs.empty() || pairs.size() < uint64_t(coverage * nPairs)) {
+      m_nUncovered++;
+      return false;
+    }
+    if (paths == 0 || paths > pairs.size()) {
+      paths = pairs.size();
+    }
+    // The first paths entries of a partial shuffle
+    for (uint32_t i = 0; i < paths; i++) {
+      uint32_t j = std::min(uint32_t(pairs.size() - 1), i + uint32_t(m_random.GetValue(0, pairs.size() - i)));
+      std::swap(pairs[i], pairs[j]);
+    }
+
+    std::ostringstream linkList;
+    for (uint32_t i = 0; i < links.size(); i++) {
+      linkList << (i ? "," : "") << m_graph.GetId(m_links[links[i]].first) << "=" << m_graph.GetId(m_links[links[i]].second);
+    }
+    std::ostringstream pathList;
+    for (uint32_t i = 0; i < paths; i++) {
+      pathList << (i ? "," : "") << m_graph.GetId(pairs[i].first) << "=" << m_graph.GetId(pairs[i].second);
+    }
+    scenario.Set("links", linkList.str());
+    scenario.Set("paths", pathList.str());
+    return true;
+  }
+};
+
+// Up to samples scenarios for each failure count from first to last, named
+// f<failures>-<n>, giving up on a failure count after tries draws. Prints
+// S,<failures>,<scenarios>,<draws>,<repeated>,<disconnected>,<uncovered>
+// to stderr for every failure count. Distances come from distance if it is
+// given, as for FailureSampler.
+inline std::vector<BatchScenario> SampleFailureScenarios (const TopologyGraph& graph, uint32_t first, uint32_t last,
+                                                          uint32_t samples, uint32_t tries, double coverage, uint32_t paths,
+                                                          FailureSampler::DistanceCallback distance = FailureSampler::DistanceCallback()) {
+  std::vector<BatchScenario> scenarios;
+  FailureSampler sampler(graph, distance);
+  for (uint32_t k = first; k <= last && k <= sampler.GetNLinks(); k++) {
+    sampler.m_nDrawn = sampler.m_nRepeated = sampler.m_nDisconnected = sampler.m_nUncovered = 0;
+    uint32_t found = 0;
+    while (found < samples && sampler.m_nDrawn < tries) {
+      BatchScenario scenario;
+      if (!sampler.Sample(k, coverage, paths, scenario)) {
+        continue;
+      }
+      std::ostringstream name;
+      name << "f" << k << "-" << found;
+      scenario.m_name = name.str();
+      scenario.Set("name", scenario.m_name);
+      scenarios.push_back(scenario);
+      found++;
+    }
+    std::cerr << "S," << k << "," << found << "," << sampler.m_nDrawn << "," << sampler.m_nRepeated << ","
+              << sampler.m_nDisconnected << "," << sampler.m_nUncovered << std::endl;
+  }
+  return scenarios;
+}
@@ -0,0 +1,83 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// Sample failure scenarios for a topology and write them out in the batch
+// scenario format, for any of the drivers' --batch option. For every number
+// of failures from --failures to --maxFailures, draws sets of links until
+// --samples of them keep the network connected and sit on the shortest
+// paths of at least --coverage of all pairs of nodes, and writes each as
+//   name=f<failures>-<n> links=<a>=<b>,... paths=<s>=<d>,... <options>
+// testing --samplePaths of those pairs. The draws come from the ns-3 random number
+// generator, so --RngRun picks a different set of scenarios.
+
+#include "ns3/core-module.h"
+#include "ns3/topology-read-module.h"
+#include "failure-sampler.h"
+#include <fstream>
+#include <iostream>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("DDC-FAILURE-SCENARIOS");
+
+int
+main (int argc, char *argv[])
+{
+  std::string topology;
+  std::string output;
+  std::string options;
+  uint32_t failures = 1;
+  uint32_t maxFailures = 0;
+  uint32_t samples = 10;
+  uint32_t tries = 0;
+  uint32_t samplePaths = 10;
+  double coverage = 0.025;
+  CommandLine cmd;
+  cmd.AddValue("topology", "Topology file", topology);
+  cmd.AddValue("output", "Write the scenarios to this file instead of stdout", output);
+  cmd.AddValue("options", "Options to add to every scenario, e.g. \"packets=10 delay=0.5\"", options);
+  cmd.AddValue("failures", "Number of links to fail", failures);
+  cmd.AddValue("maxFailures", "Also sample every number of failures up to this one", maxFailures);
+  cmd.AddValue("samples", "Scenarios to find for each number of failures", samples);
+  cmd.AddValue("tries", "Draws to give up after for each number of failures (0 for 100 per sample)", tries);
+  cmd.AddValue("samplePaths", "Source destination pairs to test per scenario (0 for every affected pair)", samplePaths);
+  cmd.AddValue("coverage", "Fraction of all pairs the failures must be on a shortest path of", coverage);
+  cmd.Parse(argc, argv);
+
+  Ptr<EdgeListTopologyReader> reader = CreateObject<EdgeListTopologyReader> ();
+  reader->SetFileName(topology);
+  NS_ABORT_MSG_UNLESS(reader->ReadGraph(), "Cannot read topology " << topology);
+  std::vector<BatchScenario> scenarios = SampleFailureScenarios(reader->GetGraph(), failures, std::max(failures, maxFailures),
+                                                                samples, tries ? tries : 100 * samples, coverage, samplePaths);
+
+  std::ofstream file;
+  if (!output.empty()) {
+    file.open(output.c_str());
+    NS_ABORT_MSG_UNLESS(file.is_open(), "Cannot write scenarios to " << output);
+  }
+  std::ostream& out = output.empty() ? std::cout : file;
+  for (std::vector<BatchScenario>::iterator it = scenarios.begin(); it != scenarios.end(); it++) {
+    std::istringstream extra(options);
+    std::string option;
+    while (extra >> option) {
+      size_t split = option.find('=');
+      NS_ABORT_MSG_IF(split == std::string::npos, "Scenario option " << option << " is not key=value");
+      it->Set(option.substr(0, split), option.substr(split + 1));
+    }
+    WriteBatchScenario(out, *it);
+  }
+  return 0;
+}
@@ -18,6 +18,7 @@
 #include "ns3/network-module.h"
 #include "ns3/internet-module.h"
 #include "ns3/point-to-point-module.h"
+#include "ns3/topology-read-module.h"
 #include "ns3/applications-module.h"
 #include "ns3/random-variable.h"
 #include "ns3/ipv4-l3-protocol.h"
@@ -39,36 +40,35 @@
 #include <utility>
 #include <functional>
 #include "stretch-classes.h"
+#include "batch-scenarios.h"
+#include "event-recorder.h"
+#include "schedule-source.h"
 
 using namespace ns3;
 
 NS_LOG_COMPONENT_DEFINE ("DDC-NSDI-PARTITION-AGGREGATE-TEST");
 static const uint32_t PORT = 22;
 
-class Topology : public Object
+class Topology : public Object, public BatchTopology
 {
   protected:
     std::map<uint32_t, PartitionAggregateClient*> m_partClients;
-    std::vector<PointToPointChannel* > m_channels;
     UniformVariable randVar;
     uint32_t m_numNodes;
-    std::vector<std::list<uint32_t>*> m_connectivityGraph;
-    Time m_simulationEnd;
+    TopologyGraph m_graph;
+    PointToPointTopologyHelper m_links;
     std::vector<uint32_t> m_hosts;
-    std::vector<uint32_t> m_nodeTranslate;
-    std::map<std::pair<uint32_t, uint32_t>, PointToPointChannel*> m_channelMap;
-    std::map<uint32_t, uint32_t> m_nodeForwardTranslationMap;
-    std::map<Ipv4Address, uint32_t> m_addressToNodeMap; 
     NodeContainer m_nodes;
-    std::vector<NetDeviceContainer> m_nodeDevices;
-    std::vector<NetDeviceContainer> m_linkDevices;
     std::vector<NodeCallback> m_callbacks;
     std::vector<std::pair<uint32_t, std::list<uint32_t> > > m_pathsToTest;
     uint32_t m_currentPath;
     uint32_t m_currentTrial;
-    double m_delay;
     double m_linkLatency;
+    EventRecorder m_events;
     bool m_repair;
+    uint32_t m_requests;
+    ScheduleSource<Topology> m_schedule;
+    Time m_scheduleWindow;
   public:
     void SetRepair (bool repair)
     {
@@ -87,27 +87,31 @@ class Topology : public Object
     void ReceivePacketCallback (Ptr<const Packet> packet, const Address& addr)
     {
       Ipv4Address ipAddr = InetSocketAddress::ConvertFrom(addr).GetIpv4();
-      std::cout << m_addressToNodeMap[ipAddr] << ",RX," << Simulator::Now().ToDouble(Time::US) << "," << packet->GetSize() << std::endl;
+      if (m_events.IsOpen()) {
+        m_events.Record(EVENT_TCP_RX, m_links.GetAddressNode(ipAddr), m_links.GetAddressNode(ipAddr), 0, packet->GetSize());
+        return;
+      }
+      std::cout << m_links.GetAddressNode(ipAddr) << ",RX," << ScenarioTime().ToDouble(Time::US) << "," << packet->GetSize() << std::endl;
     }
 
     inline uint32_t CannonicalNode (const uint32_t node) 
     {
-      return m_nodeTranslate[node];
+      return m_graph.GetId(node);
     }
 
-    inline uint32_t PhysicalNode (const uint32_t node)
+    EventRecorder& Events ()
     {
-      return m_nodeForwardTranslationMap[node];
+      return m_events;
     }
 
-    inline uint32_t AddressForNode (const Ipv4Address address) 
+    inline uint32_t PhysicalNode (const uint32_t node)
     {
-      return m_addressToNodeMap[address];
+      return m_graph.GetNode(node);
     }
 
-    void SetDelay(double delay)
+    inline uint32_t AddressForNode (const Ipv4Address address) 
     {
-      m_delay = delay;
+      return m_links.GetAddressNode(address);
     }
 
     void RouteEnded ()
@@ -117,140 +121,51 @@ class Topology : public Object
       m_currentTrial++;
     }
     
-    Topology()
+    Topology() :
+      BatchTopology(Seconds(60.0 * 60.0 * 24 * 100), Time::NS)
     {
       m_numNodes = 0;
       m_currentPath = 0;
       m_currentTrial = 0;
-      m_simulationEnd = Seconds(60.0 * 60.0 * 24 * 100);
+      m_scheduleWindow = Seconds(1.0);
       m_linkLatency = 10.0;
       m_repair = true;
    }
    
-    virtual ~Topology()
-    {
-        for (uint32_t i = 0; i < m_numNodes; i++) {
-            delete m_connectivityGraph[i];
-        }
-    }
-    
-    void PopulateGraph (const std::string& filename)
+    void PopulateGraph (const std::string& filename, const std::string& hostFile)
     {
-      std::map<uint32_t, std::list<uint32_t>*> tempConnectivityGraph;
       NS_LOG_INFO("Entering PopulateGraph with file " << filename);
-      std::ifstream topology(filename.c_str());
-      NS_ASSERT(topology.is_open());
-      //boost::split(linkParts, links, boost::is_any_of(","));
-      while (topology.good()) {
-        std::string input;
-        getline(topology, input);
-        std::vector<std::string> topoParts;
-        boost::split(topoParts, input, boost::is_any_of(" "));
-        if (topoParts.size() < 2) {
-          continue;
-        }
-        uint32_t node1 = std::atoi(topoParts[0].c_str());
-        uint32_t node2 = std::atoi(topoParts[1].c_str());
-        bool isHost = topoParts.size() > 2 && (topoParts[2].compare("h") == 0);
-        if (!tempConnectivityGraph[node1]) {
-          tempConnectivityGraph[node1] = new std::list<uint32_t>;
-        }
-        if (!tempConnectivityGraph[node2]) {
-          tempConnectivityGraph[node2] = new std::list<uint32_t>;
-        }
-        tempConnectivityGraph[node1]->push_back(node2);
-        tempConnectivityGraph[node2]->push_back(node1);
-        if (isHost) {
-          m_hosts.push_back(node2);
-        }
-      }
-
-      m_numNodes = tempConnectivityGraph.size();
-      uint32_t last = 0;
-      m_connectivityGraph.resize(m_numNodes);
-    
-      for (std::map<uint32_t, std::list<uint32_t>*>::iterator it = tempConnectivityGraph.begin();
-          it != tempConnectivityGraph.end();
-          it++) {
-          m_nodeTranslate.push_back(it->first);
-          m_nodeForwardTranslationMap[it->first] = last;
-          NS_LOG_LOGIC("TRANSLATION: " << it->first << " = " << last);
-          last++;
-      }
-      for (uint32_t i = 0; i < m_numNodes; i++) {
-        m_connectivityGraph[i] = new std::list<uint32_t>;
-        for (std::list<uint32_t>::iterator it = tempConnectivityGraph[m_nodeTranslate[i]]->begin();
-             it != tempConnectivityGraph[m_nodeTranslate[i]]->end();
-             it++) {
-          m_connectivityGraph[i]->push_back(m_nodeForwardTranslationMap[*it]);
-        }
-        NS_ASSERT_MSG(!m_connectivityGraph[i]->empty(), "Empty for " << i);
-      }
+      Ptr<EdgeListTopologyReader> reader = CreateObject<EdgeListTopologyReader> ();
+      reader->SetFileName(filename);
+      reader->SetAttribute("HostFileName", StringValue(hostFile));
+      NS_ABORT_MSG_UNLESS(reader->ReadGraph(), "Cannot read topology " << filename);
+      m_graph = reader->GetGraph();
+      m_hosts = reader->GetHosts();
+      m_numNodes = m_graph.GetNNodes();
     }
 
     void HookupSimulation()
     {
-      NS_LOG_INFO("Creating nodes");
-      m_nodes.Create (m_numNodes);
-      m_nodeDevices.resize(m_numNodes);
-      NS_LOG_INFO("Creating point to point connections");
-      PointToPointHelper pointToPoint;
-      pointToPoint.SetDeviceAttribute ("DataRate", StringValue ("10Gbps"));
+      NS_LOG_INFO("Creating nodes and point to point connections");
+      m_links.SetDeviceAttribute ("DataRate", StringValue ("10Gbps"));
       std::cout << "Latency = " << Time::FromDouble(m_linkLatency, Time::MS).GetMicroSeconds() << " us" << std::endl;
-      pointToPoint.SetChannelAttribute("Delay", TimeValue(Time::FromDouble(m_linkLatency, Time::MS))); 
+      m_links.SetChannelAttribute("Delay", TimeValue(Time::FromDouble(m_linkLatency, Time::MS)));
+      m_nodes = m_links.Install(m_graph);
+      NS_LOG_INFO("Built " << m_numNodes << " nodes and " << m_links.GetNLinks() << " links in "
+                  << m_links.GetInstallTime() << " ms");
       Config::SetDefault ("ns3::RttEstimator::MinRTO", TimeValue(MilliSeconds(11)));
+      // The traces are bound to the callbacks by address, so the vector
+      // must not reallocate while they are added
+      m_callbacks.reserve(m_numNodes);
       for (uint32_t i = 0; i < m_numNodes; i++) {
-        m_callbacks.push_back(NodeCallback(m_nodeTranslate[i], this));
-        NS_ASSERT(!m_connectivityGraph[i]->empty());
-        for ( std::list<uint32_t>::iterator iterator = m_connectivityGraph[i]->begin(); 
-        iterator != m_connectivityGraph[i]->end();
-        iterator++) {
-          if (*iterator < i) {
-            continue;
-          }
-          pointToPoint.SetDeviceAttribute ("DataRate", DataRateValue(DataRate("10Gbps")));
-          pointToPoint.SetChannelAttribute("Delay", TimeValue(Time::FromDouble(m_linkLatency, Time::MS))); 
-          NetDeviceContainer p2pDevices = 
-            pointToPoint.Install (m_nodes.Get(i), m_nodes.Get(*iterator));
-          m_nodeDevices[i].Add(p2pDevices.Get(0));
-          p2pDevices.Get(0)->TraceConnectWithoutContext("MacTxDrop", MakeCallback(&NodeCallback::PhyDropTrace, &m_callbacks[i]));
-          m_nodeDevices[*iterator].Add(p2pDevices.Get(1));
-          p2pDevices.Get(1)->TraceConnectWithoutContext("MacTxDrop", MakeCallback(&NodeCallback::PhyDropTrace, &m_callbacks[*iterator]));
-          m_linkDevices.push_back(p2pDevices);
-          PointToPointChannel* channel = (PointToPointChannel*)GetPointer(p2pDevices.Get(0)->GetChannel());
-          m_channels.push_back(channel);
-          std::pair<uint32_t, uint32_t> normalizedLink;
-          if (m_nodeTranslate[i] < m_nodeTranslate[*iterator]) {
-            normalizedLink = std::pair<uint32_t, uint32_t>(m_nodeTranslate[i], m_nodeTranslate[*iterator]);
-          }
-          else {
-            normalizedLink = std::pair<uint32_t, uint32_t>(m_nodeTranslate[i], m_nodeTranslate[*iterator]);
-          }
-          m_channelMap[normalizedLink] = channel;
-        }
-      }
-
-      InternetStackHelper stack;
-      stack.Install (m_nodes);
-      Ipv4AddressHelper address;
-      address.SetBase ("10.1.1.0", "255.255.255.0");
-      NS_LOG_INFO("Assigning address");
-      for (int i = 0; i < (int)m_linkDevices.size(); i++) {
-        Ipv4InterfaceContainer current = address.Assign(m_linkDevices[i]);
-        address.NewNetwork();
+        m_callbacks.push_back(NodeCallback(m_graph.GetId(i), this));
       }
-      NS_LOG_INFO("Assigned addresses");
-
-      for (NodeList::Iterator it = NodeList::Begin(); it != NodeList::End(); it++) {
-        Ptr<Node> node = *it;
-        Ptr<Ipv4> ipv4 = node->GetObject<Ipv4>();
-        for (uint32_t i = 1; i < ipv4->GetNInterfaces (); i++) {
-          for (uint32_t j = 0; j < ipv4->GetNAddresses (i); j++) {
-            m_addressToNodeMap[ipv4->GetAddress(i, j).GetLocal ()] = node->GetId(); 
-          }
+      for (uint32_t link = 0; link < m_links.GetNLinks(); link++) {
+        for (uint32_t side = 0; side < 2; side++) {
+          m_links.GetLinkDevice(link, side)->TraceConnectWithoutContext("MacTxDrop",
+              MakeCallback(&NodeCallback::PhyDropTrace, &m_callbacks[m_links.GetLinkNode(link, side)]));
         }
       }
-      NS_LOG_INFO("Added addresses");
 
       Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
 
@@ -261,8 +176,7 @@ class Topology : public Object
       for (uint32_t i = 0; i < m_numNodes; i++) {
         Ptr<GlobalRouter> router = m_nodes.Get(i)->GetObject<GlobalRouter>();
         Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol();
-        gr->SetAttribute("ReverseOutputToInputDelay", TimeValue(Time::FromDouble(m_delay * 1e-6, Time::MS)));
-        gr->SetAttribute("ReverseInputToOutputDelay", TimeValue(Time::FromDouble(m_delay * 1e-6, Time::MS)));
+        SetRepairDelay(gr);
         gr->SetAttribute("AllowReversal", BooleanValue(m_repair));
         Ptr<Ipv4L3Protocol> l3 = m_nodes.Get(i)->GetObject<Ipv4L3Protocol>();
         l3->TraceConnectWithoutContext("Drop", MakeCallback(&NodeCallback::DropTrace, &m_callbacks[i]));
@@ -276,9 +190,11 @@ class Topology : public Object
         ApplicationContainer paclient = paclientHelp.Install(m_nodes.Get(PhysicalNode(*it)));
         ApplicationContainer sink = sinkHelp.Install(m_nodes.Get(PhysicalNode(*it)));
         paclient.Start(Seconds(0.0));
-        paclient.Stop(m_simulationEnd);
         paserver.Start(Seconds(0.0));
-        paclient.Stop(m_simulationEnd);
+        if (!m_simulationEnd.IsZero()) {
+          paclient.Stop(m_simulationEnd);
+          paserver.Stop(m_simulationEnd);
+        }
         m_partClients[*it] = (PartitionAggregateClient*)PeekPointer(paclient.Get(0));
       }
 
@@ -290,6 +206,14 @@ class Topology : public Object
       SimulationSingleton<GlobalRouteManagerImpl>::Get ()->SendHeartbeats();
     }
     
+    // The link between two nodes, named as in the topology file
+    uint32_t GetLink(std::pair<uint32_t, uint32_t> key)
+    {
+      uint32_t link = m_links.GetLink(m_graph.GetNode(key.first), m_graph.GetNode(key.second));
+      NS_ABORT_MSG_IF(link == PointToPointTopologyHelper::NO_LINK, "No link between " << key.first << " and " << key.second);
+      return link;
+    }
+
     void FailLink (uint32_t from, uint32_t to)
     {
       NS_ASSERT(from < to);
@@ -300,52 +224,72 @@ class Topology : public Object
     void FailLinkPair(std::pair<uint32_t, uint32_t> key)
     {
       NS_LOG_LOGIC("Failing link between " << key.first << " and " << key.second);
-      std::cout << key.first << "," << key.second << ",F" << std::endl;
-      m_channelMap[key]->SetLinkDown();
+      if (m_events.IsOpen()) {
+        m_events.Record(EVENT_FAIL, key.first, key.first, key.second);
+      }
+      else {
+        std::cout << key.first << "," << key.second << ",F" << std::endl;
+      }
+      m_links.GetLinkChannel(GetLink(key))->SetLinkDown();
+    }
+
+    void SetScheduleWindow (double window)
+    {
+      m_scheduleWindow = Seconds(window);
     }
 
+    // The schedule is read a window at a time as the simulation runs
     void ScheduleEvents (std::string schedule)
     {
-      std::ifstream scheduleFile(schedule.c_str());
-      NS_ASSERT(scheduleFile.is_open());
-      //boost::split(linkParts, links, boost::is_any_of(","));
-      uint32_t req = 0;
-      while (scheduleFile.good()) {
-        std::string input;
-        getline(scheduleFile, input);
-        if (input.empty()) {
-          continue;
-        }
-        std::vector<std::string> parts;
-        boost::split(parts, input, boost::is_any_of(" "));
-        double time = (double)std::atof(parts[0].c_str());
-        bool query = (parts[1].compare("q") == 0);
-        bool linkfail = (parts[1].compare("f") == 0);
-        if (query) {
-          uint32_t client = std::atoi(parts[2].c_str());
-          Ptr<Request> request = Create<Request> ();
-          request->client = client;
-          request->requestNumber = req;
-          request->issueTime = Seconds(time);
-          req++;
-          for (uint32_t it2 = 3; it2 < parts.size(); it2++) {
-            uint32_t serverIndex = std::atoi(parts[it2].c_str());
-            Ipv4Address server = m_nodes.Get(m_nodeForwardTranslationMap[serverIndex])->GetObject<Ipv4>()->GetAddress(1, 0).GetLocal();
-            request->addresses.push_back(InetSocketAddress(server, 5000));
-            request->nodes[InetSocketAddress(server, 5000)] = serverIndex;
-          }
-          Simulator::Schedule(Seconds(time), &PartitionAggregateClient::IssueRequest, m_partClients[client], request);
+      m_requests = 0;
+      m_schedule.Open(schedule, m_scheduleWindow, this, &Topology::ScheduleLine);
+      std::cout << "Done scheduling" << std::endl;
+    }
+
+    void ScheduleLine (const std::string& input, Time delay)
+    {
+      std::vector<std::string> parts;
+      boost::split(parts, input, boost::is_any_of(" "));
+      double time = (double)std::atof(parts[0].c_str());
+      bool query = (parts[1].compare("q") == 0);
+      bool linkfail = (parts[1].compare("f") == 0);
+      if (query) {
+        uint32_t client = std::atoi(parts[2].c_str());
+        Ptr<Request> request = Create<Request> ();
+        request->client = client;
+        request->requestNumber = m_requests;
+        request->issueTime = Seconds(time);
+        m_requests++;
+        for (uint32_t it2 = 3; it2 < parts.size(); it2++) {
+          uint32_t serverIndex = std::atoi(parts[it2].c_str());
+          Ipv4Address server = m_nodes.Get(m_graph.GetNode(serverIndex))->GetObject<Ipv4>()->GetAddress(1, 0).GetLocal();
+          request->addresses.push_back(InetSocketAddress(server, 5000));
+          request->nodes[InetSocketAddress(server, 5000)] = serverIndex;
         }
-        else if (linkfail) {
-          for (uint32_t it3 = 2; it3 < parts.size(); it3++) {
-            std::vector<std::string> nodeParts;
-            boost::split(nodeParts, parts[it3], boost::is_any_of("="));
-            NS_ASSERT(nodeParts.size() == 2);
-            Simulator::Schedule(Seconds(time), &Topology::FailLink, this, std::atoi(nodeParts[0].c_str()), std::atoi(nodeParts[1].c_str()));
-          }
+        Simulator::Schedule(delay, &PartitionAggregateClient::IssueRequest, m_partClients[client], request);
+      }
+      else if (linkfail) {
+        for (uint32_t it3 = 2; it3 < parts.size(); it3++) {
+          std::vector<std::string> nodeParts;
+          boost::split(nodeParts, parts[it3], boost::is_any_of("="));
+          NS_ASSERT(nodeParts.size() == 2);
+          Simulator::Schedule(delay, &Topology::FailLink, this, std::atoi(nodeParts[0].c_str()), std::atoi(nodeParts[1].c_str()));
         }
       }
-      std::cout << "Done scheduling" << std::endl;
+    }
+
+    void StartScenario(const BatchScenario& scenario)
+    {
+      BeginScenario(scenario, m_nodes);
+      if (scenario.Has("events")) {
+        m_events.Open(scenario.Get("events"));
+      }
+      ScheduleEvents(scenario.Get("schedule"));
+    }
+
+    void EndScenario()
+    {
+      m_events.Close();
     }
 };
 
@@ -354,6 +298,10 @@ void NodeCallback::RxPacket (Ptr<const Packet> packet, Ipv4Header& header) {
   NS_LOG_LOGIC(m_id << " Received packet " << (uint32_t)header.GetTtl());
   uint32_t seq = 0;
   packet->CopyData ((uint8_t*)&seq, sizeof(seq));
+  if (m_topology->Events().IsOpen()) {
+    m_topology->Events().Record(EVENT_RX, m_id, m_topology->CannonicalNode(m_topology->AddressForNode(header.GetSource())), m_id, seq, header.GetTtl());
+    return;
+  }
   std::cout << m_topology->CannonicalNode(m_topology->AddressForNode(header.GetSource()))
             <<"," << m_id << ","<< seq << std::endl;
 }
@@ -362,6 +310,10 @@ void NodeCallback::ServerRxPacket (Ptr<const Packet> packet, Ipv4Header& header)
   NS_LOG_LOGIC(m_id << " Server Received packet " << (uint32_t)header.GetTtl());
   uint32_t seq = 0;
   packet->CopyData ((uint8_t*)&seq, sizeof(seq));
+  if (m_topology->Events().IsOpen()) {
+    m_topology->Events().Record(EVENT_SERVER_RX, m_id, m_topology->CannonicalNode(m_topology->AddressForNode(header.GetSource())), m_id, seq, header.GetTtl());
+    return;
+  }
   std::cout << m_topology->CannonicalNode(m_topology->AddressForNode(header.GetSource()))
             <<"," << m_id << ","<< seq << std::endl;
   //std::cout << seq << ",";
@@ -369,33 +321,33 @@ void NodeCallback::ServerRxPacket (Ptr<const Packet> packet, Ipv4Header& header)
 
 void NodeCallback::NodeReversal (uint32_t iface, Ipv4Address addr) {
   NS_LOG_LOGIC(m_id << " reversed iface " << iface << " for " << addr);
+  if (m_topology->Events().IsOpen()) {
+    m_topology->Events().Record(EVENT_REVERSAL, m_id, m_id, m_topology->CannonicalNode(m_topology->AddressForNode(addr)), iface);
+    return;
+  }
   std::cout << m_id << ",R (" << addr << ")" << std::endl;
 }
 
 void NodeCallback::DropTrace (const Ipv4Header& hdr, Ptr<const Packet> packet, Ipv4L3Protocol::DropReason drop, Ptr<Ipv4> ipv4, uint32_t iface) {
   NS_LOG_LOGIC(m_id << " dropped packet " << iface);
+  if (m_topology->Events().IsOpen()) {
+    m_topology->Events().Record(EVENT_DROP, m_id,
+                                m_topology->CannonicalNode(m_topology->AddressForNode(hdr.GetSource())),
+                                m_topology->CannonicalNode(m_topology->AddressForNode(hdr.GetDestination())),
+                                0, hdr.GetTtl());
+    return;
+  }
   std::cout << m_topology->CannonicalNode(m_topology->AddressForNode(hdr.GetSource()))
             << "," << m_topology->CannonicalNode(m_topology->AddressForNode(hdr.GetDestination()))
             << ",D (" << (uint32_t)hdr.GetTtl() << ")" << std::endl;
 }
 
 void NodeCallback::PhyDropTrace (Ptr<const Packet> packet) {
-  std::cout << m_id << ",P" << std::endl;
-}
-
-void
-ParseLinks(std::string links, std::vector<std::pair<uint32_t, uint32_t> >& results)
-{
-  std::vector<std::string> linkParts;
-  
-  boost::split(linkParts, links, boost::is_any_of(","));
-  for (std::vector<std::string>::iterator it = linkParts.begin(); 
-       it != linkParts.end(); it++) {
-    std::vector<std::string> nodeParts;
-    boost::split(nodeParts, *it, boost::is_any_of("="));
-    NS_ASSERT(nodeParts.size() == 2);
-    results.push_back(std::pair<uint32_t, uint32_t>(std::atoi(nodeParts[0].c_str()), std::atoi(nodeParts[1].c_str())));
+  if (m_topology->Events().IsOpen()) {
+    m_topology->Events().Record(EVENT_PHY_DROP, m_id, m_id, m_id);
+    return;
   }
+  std::cout << m_id << ",P" << std::endl;
 }
 
 void
@@ -423,26 +375,53 @@ main (int argc, char *argv[])
 
   Ptr<OutputStreamWrapper> stream = asciiHelper.CreateFileStream ("tcp-trace.tr");
   std::string topology;
+  std::string hosts;
   double delay = 0.0;
   double linkLatency = 0.5;
   std::string schedule;
+  double window = 1.0;
   bool repair;
+  std::string batch;
+  std::string output;
+  std::string events;
+  uint32_t jobs = 1;
   CommandLine cmd;
   cmd.AddValue("topology", "Topology file", topology);
+  cmd.AddValue("hosts", "End host list (an .es file), besides the hosts marked in the topology", hosts);
   cmd.AddValue("delay", "Delay for repairs", delay);
   cmd.AddValue("latency", "Propagation delay (ms)", linkLatency);
   cmd.AddValue("schedule", "Simulation schedule", schedule);
+  cmd.AddValue("window", "Seconds of the schedule to read ahead of the simulation", window);
   cmd.AddValue("repair", "Allow reversals", repair);
+  cmd.AddValue("batch", "Run every scenario (schedule, delay, events) in this file", batch);
+  cmd.AddValue("output", "Write each batch scenario's results to <output>/<scenario>.txt", output);
+  cmd.AddValue("events", "Record per packet events to this binary file instead of printing them", events);
+  cmd.AddValue("jobs", "Batch scenarios to run at once in forked processes (0 for one per core)", jobs);
   cmd.Parse(argc, argv);
   std::cerr << "Repair  = " << repair <<std::endl;
   Topology simulationTopology;
   simulationTopology.SetRepair(repair);
   simulationTopology.SetDelay(delay);
   simulationTopology.SetPropagationDelay(linkLatency);
-  simulationTopology.PopulateGraph(topology);
+  simulationTopology.SetScheduleWindow(window);
+  if (!batch.empty()) {
+    simulationTopology.SetSimulationEnd(Seconds(0));
+  }
+  simulationTopology.PopulateGraph(topology, hosts);
   simulationTopology.HookupSimulation();
-  simulationTopology.ScheduleEvents(schedule);
+  if (!batch.empty()) {
+    RunBatchScenarios(simulationTopology, batch, output, jobs);
+    Simulator::Destroy ();
+    return 0;
+  }
+  BatchScenario scenario;
+  scenario.Set("schedule", schedule);
+  if (!events.empty()) {
+    scenario.Set("events", events);
+  }
+  simulationTopology.StartScenario(scenario);
   Simulator::Run ();
+  simulationTopology.EndScenario();
   Simulator::Destroy ();
 
   return 0;
@@ -0,0 +1,81 @@
+#pragma once
+// Streams an experiment schedule (create-query-schedule.py,
+// create-wan-schedule.py output) into the simulator. Each line starts with
+// its time in seconds, relative to when the source is opened. Rather than
+// scheduling every line before the simulation starts, only the lines due
+// within the next window are read and handed to the driver, and an event
+// reads the following window just before it is due, so the pending event
+// set holds one window of the schedule at a time. Lines must be sorted by
+// time, at least to within a window.
+#include "ns3/core-module.h"
+#include <cstdlib>
+#include <fstream>
+#include <string>
+
+using namespace ns3;
+
+template <class T>
+class ScheduleSource {
+public:
+  // Called with the line and the delay from now at which it is due
+  typedef void (T::*Handler) (const std::string& line, Time delay);
+
+  ScheduleSource () : m_target(0), m_handler(0), m_hasNext(false), m_lines(0) {}
+
+  void Open (const std::string& filename, Time window, T* target, Handler handler) {
+    Simulator::Cancel(m_fill);
+    m_file.close();
+    m_file.clear();
+    m_file.open(filename.c_str());
+    NS_ABORT_MSG_UNLESS(m_file.is_open(), "Cannot open schedule " << filename);
+    m_window = window;
+    m_target = target;
+    m_handler = handler;
+    m_start = Simulator::Now();
+    m_lines = 0;
+    ReadNext();
+    Fill();
+  }
+
+  // Lines handed to the driver so far
+  uint64_t GetNLines () const {
+    return m_lines;
+  }
+
+private:
+  void ReadNext () {
+    m_hasNext = false;
+    while (getline(m_file, m_next)) {
+      if (m_next.empty()) {
+        continue;
+      }
+      m_nextDue = m_start + Seconds(std::atof(m_next.c_str()));
+      m_hasNext = true;
+      return;
+    }
+  }
+
+  void Fill () {
+    Time horizon = Simulator::Now() + m_window;
+    while (m_hasNext && m_nextDue <= horizon) {
+      NS_ABORT_MSG_IF(m_nextDue < Simulator::Now(), "Schedule line \"" << m_next << "\" is out of order");
+      (m_target->*m_handler)(m_next, m_nextDue - Simulator::Now());
+      m_lines++;
+      ReadNext();
+    }
+    if (m_hasNext) {
+      m_fill = Simulator::Schedule(m_nextDue - m_window - Simulator::Now(), &ScheduleSource<T>::Fill, this);
+    }
+  }
+
+  std::ifstream m_file;
+  T* m_target;
+  Handler m_handler;
+  Time m_window;
+  Time m_start;
+  std::string m_next;
+  Time m_nextDue;
+  bool m_hasNext;
+  uint64_t m_lines;
+  EventId m_fill;
+};
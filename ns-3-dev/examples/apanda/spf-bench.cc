@@ -0,0 +1,102 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// Time how long populating the global routes (an SPF from every router)
+// takes for every topology in a directory, or for a single topology file.
+// Prints T,<file>,<nodes>,<links>,<SPF wall clock ms>,<build wall clock ms>
+// for every topology, the latter being the time to create the nodes, links
+// and addresses.
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/point-to-point-module.h"
+#include "ns3/topology-read-module.h"
+#include "ns3/system-path.h"
+#include "ns3/system-wall-clock-ms.h"
+#include <list>
+#include <iostream>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("DDC-SPF-BENCH");
+
+void PopulateGraph(const std::string& filename, TopologyGraph &graph)
+{
+  NS_LOG_INFO("Entering PopulateGraph with file " << filename);
+  Ptr<EdgeListTopologyReader> reader = CreateObject<EdgeListTopologyReader> ();
+  reader->SetFileName(filename);
+  NS_ABORT_MSG_UNLESS(reader->ReadGraph(), "Cannot read topology " << filename);
+  graph = reader->GetGraph();
+}
+
+// Edge lists in topos/ are .bb (Rocketfuel backbones) and .topo (data
+// centers); the .we and .es files describe the same graphs
+bool IsTopology(const std::string& filename)
+{
+  const char *suffixes[] = {".bb", ".bb.new", ".topo"};
+  for (uint32_t i = 0; i < sizeof(suffixes) / sizeof(suffixes[0]); i++) {
+    std::string suffix(suffixes[i]);
+    if (filename.size() > suffix.size() &&
+        filename.compare(filename.size() - suffix.size(), suffix.size(), suffix) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void RunTopology(const std::string& filename)
+{
+  TopologyGraph graph;
+  PopulateGraph(filename, graph);
+  PointToPointTopologyHelper links;
+  links.SetDeviceAttribute ("DataRate", StringValue ("10Gbps"));
+  links.SetChannelAttribute ("Delay", StringValue ("1ms"));
+  NodeContainer nodes = links.Install(graph);
+  SystemWallClockMs clock;
+  clock.Start();
+  Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
+  int64_t spf = clock.End();
+  std::cout << "T," << filename << "," << nodes.GetN() << "," << links.GetNLinks() << "," << spf
+            << "," << links.GetInstallTime() << std::endl;
+  // Drop the heartbeats InitializeRoutes scheduled along with the nodes, so
+  // the next topology starts from an empty node list
+  Simulator::Destroy ();
+}
+
+int
+main (int argc, char *argv[])
+{
+  std::string topology;
+  std::string directory = "../topos";
+  CommandLine cmd;
+  cmd.AddValue("topology", "Time this topology file only", topology);
+  cmd.AddValue("directory", "Time every topology file in this directory", directory);
+  cmd.Parse(argc, argv);
+
+  if (!topology.empty()) {
+    RunTopology(topology);
+    return 0;
+  }
+  std::list<std::string> files = SystemPath::ReadFiles(directory);
+  files.sort();
+  for (std::list<std::string>::iterator it = files.begin(); it != files.end(); it++) {
+    if (IsTopology(*it)) {
+      RunTopology(SystemPath::Append(directory, *it));
+    }
+  }
+  return 0;
+}
@@ -18,11 +18,11 @@
 #include "ns3/network-module.h"
 #include "ns3/internet-module.h"
 #include "ns3/point-to-point-module.h"
+#include "ns3/topology-read-module.h"
 #include "ns3/applications-module.h"
 #include "ns3/random-variable.h"
 #include "ns3/ipv4-l3-protocol.h"
 #include "ns3/global-route-manager-impl.h"
-#include "boost/algorithm/string.hpp"
 #include <list>
 #include <vector>
 #include <stack>
@@ -36,33 +36,35 @@
 #include <utility>
 #include <functional>
 #include "stretch-classes.h"
+#include "batch-scenarios.h"
+#include "failure-sampler.h"
 
 using namespace ns3;
 
 NS_LOG_COMPONENT_DEFINE ("DDC-NSDI-STRETCH");
-class Topology : public Object
+
+class Topology : public Object, public BatchTopology
 {
   protected:
     std::vector<UdpEchoClient*> m_clients;
     std::vector<UdpEchoServer*> m_servers;
-    std::vector<PointToPointChannel* > m_channels;
     UniformVariable randVar;
     uint32_t m_numNodes;
-    std::vector<std::list<uint32_t>*> m_connectivityGraph;
-    Time m_simulationEnd;
-    std::vector<uint32_t> m_nodeTranslate;
-    std::map<std::pair<uint32_t, uint32_t>, PointToPointChannel*> m_channelMap;
-    std::map<uint32_t, uint32_t> m_nodeForwardTranslationMap;
+    TopologyGraph m_graph;
+    PointToPointTopologyHelper m_links;
     NodeContainer m_nodes;
-    std::vector<NetDeviceContainer> m_nodeDevices;
-    std::vector<NetDeviceContainer> m_linkDevices;
     std::vector<NodeCallback> m_callbacks;
     std::vector<std::pair<uint32_t, uint32_t> > m_pathsToTest;
     uint32_t m_currentPath;
     uint32_t m_currentTrial;
     uint32_t m_packets;
-    double m_delay;
+    uint32_t m_defaultPackets;
     double m_linkLatency;
+    uint64_t m_controlPackets;
+    uint64_t m_controlBytes;
+    Time m_lastControl;
+    bool m_memoryReport;
+    bool m_controlReport;
   public:
     
     void SetPropagationDelay (double latency) 
@@ -102,126 +104,69 @@ class Topology : public Object
       m_packets = packets;
     }
 
-    Topology()
+    // What the scenarios that leave out packets send
+    void SetDefaultPackets(uint32_t packets)
+    {
+      m_defaultPackets = packets;
+    }
+
+    void SetReports(bool memory, bool control)
+    {
+      m_memoryReport = memory;
+      m_controlReport = control;
+    }
+
+    const TopologyGraph& GetGraph()
+    {
+      return m_graph;
+    }
+
+    Topology() :
+      BatchTopology(Seconds(60.0 * 60.0 * 24 * 7), Time::MS)
     {
       m_numNodes = 0;
       m_currentPath = 0;
       m_currentTrial = 0;
-      m_simulationEnd = Seconds(60.0 * 60.0 * 24 * 7);
       m_packets = 0;
-      m_delay = 0.0;
+      m_defaultPackets = 0;
       m_linkLatency = 1.0;
+      m_controlPackets = 0;
+      m_controlBytes = 0;
+      m_memoryReport = false;
+      m_controlReport = false;
    }
    
-    virtual ~Topology()
-    {
-        for (uint32_t i = 0; i < m_numNodes; i++) {
-            delete m_connectivityGraph[i];
-        }
-    }
     void PopulateGraph(std::string& filename)
     {
-      std::map<uint32_t, std::list<uint32_t>*> tempConnectivityGraph;
       NS_LOG_INFO("Entering PopulateGraph with file " << filename);
-      std::ifstream topology(filename.c_str());
-      NS_ASSERT(topology.is_open());
-    
-      while (topology.good()) {
-        std::string input;
-        getline(topology, input);
-        size_t found = input.find(" ");
-        if (found == std::string::npos) {
-          continue;
-        }
-        std::string node1s = input.substr(0, int(found));
-        std::string node2s = input.substr(int(found) + 1, input.length() - (int(found) + 1));
-        uint32_t node1 = std::atoi(node1s.c_str()) ;
-        uint32_t node2 = std::atoi(node2s.c_str());
-        if (!tempConnectivityGraph[node1]) {
-          tempConnectivityGraph[node1] = new std::list<uint32_t>;
-        }
-        if (!tempConnectivityGraph[node2]) {
-          tempConnectivityGraph[node2] = new std::list<uint32_t>;
-        }
-        tempConnectivityGraph[node1]->push_back(node2);
-        tempConnectivityGraph[node2]->push_back(node1);
-      }
-    
-      m_numNodes = tempConnectivityGraph.size();
-      uint32_t last = 0;
-      m_connectivityGraph.resize(m_numNodes);
-    
-      for (std::map<uint32_t, std::list<uint32_t>*>::iterator it = tempConnectivityGraph.begin();
-          it != tempConnectivityGraph.end();
-          it++) {
-          m_nodeTranslate.push_back(it->first);
-          m_nodeForwardTranslationMap[it->first] = last;
-          NS_LOG_LOGIC("TRANSLATION: " << it->first << " = " << last);
-          last++;
-      }
-      for (uint32_t i = 0; i < m_numNodes; i++) {
-        m_connectivityGraph[i] = new std::list<uint32_t>;
-        for (std::list<uint32_t>::iterator it = tempConnectivityGraph[m_nodeTranslate[i]]->begin();
-             it != tempConnectivityGraph[m_nodeTranslate[i]]->end();
-             it++) {
-          m_connectivityGraph[i]->push_back(m_nodeForwardTranslationMap[*it]);
-        }
-        NS_ASSERT_MSG(!m_connectivityGraph[i]->empty(), "Empty for " << i);
-      }
+      Ptr<EdgeListTopologyReader> reader = CreateObject<EdgeListTopologyReader> ();
+      reader->SetFileName(filename);
+      NS_ABORT_MSG_UNLESS(reader->ReadGraph(), "Cannot read topology " << filename);
+      m_graph = reader->GetGraph();
+      m_numNodes = m_graph.GetNNodes();
     }
 
     void HookupSimulation()
     {
-      NS_LOG_INFO("Creating nodes");
-      m_nodes.Create (m_numNodes);
-      m_nodeDevices.resize(m_numNodes);
-      NS_LOG_INFO("Creating point to point connections");
-      PointToPointHelper pointToPoint;
-      pointToPoint.SetDeviceAttribute ("DataRate", StringValue ("10Gbps"));
-      pointToPoint.SetChannelAttribute("Delay", TimeValue(Time::FromDouble(m_linkLatency, Time::MS))); 
+      NS_LOG_INFO("Creating nodes and point to point connections");
+      m_links.SetDeviceAttribute ("DataRate", StringValue ("10Gbps"));
+      m_links.SetChannelAttribute("Delay", TimeValue(Time::FromDouble(m_linkLatency, Time::MS)));
+      m_nodes = m_links.Install(m_graph);
+      NS_LOG_INFO("Built " << m_numNodes << " nodes and " << m_links.GetNLinks() << " links in "
+                  << m_links.GetInstallTime() << " ms");
       for (uint32_t i = 0; i < m_numNodes; i++) {
-        m_callbacks.push_back(NodeCallback(m_nodeTranslate[i], this));
-        NS_ASSERT(!m_connectivityGraph[i]->empty());
-        for ( std::list<uint32_t>::iterator iterator = m_connectivityGraph[i]->begin(); 
-        iterator != m_connectivityGraph[i]->end();
-        iterator++) {
-          if (*iterator < i) {
-            continue;
-          }
-          NetDeviceContainer p2pDevices = 
-            pointToPoint.Install (m_nodes.Get(i), m_nodes.Get(*iterator));
-          m_nodeDevices[i].Add(p2pDevices.Get(0));
-          m_nodeDevices[*iterator].Add(p2pDevices.Get(1));
-          m_linkDevices.push_back(p2pDevices);
-          PointToPointChannel* channel = (PointToPointChannel*)GetPointer(p2pDevices.Get(0)->GetChannel());
-          m_channels.push_back(channel);
-          std::pair<uint32_t, uint32_t> normalizedLink;
-          if (m_nodeTranslate[i] < m_nodeTranslate[*iterator]) {
-            normalizedLink = std::pair<uint32_t, uint32_t>(m_nodeTranslate[i], m_nodeTranslate[*iterator]);
-          }
-          else {
-            normalizedLink = std::pair<uint32_t, uint32_t>(m_nodeTranslate[i], m_nodeTranslate[*iterator]);
-          }
-          m_channelMap[normalizedLink] = channel;
-        }
+        m_callbacks.push_back(NodeCallback(m_graph.GetId(i), this));
       }
 
-      InternetStackHelper stack;
-      stack.Install (m_nodes);
-      Ipv4AddressHelper address;
-      address.SetBase ("10.1.1.0", "255.255.255.0");
-      NS_LOG_INFO("Assigning address");
-      for (int i = 0; i < (int)m_linkDevices.size(); i++) {
-        Ipv4InterfaceContainer current = address.Assign(m_linkDevices[i]);
-        address.NewNetwork();
-      }
       Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
 
       UdpEchoServerHelper echoServer (9);
 
       ApplicationContainer serverApps = echoServer.Install (m_nodes);
       serverApps.Start (Seconds (1.0));
-      serverApps.Stop (m_simulationEnd);
+      if (!m_simulationEnd.IsZero()) {
+        serverApps.Stop (m_simulationEnd);
+      }
       m_clients.resize(m_numNodes);
       m_servers.resize(m_numNodes);
       for (uint32_t i = 0; i < m_numNodes; i++) {
@@ -230,9 +175,9 @@ class Topology : public Object
         Ptr<Ipv4L3Protocol> l3 = m_nodes.Get(i)->GetObject<Ipv4L3Protocol>();
         l3->TraceConnectWithoutContext("Drop", MakeCallback(&NodeCallback::DropTrace, &m_callbacks[i]));
         l3->SetAttribute("DefaultTtl", UintegerValue(255));
-        gr->SetAttribute("ReverseOutputToInputDelay", TimeValue(Time::FromDouble(m_delay, Time::MS)));
-        gr->SetAttribute("ReverseInputToOutputDelay", TimeValue(Time::FromDouble(m_delay, Time::MS)));
+        SetRepairDelay(gr);
         gr->AddReversalCallback(MakeCallback(&NodeCallback::NodeReversal, &m_callbacks[i]));
+        gr->TraceConnectWithoutContext("ControlTx", MakeCallback(&Topology::ControlSent, this));
         m_servers[i] =  (UdpEchoServer*)PeekPointer(serverApps.Get(i));
         m_servers[i]->AddReceivePacketEvent(MakeCallback(&NodeCallback::ServerRxPacket, &m_callbacks[i]));
         int j = 0;
@@ -255,16 +200,24 @@ class Topology : public Object
     void PingMachines (uint32_t client, uint32_t server)
     {
       NS_LOG_LOGIC("Untranslated sending between " << client << " and " << server);
-      client = m_nodeForwardTranslationMap[client];
-      server = m_nodeForwardTranslationMap[server];
+      client = m_graph.GetNode(client);
+      server = m_graph.GetNode(server);
       NS_LOG_LOGIC("Sending between " << client << " and " << server);
       m_clients[client]->SetRemote(m_nodes.Get(server)->GetObject<Ipv4>()->GetAddress(1, 0).GetLocal(), 9);
       Simulator::ScheduleNow(&UdpEchoClient::StopApplication, m_clients[client]);
       Simulator::ScheduleNow(&UdpEchoClient::StartApplication, m_clients[client]);
       Simulator::ScheduleNow(&UdpEchoClient::Send, m_clients[client]);
-      std::cout << "(" << Simulator::Now() << ") ";
+      std::cout << "(" << ScenarioTime() << ") ";
     }
     
+    // The link between two nodes, named as in the topology file
+    uint32_t GetLink(std::pair<uint32_t, uint32_t> key)
+    {
+      uint32_t link = m_links.GetLink(m_graph.GetNode(key.first), m_graph.GetNode(key.second));
+      NS_ABORT_MSG_IF(link == PointToPointTopologyHelper::NO_LINK, "No link between " << key.first << " and " << key.second);
+      return link;
+    }
+
     void FailLink (uint32_t from, uint32_t to)
     {
       NS_ASSERT(from < to);
@@ -275,25 +228,77 @@ class Topology : public Object
     void FailLinkPair(std::pair<uint32_t, uint32_t> key)
     {
       NS_LOG_LOGIC("Failing link between " << key.first << " and " << key.second);
-      m_channelMap[key]->SetLinkDown();
+      m_links.GetLinkChannel(GetLink(key))->SetLinkDown();
+    }
+
+    void PrintMemoryUsage ()
+    {
+      uint64_t total = 0;
+      for (uint32_t i = 0; i < m_numNodes; i++) {
+        Ptr<Ipv4GlobalRouting> gr = m_nodes.Get(i)->GetObject<GlobalRouter>()->GetRoutingProtocol();
+        uint64_t bytes = gr->GetMemoryUsage();
+        total += bytes;
+        std::cout << "M," << m_graph.GetId(i) << "," << gr->GetNDestinations() << "," << bytes << std::endl;
+      }
+      std::cout << "M,mean," << (m_numNodes ? total / m_numNodes : 0) << std::endl;
+      std::cout << "M,table," << SimulationSingleton<GlobalRouteManagerImpl>::Get ()->GetDistanceTable()->GetMemoryUsage() << std::endl;
+    }
+
+    void ControlSent (Ptr<const Packet> packet, uint32_t iface)
+    {
+      m_controlPackets++;
+      m_controlBytes += packet->GetSize();
+      m_lastControl = ScenarioTime();
+    }
+
+    void PrintControlUsage ()
+    {
+      std::cout << "C," << m_controlPackets << "," << m_controlBytes << "," << m_lastControl << std::endl;
+    }
+
+    void StartScenario(const BatchScenario& scenario)
+    {
+      BeginScenario(scenario, m_nodes);
+      randVar = UniformVariable();
+      m_controlPackets = 0;
+      m_controlBytes = 0;
+      m_lastControl = Time();
+      SetPackets(scenario.Has("packets") ? std::atoi(scenario.Get("packets").c_str()) : m_defaultPackets);
+      std::vector<std::pair<uint32_t, uint32_t> > linksToFail;
+      std::vector<std::pair<uint32_t, uint32_t> > pathsToTest;
+      ParseLinks(scenario.Get("links"), linksToFail);
+      ParseLinks(scenario.Get("paths"), pathsToTest);
+      for (std::vector<std::pair<uint32_t, uint32_t> >::iterator it = linksToFail.begin();
+           it != linksToFail.end();
+           it++) {
+        Simulator::ScheduleNow(&Topology::FailLinkPair, this, *it);
+      }
+      if (!pathsToTest.empty()) {
+        AddPathsToTest(pathsToTest);
+      }
     }
 
-    void SetDelay(double delay)
+    void EndScenario()
     {
-      m_delay = delay;
+      if (m_memoryReport) {
+        PrintMemoryUsage();
+      }
+      if (m_controlReport) {
+        PrintControlUsage();
+      }
     }
 };
 
 
 void NodeCallback::RxPacket (Ptr<const Packet> packet, Ipv4Header& header) {
   NS_LOG_LOGIC(m_id << " Received packet " << (uint32_t)header.GetTtl());
-  std::cout << (uint32_t)header.GetTtl() << " (" << Simulator::Now() << ") ";
+  std::cout << (uint32_t)header.GetTtl() << " (" << m_topology->ScenarioTime() << ") ";
   m_topology->RouteEnded();
 }
 
 void NodeCallback::ServerRxPacket (Ptr<const Packet> packet, Ipv4Header& header) {
   NS_LOG_LOGIC(m_id << " Server Received packet " << (uint32_t)header.GetTtl());
-  std::cout << (uint32_t)header.GetTtl() << " (" << Simulator::Now() << "),";
+  std::cout << (uint32_t)header.GetTtl() << " (" << m_topology->ScenarioTime() << "),";
 }
 
 void NodeCallback::NodeReversal (uint32_t iface, Ipv4Address addr) {
@@ -302,30 +307,15 @@ void NodeCallback::NodeReversal (uint32_t iface, Ipv4Address addr) {
 
 void NodeCallback::DropTrace (const Ipv4Header& hdr, Ptr<const Packet> packet, Ipv4L3Protocol::DropReason drop, Ptr<Ipv4> ipv4, uint32_t iface) {
   NS_LOG_LOGIC(m_id << " dropped packet " << iface);
-  std::cout << "D (" << Simulator::Now() << ") ";
+  std::cout << "D (" << m_topology->ScenarioTime() << ") ";
   m_topology->RouteEnded();
 }
 
 void NodeCallback::PhyDropTrace (Ptr<const Packet>) {
-  std::cout << m_id << "P (" << Simulator::Now() << ") ";
+  std::cout << m_id << "P (" << m_topology->ScenarioTime() << ") ";
   m_topology->RouteEnded();
 }
 
-void
-ParseLinks(std::string links, std::vector<std::pair<uint32_t, uint32_t> >& results)
-{
-  std::vector<std::string> linkParts;
-  
-  boost::split(linkParts, links, boost::is_any_of(","));
-  for (std::vector<std::string>::iterator it = linkParts.begin(); 
-       it != linkParts.end(); it++) {
-    std::vector<std::string> nodeParts;
-    boost::split(nodeParts, *it, boost::is_any_of("="));
-    NS_ASSERT(nodeParts.size() == 2);
-    results.push_back(std::pair<uint32_t, uint32_t>(std::atoi(nodeParts[0].c_str()), std::atoi(nodeParts[1].c_str())));
-  }
-}
-
 int
 main (int argc, char *argv[])
 {
@@ -339,8 +329,17 @@ main (int argc, char *argv[])
   uint32_t packets = 1;
   double delay;
   double linkLatency = 1.0;
-  std::vector<std::pair<uint32_t, uint32_t> > linksToFail;
-  std::vector<std::pair<uint32_t, uint32_t> > pathsToTest;
+  bool memoryReport = false;
+  std::string stateKey = "Address";
+  std::string controlPlane = "Direct";
+  double controlDelay = 0.0;
+  std::string batch;
+  std::string output;
+  uint32_t jobs = 1;
+  uint32_t sample = 0;
+  uint32_t failures = 1;
+  uint32_t samplePaths = 10;
+  double coverage = 0.025;
   CommandLine cmd;
   cmd.AddValue("packets", "Number of packets to echo", packets);
   cmd.AddValue("error", "Simulate error", simulateError);
@@ -350,32 +349,56 @@ main (int argc, char *argv[])
   cmd.AddValue("packets", "Packets to send per trial", packets);
   cmd.AddValue("delay", "Delay for repairs", delay);
   cmd.AddValue("latency", "Propagation delay (ms)", linkLatency);
+  cmd.AddValue("memory", "Print DDC memory usage per node at the end", memoryReport);
+  cmd.AddValue("stateKey", "Keep DDC state per destination Address or per destination Node", stateKey);
+  cmd.AddValue("controlPlane", "Reach DDC neighbours Directly or with control Messages", controlPlane);
+  cmd.AddValue("controlDelay", "Control message processing delay (ms)", controlDelay);
+  cmd.AddValue("batch", "Run every scenario (links, paths, packets, delay) in this file", batch);
+  cmd.AddValue("output", "Write each batch scenario's results to <output>/<scenario>.txt", output);
+  cmd.AddValue("jobs", "Batch scenarios to run at once in forked processes (0 for one per core)", jobs);
+  cmd.AddValue("sample", "Run this many sampled failure scenarios as a batch instead", sample);
+  cmd.AddValue("failures", "Links to fail in each sampled scenario", failures);
+  cmd.AddValue("samplePaths", "Source destination pairs to test in each sampled scenario (0 for every affected pair)", samplePaths);
+  cmd.AddValue("coverage", "Fraction of all pairs sampled failures must be on a shortest path of", coverage);
   cmd.Parse(argc, argv);
-  if (!links.empty()) {
-    ParseLinks(links, linksToFail);
-  }
-  if (!paths.empty()) {
-    ParseLinks(paths, pathsToTest);
-  }
+  Config::SetDefault("ns3::Ipv4GlobalRouting::StateKey", StringValue(stateKey));
+  Config::SetDefault("ns3::Ipv4GlobalRouting::ControlPlane", StringValue(controlPlane));
+  Config::SetDefault("ns3::Ipv4GlobalRouting::ControlProcessingDelay", TimeValue(Time::FromDouble(controlDelay, Time::MS)));
   Topology simulationTopology;
   simulationTopology.SetDelay(delay);
-  simulationTopology.SetPackets(packets);
+  simulationTopology.SetDefaultPackets(packets);
   simulationTopology.SetPropagationDelay(linkLatency);
+  simulationTopology.SetReports(memoryReport, controlPlane == "Messages");
+  if (!batch.empty() || sample > 0) {
+    simulationTopology.SetSimulationEnd(Seconds(0));
+  }
   simulationTopology.PopulateGraph(topology);
   simulationTopology.HookupSimulation();
-  //LogComponentEnable ("UdpEchoClientApplication", LOG_LEVEL_INFO);
-  //LogComponentEnable ("UdpEchoServerApplication", LOG_LEVEL_INFO);
-  //Simulator::ScheduleNow(&Topology::FailLink, &simulationTopology, 5, 6);
-  //Simulator::ScheduleNow(&Topology::FailLink, &simulationTopology, 6, 7);
-  for (std::vector<std::pair<uint32_t, uint32_t> >::iterator it = linksToFail.begin();
-       it != linksToFail.end();
-       it++) {
-    Simulator::ScheduleNow(&Topology::FailLinkPair, &simulationTopology, *it);
+  if (sample > 0) {
+    // Global routing has computed every distance already. The nodes were
+    // created in graph order, so their IDs are the graph's indices.
+    FailureSampler::DistanceCallback distance;
+    Ptr<DdcDistanceTable> table = SimulationSingleton<GlobalRouteManagerImpl>::Get ()->GetDistanceTable();
+    if (table != 0) {
+      distance = MakeCallback(&DdcDistanceTable::GetDistance, table);
+    }
+    std::vector<BatchScenario> scenarios = SampleFailureScenarios(simulationTopology.GetGraph(), failures, failures,
+                                                                  sample, 100 * sample, coverage, samplePaths, distance);
+    RunBatchScenarios(simulationTopology, scenarios, output, jobs);
+    Simulator::Destroy ();
+    return 0;
+  }
+  if (!batch.empty()) {
+    RunBatchScenarios(simulationTopology, batch, output, jobs);
+    Simulator::Destroy ();
+    return 0;
   }
-  simulationTopology.AddPathsToTest(pathsToTest);
-  //Simulator::Schedule(Seconds(1.0), &Topology::PingMachines, &simulationTopology, 1, 6);
-  //simulationTopology.PingMachines(1, 6);
+  BatchScenario scenario;
+  scenario.Set("links", links);
+  scenario.Set("paths", paths);
+  simulationTopology.StartScenario(scenario);
   Simulator::Run ();
+  simulationTopology.EndScenario();
   Simulator::Destroy ();
 
   return 0;
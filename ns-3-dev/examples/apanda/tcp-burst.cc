@@ -18,11 +18,11 @@
 #include "ns3/network-module.h"
 #include "ns3/internet-module.h"
 #include "ns3/point-to-point-module.h"
+#include "ns3/topology-read-module.h"
 #include "ns3/applications-module.h"
 #include "ns3/random-variable.h"
 #include "ns3/ipv4-l3-protocol.h"
 #include "ns3/global-route-manager-impl.h"
-#include "boost/algorithm/string.hpp"
 #include "ns3/data-rate.h"
 #include <list>
 #include <vector>
@@ -37,32 +37,27 @@
 #include <utility>
 #include <functional>
 #include "stretch-classes.h"
+#include "batch-scenarios.h"
 
 using namespace ns3;
 
 NS_LOG_COMPONENT_DEFINE ("DDC-NSDI-TCP-BURST");
-class Topology : public Object
+class Topology : public Object, public BatchTopology
 {
   protected:
     std::vector<UdpEchoClient*> m_clients;
     std::vector<UdpEchoServer*> m_servers;
-    std::vector<PointToPointChannel* > m_channels;
     UniformVariable randVar;
     uint32_t m_numNodes;
-    std::vector<std::list<uint32_t>*> m_connectivityGraph;
-    Time m_simulationEnd;
-    std::vector<uint32_t> m_nodeTranslate;
-    std::map<std::pair<uint32_t, uint32_t>, PointToPointChannel*> m_channelMap;
-    std::map<uint32_t, uint32_t> m_nodeForwardTranslationMap;
+    TopologyGraph m_graph;
+    PointToPointTopologyHelper m_links;
     NodeContainer m_nodes;
-    std::vector<NetDeviceContainer> m_nodeDevices;
-    std::vector<NetDeviceContainer> m_linkDevices;
     std::vector<NodeCallback> m_callbacks;
     std::vector<std::pair<uint32_t, uint32_t> > m_pathsToTest;
     uint32_t m_currentPath;
     uint32_t m_currentTrial;
     uint32_t m_packets;
-    double m_delay;
+    uint32_t m_defaultPackets;
     double m_linkLatency;
   public:
     
@@ -71,10 +66,6 @@ class Topology : public Object
       m_linkLatency = latency;
     }
 
-    void SetDelay(double delay)
-    {
-      m_delay = delay;
-    }
     void AddPathsToTest(std::vector<std::pair<uint32_t, uint32_t> > paths)
     {
       m_pathsToTest.insert(m_pathsToTest.end(), paths.begin(), paths.end());
@@ -106,134 +97,60 @@ class Topology : public Object
       m_packets = packets;
     }
 
-    Topology()
+    // What the scenarios that leave out packets send
+    void SetDefaultPackets(uint32_t packets)
+    {
+      m_defaultPackets = packets;
+    }
+
+    Topology() :
+      BatchTopology(Seconds(60.0 * 60.0 * 24 * 7), Time::MS)
     {
       m_numNodes = 0;
       m_currentPath = 0;
       m_currentTrial = 0;
-      m_simulationEnd = Seconds(60.0 * 60.0 * 24 * 7);
       m_packets = 0;
+      m_defaultPackets = 0;
       m_linkLatency = 1.0;
    }
    
-    virtual ~Topology()
-    {
-        for (uint32_t i = 0; i < m_numNodes; i++) {
-            delete m_connectivityGraph[i];
-        }
-    }
     void PopulateGraph(std::string& filename)
     {
-      std::map<uint32_t, std::list<uint32_t>*> tempConnectivityGraph;
       NS_LOG_INFO("Entering PopulateGraph with file " << filename);
-      std::ifstream topology(filename.c_str());
-      NS_ASSERT(topology.is_open());
-    
-      while (topology.good()) {
-        std::string input;
-        getline(topology, input);
-        size_t found = input.find(" ");
-        if (found == std::string::npos) {
-          continue;
-        }
-        std::string node1s = input.substr(0, int(found));
-        std::string node2s = input.substr(int(found) + 1, input.length() - (int(found) + 1));
-        uint32_t node1 = std::atoi(node1s.c_str()) ;
-        uint32_t node2 = std::atoi(node2s.c_str());
-        if (!tempConnectivityGraph[node1]) {
-          tempConnectivityGraph[node1] = new std::list<uint32_t>;
-        }
-        if (!tempConnectivityGraph[node2]) {
-          tempConnectivityGraph[node2] = new std::list<uint32_t>;
-        }
-        tempConnectivityGraph[node1]->push_back(node2);
-        tempConnectivityGraph[node2]->push_back(node1);
-      }
-    
-      m_numNodes = tempConnectivityGraph.size();
-      uint32_t last = 0;
-      m_connectivityGraph.resize(m_numNodes);
-    
-      for (std::map<uint32_t, std::list<uint32_t>*>::iterator it = tempConnectivityGraph.begin();
-          it != tempConnectivityGraph.end();
-          it++) {
-          m_nodeTranslate.push_back(it->first);
-          m_nodeForwardTranslationMap[it->first] = last;
-          NS_LOG_LOGIC("TRANSLATION: " << it->first << " = " << last);
-          last++;
-      }
-      for (uint32_t i = 0; i < m_numNodes; i++) {
-        m_connectivityGraph[i] = new std::list<uint32_t>;
-        for (std::list<uint32_t>::iterator it = tempConnectivityGraph[m_nodeTranslate[i]]->begin();
-             it != tempConnectivityGraph[m_nodeTranslate[i]]->end();
-             it++) {
-          m_connectivityGraph[i]->push_back(m_nodeForwardTranslationMap[*it]);
-        }
-        NS_ASSERT_MSG(!m_connectivityGraph[i]->empty(), "Empty for " << i);
-      }
+      Ptr<EdgeListTopologyReader> reader = CreateObject<EdgeListTopologyReader> ();
+      reader->SetFileName(filename);
+      NS_ABORT_MSG_UNLESS(reader->ReadGraph(), "Cannot read topology " << filename);
+      m_graph = reader->GetGraph();
+      m_numNodes = m_graph.GetNNodes();
     }
 
     void HookupSimulation()
     {
-      NS_LOG_INFO("Creating nodes");
-      m_nodes.Create (m_numNodes);
-      m_nodeDevices.resize(m_numNodes);
-      NS_LOG_INFO("Creating point to point connections");
-      PointToPointHelper pointToPoint;
-      pointToPoint.SetDeviceAttribute ("DataRate", StringValue ("10Gbps"));
-      pointToPoint.SetChannelAttribute("Delay", TimeValue(MilliSeconds(m_linkLatency))); 
+      NS_LOG_INFO("Creating nodes and point to point connections");
+      m_links.SetDeviceAttribute ("DataRate", StringValue ("10Gbps"));
+      m_links.SetChannelAttribute("Delay", TimeValue(MilliSeconds(m_linkLatency)));
+      m_nodes = m_links.Install(m_graph);
+      NS_LOG_INFO("Built " << m_numNodes << " nodes and " << m_links.GetNLinks() << " links in "
+                  << m_links.GetInstallTime() << " ms");
       for (uint32_t i = 0; i < m_numNodes; i++) {
-        m_callbacks.push_back(NodeCallback(m_nodeTranslate[i], this));
-        NS_ASSERT(!m_connectivityGraph[i]->empty());
-        for ( std::list<uint32_t>::iterator iterator = m_connectivityGraph[i]->begin(); 
-        iterator != m_connectivityGraph[i]->end();
-        iterator++) {
-          if (*iterator < i) {
-            continue;
-          }
-          pointToPoint.SetDeviceAttribute ("DataRate", DataRateValue(DataRate("10Gbps")));
-          pointToPoint.SetChannelAttribute("Delay", TimeValue(MilliSeconds(m_linkLatency))); 
-          NetDeviceContainer p2pDevices = 
-            pointToPoint.Install (m_nodes.Get(i), m_nodes.Get(*iterator));
-          m_nodeDevices[i].Add(p2pDevices.Get(0));
-          m_nodeDevices[*iterator].Add(p2pDevices.Get(1));
-          m_linkDevices.push_back(p2pDevices);
-          PointToPointChannel* channel = (PointToPointChannel*)GetPointer(p2pDevices.Get(0)->GetChannel());
-          m_channels.push_back(channel);
-          std::pair<uint32_t, uint32_t> normalizedLink;
-          if (m_nodeTranslate[i] < m_nodeTranslate[*iterator]) {
-            normalizedLink = std::pair<uint32_t, uint32_t>(m_nodeTranslate[i], m_nodeTranslate[*iterator]);
-          }
-          else {
-            normalizedLink = std::pair<uint32_t, uint32_t>(m_nodeTranslate[i], m_nodeTranslate[*iterator]);
-          }
-          m_channelMap[normalizedLink] = channel;
-        }
+        m_callbacks.push_back(NodeCallback(m_graph.GetId(i), this));
       }
 
-      InternetStackHelper stack;
-      stack.Install (m_nodes);
-      Ipv4AddressHelper address;
-      address.SetBase ("10.1.1.0", "255.255.255.0");
-      NS_LOG_INFO("Assigning address");
-      for (int i = 0; i < (int)m_linkDevices.size(); i++) {
-        Ipv4InterfaceContainer current = address.Assign(m_linkDevices[i]);
-        address.NewNetwork();
-      }
       Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
 
       UdpEchoServerHelper echoServer (9);
 
       ApplicationContainer serverApps = echoServer.Install (m_nodes);
       serverApps.Start (Seconds (1.0));
-      serverApps.Stop (m_simulationEnd);
+      if (!m_simulationEnd.IsZero()) {
+        serverApps.Stop (m_simulationEnd);
+      }
       m_clients.resize(m_numNodes);
       m_servers.resize(m_numNodes);
       for (uint32_t i = 0; i < m_numNodes; i++) {
         Ptr<GlobalRouter> router = m_nodes.Get(i)->GetObject<GlobalRouter>();
         Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol();
-        gr->SetAttribute("ReverseOutputToInputDelay", TimeValue(Seconds(m_delay * 0.001)));
-        gr->SetAttribute("ReverseInputToOutputDelay", TimeValue(Seconds(m_delay * 0.001)));
+        SetRepairDelay(gr);
         Ptr<Ipv4L3Protocol> l3 = m_nodes.Get(i)->GetObject<Ipv4L3Protocol>();
         l3->TraceConnectWithoutContext("Drop", MakeCallback(&NodeCallback::DropTrace, &m_callbacks[i]));
         l3->SetAttribute("DefaultTtl", UintegerValue(255));
@@ -260,8 +177,8 @@ class Topology : public Object
     void PingMachines (uint32_t client, uint32_t server)
     {
       NS_LOG_LOGIC("Untranslated sending between " << client << " and " << server);
-      client = m_nodeForwardTranslationMap[client];
-      server = m_nodeForwardTranslationMap[server];
+      client = m_graph.GetNode(client);
+      server = m_graph.GetNode(server);
       NS_LOG_LOGIC("Sending between " << client << " and " << server);
       m_clients[client]->SetRemote(m_nodes.Get(server)->GetObject<Ipv4>()->GetAddress(1, 0).GetLocal(), 9);
       Simulator::ScheduleNow(&UdpEchoClient::StopApplication, m_clients[client]);
@@ -269,6 +186,14 @@ class Topology : public Object
       Simulator::Schedule(Seconds(1.0), &UdpEchoClient::SendBurst, m_clients[client], m_packets, MicroSeconds(10));
     }
     
+    // The link between two nodes, named as in the topology file
+    uint32_t GetLink(std::pair<uint32_t, uint32_t> key)
+    {
+      uint32_t link = m_links.GetLink(m_graph.GetNode(key.first), m_graph.GetNode(key.second));
+      NS_ABORT_MSG_IF(link == PointToPointTopologyHelper::NO_LINK, "No link between " << key.first << " and " << key.second);
+      return link;
+    }
+
     void FailLink (uint32_t from, uint32_t to)
     {
       NS_ASSERT(from < to);
@@ -279,7 +204,30 @@ class Topology : public Object
     void FailLinkPair(std::pair<uint32_t, uint32_t> key)
     {
       NS_LOG_LOGIC("Failing link between " << key.first << " and " << key.second);
-      m_channelMap[key]->SetLinkDown();
+      m_links.GetLinkChannel(GetLink(key))->SetLinkDown();
+    }
+
+    void StartScenario(const BatchScenario& scenario)
+    {
+      BeginScenario(scenario, m_nodes);
+      randVar = UniformVariable();
+      SetPackets(scenario.Has("packets") ? std::atoi(scenario.Get("packets").c_str()) : m_defaultPackets);
+      std::vector<std::pair<uint32_t, uint32_t> > linksToFail;
+      std::vector<std::pair<uint32_t, uint32_t> > pathsToTest;
+      ParseLinks(scenario.Get("links"), linksToFail);
+      ParseLinks(scenario.Get("paths"), pathsToTest);
+      for (std::vector<std::pair<uint32_t, uint32_t> >::iterator it = linksToFail.begin();
+           it != linksToFail.end();
+           it++) {
+        Simulator::ScheduleNow(&Topology::FailLinkPair, this, *it);
+      }
+      if (!pathsToTest.empty()) {
+        AddPathsToTest(pathsToTest);
+      }
+    }
+
+    void EndScenario()
+    {
     }
 };
 
@@ -312,21 +260,6 @@ void NodeCallback::DropTrace (const Ipv4Header& hdr, Ptr<const Packet> packet, I
 
 void NodeCallback::PhyDropTrace (Ptr<const Packet>) {}
 
-void
-ParseLinks(std::string links, std::vector<std::pair<uint32_t, uint32_t> >& results)
-{
-  std::vector<std::string> linkParts;
-  
-  boost::split(linkParts, links, boost::is_any_of(","));
-  for (std::vector<std::string>::iterator it = linkParts.begin(); 
-       it != linkParts.end(); it++) {
-    std::vector<std::string> nodeParts;
-    boost::split(nodeParts, *it, boost::is_any_of("="));
-    NS_ASSERT(nodeParts.size() == 2);
-    results.push_back(std::pair<uint32_t, uint32_t>(std::atoi(nodeParts[0].c_str()), std::atoi(nodeParts[1].c_str())));
-  }
-}
-
 int
 main (int argc, char *argv[])
 {
@@ -340,8 +273,9 @@ main (int argc, char *argv[])
   uint32_t packets = 1;
   double delay = 0.0;
   double linkLatency = 1.0;
-  std::vector<std::pair<uint32_t, uint32_t> > linksToFail;
-  std::vector<std::pair<uint32_t, uint32_t> > pathsToTest;
+  std::string batch;
+  std::string output;
+  uint32_t jobs = 1;
   CommandLine cmd;
   cmd.AddValue("packets", "Number of packets to echo", packets);
   cmd.AddValue("error", "Simulate error", simulateError);
@@ -351,31 +285,28 @@ main (int argc, char *argv[])
   cmd.AddValue("packets", "Packets to send per trial", packets);
   cmd.AddValue("delay", "Delay for repairs", delay);
   cmd.AddValue("latency", "Propagation delay (ms)", linkLatency);
+  cmd.AddValue("batch", "Run every scenario (links, paths, packets, delay) in this file", batch);
+  cmd.AddValue("output", "Write each batch scenario's results to <output>/<scenario>.txt", output);
+  cmd.AddValue("jobs", "Batch scenarios to run at once in forked processes (0 for one per core)", jobs);
   cmd.Parse(argc, argv);
-  if (!links.empty()) {
-    ParseLinks(links, linksToFail);
-  }
-  if (!paths.empty()) {
-    ParseLinks(paths, pathsToTest);
-  }
   Topology simulationTopology;
   simulationTopology.SetDelay(delay);
-  simulationTopology.SetPackets(packets);
+  simulationTopology.SetDefaultPackets(packets);
   simulationTopology.SetPropagationDelay(linkLatency);
+  if (!batch.empty()) {
+    simulationTopology.SetSimulationEnd(Seconds(0));
+  }
   simulationTopology.PopulateGraph(topology);
   simulationTopology.HookupSimulation();
-  //LogComponentEnable ("UdpEchoClientApplication", LOG_LEVEL_INFO);
-  //LogComponentEnable ("UdpEchoServerApplication", LOG_LEVEL_INFO);
-  //Simulator::ScheduleNow(&Topology::FailLink, &simulationTopology, 5, 6);
-  //Simulator::ScheduleNow(&Topology::FailLink, &simulationTopology, 6, 7);
-  for (std::vector<std::pair<uint32_t, uint32_t> >::iterator it = linksToFail.begin();
-       it != linksToFail.end();
-       it++) {
-    Simulator::ScheduleNow(&Topology::FailLinkPair, &simulationTopology, *it);
+  if (!batch.empty()) {
+    RunBatchScenarios(simulationTopology, batch, output, jobs);
+    Simulator::Destroy ();
+    return 0;
   }
-  simulationTopology.AddPathsToTest(pathsToTest);
-  //Simulator::Schedule(Seconds(1.0), &Topology::PingMachines, &simulationTopology, 1, 6);
-  //simulationTopology.PingMachines(1, 6);
+  BatchScenario scenario;
+  scenario.Set("links", links);
+  scenario.Set("paths", paths);
+  simulationTopology.StartScenario(scenario);
   Simulator::Run ();
   Simulator::Destroy ();
 
@@ -18,6 +18,7 @@
 #include "ns3/network-module.h"
 #include "ns3/internet-module.h"
 #include "ns3/point-to-point-module.h"
+#include "ns3/topology-read-module.h"
 #include "ns3/applications-module.h"
 #include "ns3/random-variable.h"
 #include "ns3/ipv4-l3-protocol.h"
@@ -46,18 +47,12 @@ class Topology : public Object
   protected:
     std::vector<UdpEchoClient*> m_clients;
     std::vector<UdpEchoServer*> m_servers;
-    std::vector<PointToPointChannel* > m_channels;
     UniformVariable randVar;
     uint32_t m_numNodes;
-    std::vector<std::list<uint32_t>*> m_connectivityGraph;
+    TopologyGraph m_graph;
+    PointToPointTopologyHelper m_links;
     Time m_simulationEnd;
-    std::vector<uint32_t> m_nodeTranslate;
-    std::map<std::pair<uint32_t, uint32_t>, PointToPointChannel*> m_channelMap;
-    std::map<uint32_t, uint32_t> m_nodeForwardTranslationMap;
-    std::map<Ipv4Address, uint32_t> m_addressToNodeMap; 
     NodeContainer m_nodes;
-    std::vector<NetDeviceContainer> m_nodeDevices;
-    std::vector<NetDeviceContainer> m_linkDevices;
     std::vector<NodeCallback> m_callbacks;
     std::vector<std::pair<uint32_t, uint32_t> > m_pathsToTest;
     uint32_t m_currentPath;
@@ -74,12 +69,12 @@ class Topology : public Object
 
     inline uint32_t CannonicalNode (const uint32_t node) 
     {
-      return m_nodeTranslate[node];
+      return m_graph.GetId(node);
     }
 
     inline uint32_t AddressForNode (const Ipv4Address address) 
     {
-      return m_addressToNodeMap[address];
+      return m_links.GetAddressNode(address);
     }
 
     void ServerTx (Ptr<const Packet> packet, Ipv4Header& header)
@@ -105,8 +100,8 @@ class Topology : public Object
     {
       m_pathsToTest.insert(m_pathsToTest.end(), paths.begin(), paths.end());
       for (;m_currentPath < m_pathsToTest.size(); m_currentPath++) {
-        uint32_t client = m_nodeForwardTranslationMap[m_pathsToTest[m_currentPath].first];
-        uint32_t server = m_nodeForwardTranslationMap[m_pathsToTest[m_currentPath].second];
+        uint32_t client = m_graph.GetNode(m_pathsToTest[m_currentPath].first);
+        uint32_t server = m_graph.GetNode(m_pathsToTest[m_currentPath].second);
         UdpEchoClientHelper echoClient (m_nodes.Get(server)->GetObject<Ipv4>()->GetAddress(1, 0).GetLocal(),
                                           9);
         echoClient.SetAttribute ("MaxPackets", UintegerValue (0));
@@ -159,124 +154,36 @@ class Topology : public Object
       m_linkLatency = 1.0;
    }
    
-    virtual ~Topology()
-    {
-        for (uint32_t i = 0; i < m_numNodes; i++) {
-            delete m_connectivityGraph[i];
-        }
-    }
     void PopulateGraph(std::string& filename)
     {
-      std::map<uint32_t, std::list<uint32_t>*> tempConnectivityGraph;
       NS_LOG_INFO("Entering PopulateGraph with file " << filename);
-      std::ifstream topology(filename.c_str());
-      NS_ASSERT(topology.is_open());
-    
-      while (topology.good()) {
-        std::string input;
-        getline(topology, input);
-        size_t found = input.find(" ");
-        if (found == std::string::npos) {
-          continue;
-        }
-        std::string node1s = input.substr(0, int(found));
-        std::string node2s = input.substr(int(found) + 1, input.length() - (int(found) + 1));
-        uint32_t node1 = std::atoi(node1s.c_str()) ;
-        uint32_t node2 = std::atoi(node2s.c_str());
-        if (!tempConnectivityGraph[node1]) {
-          tempConnectivityGraph[node1] = new std::list<uint32_t>;
-        }
-        if (!tempConnectivityGraph[node2]) {
-          tempConnectivityGraph[node2] = new std::list<uint32_t>;
-        }
-        tempConnectivityGraph[node1]->push_back(node2);
-        tempConnectivityGraph[node2]->push_back(node1);
-      }
-    
-      m_numNodes = tempConnectivityGraph.size();
-      uint32_t last = 0;
-      m_connectivityGraph.resize(m_numNodes);
-    
-      for (std::map<uint32_t, std::list<uint32_t>*>::iterator it = tempConnectivityGraph.begin();
-          it != tempConnectivityGraph.end();
-          it++) {
-          m_nodeTranslate.push_back(it->first);
-          m_nodeForwardTranslationMap[it->first] = last;
-          NS_LOG_LOGIC("TRANSLATION: " << it->first << " = " << last);
-          last++;
-      }
-      for (uint32_t i = 0; i < m_numNodes; i++) {
-        m_connectivityGraph[i] = new std::list<uint32_t>;
-        for (std::list<uint32_t>::iterator it = tempConnectivityGraph[m_nodeTranslate[i]]->begin();
-             it != tempConnectivityGraph[m_nodeTranslate[i]]->end();
-             it++) {
-          m_connectivityGraph[i]->push_back(m_nodeForwardTranslationMap[*it]);
-        }
-        NS_ASSERT_MSG(!m_connectivityGraph[i]->empty(), "Empty for " << i);
-      }
+      Ptr<EdgeListTopologyReader> reader = CreateObject<EdgeListTopologyReader> ();
+      reader->SetFileName(filename);
+      NS_ABORT_MSG_UNLESS(reader->ReadGraph(), "Cannot read topology " << filename);
+      m_graph = reader->GetGraph();
+      m_numNodes = m_graph.GetNNodes();
     }
 
     void HookupSimulation()
     {
-      NS_LOG_INFO("Creating nodes");
-      m_nodes.Create (m_numNodes);
-      m_nodeDevices.resize(m_numNodes);
-      NS_LOG_INFO("Creating point to point connections");
-      PointToPointHelper pointToPoint;
-      pointToPoint.SetDeviceAttribute ("DataRate", StringValue ("10Gbps"));
-      pointToPoint.SetChannelAttribute("Delay", TimeValue(Time::FromDouble(m_linkLatency, Time::MS))); 
+      NS_LOG_INFO("Creating nodes and point to point connections");
+      m_links.SetDeviceAttribute ("DataRate", StringValue ("10Gbps"));
+      m_links.SetChannelAttribute("Delay", TimeValue(Time::FromDouble(m_linkLatency, Time::MS)));
+      m_nodes = m_links.Install(m_graph);
+      NS_LOG_INFO("Built " << m_numNodes << " nodes and " << m_links.GetNLinks() << " links in "
+                  << m_links.GetInstallTime() << " ms");
+      // The traces are bound to the callbacks by address, so the vector
+      // must not reallocate while they are added
+      m_callbacks.reserve(m_numNodes);
       for (uint32_t i = 0; i < m_numNodes; i++) {
-        m_callbacks.push_back(NodeCallback(m_nodeTranslate[i], this));
-        NS_ASSERT(!m_connectivityGraph[i]->empty());
-        for ( std::list<uint32_t>::iterator iterator = m_connectivityGraph[i]->begin(); 
-        iterator != m_connectivityGraph[i]->end();
-        iterator++) {
-          if (*iterator < i) {
-            continue;
-          }
-          pointToPoint.SetDeviceAttribute ("DataRate", DataRateValue(DataRate("10Gbps")));
-          pointToPoint.SetChannelAttribute("Delay", TimeValue(Time::FromDouble(m_linkLatency, Time::MS))); 
-          NetDeviceContainer p2pDevices = 
-            pointToPoint.Install (m_nodes.Get(i), m_nodes.Get(*iterator));
-          m_nodeDevices[i].Add(p2pDevices.Get(0));
-          p2pDevices.Get(0)->TraceConnectWithoutContext("MacTxDrop", MakeCallback(&NodeCallback::PhyDropTrace, &m_callbacks[i]));
-          m_nodeDevices[*iterator].Add(p2pDevices.Get(1));
-          p2pDevices.Get(1)->TraceConnectWithoutContext("MacTxDrop", MakeCallback(&NodeCallback::PhyDropTrace, &m_callbacks[*iterator]));
-          m_linkDevices.push_back(p2pDevices);
-          PointToPointChannel* channel = (PointToPointChannel*)GetPointer(p2pDevices.Get(0)->GetChannel());
-          m_channels.push_back(channel);
-          std::pair<uint32_t, uint32_t> normalizedLink;
-          if (m_nodeTranslate[i] < m_nodeTranslate[*iterator]) {
-            normalizedLink = std::pair<uint32_t, uint32_t>(m_nodeTranslate[i], m_nodeTranslate[*iterator]);
-          }
-          else {
-            normalizedLink = std::pair<uint32_t, uint32_t>(m_nodeTranslate[i], m_nodeTranslate[*iterator]);
-          }
-          m_channelMap[normalizedLink] = channel;
-        }
-      }
-
-      InternetStackHelper stack;
-      stack.Install (m_nodes);
-      Ipv4AddressHelper address;
-      address.SetBase ("10.1.1.0", "255.255.255.0");
-      NS_LOG_INFO("Assigning address");
-      for (int i = 0; i < (int)m_linkDevices.size(); i++) {
-        Ipv4InterfaceContainer current = address.Assign(m_linkDevices[i]);
-        address.NewNetwork();
+        m_callbacks.push_back(NodeCallback(m_graph.GetId(i), this));
       }
-      NS_LOG_INFO("Assigned addresses");
-
-      for (NodeList::Iterator it = NodeList::Begin(); it != NodeList::End(); it++) {
-        Ptr<Node> node = *it;
-        Ptr<Ipv4> ipv4 = node->GetObject<Ipv4>();
-        for (uint32_t i = 1; i < ipv4->GetNInterfaces (); i++) {
-          for (uint32_t j = 0; j < ipv4->GetNAddresses (i); j++) {
-            m_addressToNodeMap[ipv4->GetAddress(i, j).GetLocal ()] = node->GetId(); 
-          }
+      for (uint32_t link = 0; link < m_links.GetNLinks(); link++) {
+        for (uint32_t side = 0; side < 2; side++) {
+          m_links.GetLinkDevice(link, side)->TraceConnectWithoutContext("MacTxDrop",
+              MakeCallback(&NodeCallback::PhyDropTrace, &m_callbacks[m_links.GetLinkNode(link, side)]));
         }
       }
-      NS_LOG_INFO("Added addresses");
 
       Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
 
@@ -324,11 +231,18 @@ class Topology : public Object
       FailLinkPair(std::pair<uint32_t, uint32_t>(from, to));
     }
 
+    uint32_t GetLink(std::pair<uint32_t, uint32_t> key)
+    {
+      uint32_t link = m_links.GetLink(m_graph.GetNode(key.first), m_graph.GetNode(key.second));
+      NS_ABORT_MSG_IF(link == PointToPointTopologyHelper::NO_LINK, "No link between " << key.first << " and " << key.second);
+      return link;
+    }
+
     void FailLinkPair(std::pair<uint32_t, uint32_t> key)
     {
       NS_LOG_LOGIC("Failing link between " << key.first << " and " << key.second);
       std::cout << key.first << "," << key.second << ",F" << std::endl;
-      m_channelMap[key]->SetLinkDown();
+      m_links.GetLinkChannel(GetLink(key))->SetLinkDown();
     }
 };
 
@@ -18,11 +18,11 @@
 #include "ns3/network-module.h"
 #include "ns3/internet-module.h"
 #include "ns3/point-to-point-module.h"
+#include "ns3/topology-read-module.h"
 #include "ns3/applications-module.h"
 #include "ns3/random-variable.h"
 #include "ns3/ipv4-l3-protocol.h"
 #include "ns3/global-route-manager-impl.h"
-#include "boost/algorithm/string.hpp"
 #include "ns3/data-rate.h"
 #include <list>
 #include <vector>
@@ -37,6 +37,8 @@
 #include <utility>
 #include <functional>
 #include "stretch-classes.h"
+#include "batch-scenarios.h"
+#include "event-recorder.h"
 
 using namespace ns3;
 
@@ -65,6 +67,7 @@ class TcpFileTransfer : public Object
       }
       m_dest = dest;
       m_node = node;
+      m_currentBytes = 0;
     }
 
     void StartSending () {
@@ -93,33 +96,38 @@ class TcpFileTransfer : public Object
       }
       localSocket->Close ();
     }
+
+    // Detaches the socket, which may outlive this transfer, from it.
+    // Closing it here would send a FIN into the next scenario
+    void Stop () {
+      if (m_socket == 0) {
+        return;
+      }
+      m_socket->TraceDisconnectWithoutContext("Retransmit", MakeCallback(&TcpFileTransfer::RetransmitCallback, this));
+      m_socket->SetSendCallback(MakeNullCallback<void, Ptr<Socket>, uint32_t> ());
+      m_socket = 0;
+    }
 };
 
-class Topology : public Object
+class Topology : public Object, public BatchTopology
 {
   protected:
     std::vector<UdpEchoClient*> m_clients;
     std::vector<UdpEchoServer*> m_servers;
-    std::vector<PointToPointChannel* > m_channels;
     UniformVariable randVar;
     uint32_t m_numNodes;
-    std::vector<std::list<uint32_t>*> m_connectivityGraph;
-    Time m_simulationEnd;
-    std::vector<uint32_t> m_nodeTranslate;
-    std::map<std::pair<uint32_t, uint32_t>, PointToPointChannel*> m_channelMap;
-    std::map<uint32_t, uint32_t> m_nodeForwardTranslationMap;
-    std::map<Ipv4Address, uint32_t> m_addressToNodeMap; 
+    TopologyGraph m_graph;
+    PointToPointTopologyHelper m_links;
     NodeContainer m_nodes;
-    std::vector<NetDeviceContainer> m_nodeDevices;
-    std::vector<NetDeviceContainer> m_linkDevices;
     std::vector<NodeCallback> m_callbacks;
     std::vector<std::pair<uint32_t, uint32_t> > m_pathsToTest;
     uint32_t m_currentPath;
     uint32_t m_currentTrial;
     uint32_t m_packets;
-    double m_delay;
+    uint32_t m_defaultPackets;
     std::list<TcpFileTransfer*> m_fileTransfers;
     double m_linkLatency;
+    EventRecorder m_events;
   public:
     void SetPropagationDelay (double latency) 
     {
@@ -134,30 +142,35 @@ class Topology : public Object
     void ReceivePacketCallback (Ptr<const Packet> packet, const Address& addr)
     {
       Ipv4Address ipAddr = InetSocketAddress::ConvertFrom(addr).GetIpv4();
-      std::cout << m_addressToNodeMap[ipAddr] << ",RX," << Simulator::Now().ToDouble(Time::US) << "," << packet->GetSize() << std::endl;
+      if (m_events.IsOpen()) {
+        m_events.Record(EVENT_TCP_RX, m_links.GetAddressNode(ipAddr), m_links.GetAddressNode(ipAddr), 0, packet->GetSize());
+        return;
+      }
+      std::cout << m_links.GetAddressNode(ipAddr) << ",RX," << ScenarioTime().ToDouble(Time::US) << "," << packet->GetSize() << std::endl;
     }
 
     inline uint32_t CannonicalNode (const uint32_t node) 
     {
-      return m_nodeTranslate[node];
+      return m_graph.GetId(node);
     }
 
-    inline uint32_t AddressForNode (const Ipv4Address address) 
+    EventRecorder& Events ()
     {
-      return m_addressToNodeMap[address];
+      return m_events;
     }
 
-    void SetDelay(double delay)
+    inline uint32_t AddressForNode (const Ipv4Address address) 
     {
-      m_delay = delay;
+      return m_links.GetAddressNode(address);
     }
+
     void AddPathsToTest(std::vector<std::pair<uint32_t, uint32_t> > paths)
     {
       NS_LOG_LOGIC("Add paths to test");
       m_pathsToTest.insert(m_pathsToTest.end(), paths.begin(), paths.end());
       for (;m_currentPath < m_pathsToTest.size(); m_currentPath++) {
-        uint32_t client = m_nodeForwardTranslationMap[m_pathsToTest[m_currentPath].first];
-        uint32_t server = m_nodeForwardTranslationMap[m_pathsToTest[m_currentPath].second];
+        uint32_t client = m_graph.GetNode(m_pathsToTest[m_currentPath].first);
+        uint32_t server = m_graph.GetNode(m_pathsToTest[m_currentPath].second);
         TcpFileTransfer* fileTransfer = new TcpFileTransfer(m_nodes.Get(client), m_nodes.Get(server));
         m_fileTransfers.push_back(fileTransfer);
         Simulator::Schedule(Seconds(2.0), &TcpFileTransfer::StartSending, fileTransfer);
@@ -177,134 +190,53 @@ class Topology : public Object
       m_packets = packets;
     }
 
-    Topology()
+    // What the scenarios that leave out packets send
+    void SetDefaultPackets(uint32_t packets)
+    {
+      m_defaultPackets = packets;
+    }
+
+    Topology() :
+      BatchTopology(Seconds(60.0 * 60.0 * 24 * 7), Time::NS)
     {
       m_numNodes = 0;
       m_currentPath = 0;
       m_currentTrial = 0;
-      m_simulationEnd = Seconds(60.0 * 60.0 * 24 * 7);
       m_packets = 0;
+      m_defaultPackets = 0;
       m_linkLatency = 1.0;
    }
    
-    virtual ~Topology()
-    {
-        for (uint32_t i = 0; i < m_numNodes; i++) {
-            delete m_connectivityGraph[i];
-        }
-    }
     void PopulateGraph(std::string& filename)
     {
-      std::map<uint32_t, std::list<uint32_t>*> tempConnectivityGraph;
       NS_LOG_INFO("Entering PopulateGraph with file " << filename);
-      std::ifstream topology(filename.c_str());
-      NS_ASSERT(topology.is_open());
-    
-      while (topology.good()) {
-        std::string input;
-        getline(topology, input);
-        size_t found = input.find(" ");
-        if (found == std::string::npos) {
-          continue;
-        }
-        std::string node1s = input.substr(0, int(found));
-        std::string node2s = input.substr(int(found) + 1, input.length() - (int(found) + 1));
-        uint32_t node1 = std::atoi(node1s.c_str()) ;
-        uint32_t node2 = std::atoi(node2s.c_str());
-        if (!tempConnectivityGraph[node1]) {
-          tempConnectivityGraph[node1] = new std::list<uint32_t>;
-        }
-        if (!tempConnectivityGraph[node2]) {
-          tempConnectivityGraph[node2] = new std::list<uint32_t>;
-        }
-        tempConnectivityGraph[node1]->push_back(node2);
-        tempConnectivityGraph[node2]->push_back(node1);
-      }
-    
-      m_numNodes = tempConnectivityGraph.size();
-      uint32_t last = 0;
-      m_connectivityGraph.resize(m_numNodes);
-    
-      for (std::map<uint32_t, std::list<uint32_t>*>::iterator it = tempConnectivityGraph.begin();
-          it != tempConnectivityGraph.end();
-          it++) {
-          m_nodeTranslate.push_back(it->first);
-          m_nodeForwardTranslationMap[it->first] = last;
-          NS_LOG_LOGIC("TRANSLATION: " << it->first << " = " << last);
-          last++;
-      }
-      for (uint32_t i = 0; i < m_numNodes; i++) {
-        m_connectivityGraph[i] = new std::list<uint32_t>;
-        for (std::list<uint32_t>::iterator it = tempConnectivityGraph[m_nodeTranslate[i]]->begin();
-             it != tempConnectivityGraph[m_nodeTranslate[i]]->end();
-             it++) {
-          m_connectivityGraph[i]->push_back(m_nodeForwardTranslationMap[*it]);
-        }
-        NS_ASSERT_MSG(!m_connectivityGraph[i]->empty(), "Empty for " << i);
-      }
+      Ptr<EdgeListTopologyReader> reader = CreateObject<EdgeListTopologyReader> ();
+      reader->SetFileName(filename);
+      NS_ABORT_MSG_UNLESS(reader->ReadGraph(), "Cannot read topology " << filename);
+      m_graph = reader->GetGraph();
+      m_numNodes = m_graph.GetNNodes();
     }
 
     void HookupSimulation()
     {
-      NS_LOG_INFO("Creating nodes");
-      m_nodes.Create (m_numNodes);
-      m_nodeDevices.resize(m_numNodes);
-      NS_LOG_INFO("Creating point to point connections");
-      PointToPointHelper pointToPoint;
-      pointToPoint.SetDeviceAttribute ("DataRate", StringValue ("10Gbps"));
-      pointToPoint.SetChannelAttribute("Delay", TimeValue(MilliSeconds(m_linkLatency))); 
+      NS_LOG_INFO("Creating nodes and point to point connections");
+      m_links.SetDeviceAttribute ("DataRate", StringValue ("10Gbps"));
+      m_links.SetChannelAttribute("Delay", TimeValue(MilliSeconds(m_linkLatency)));
+      m_nodes = m_links.Install(m_graph);
+      NS_LOG_INFO("Built " << m_numNodes << " nodes and " << m_links.GetNLinks() << " links in "
+                  << m_links.GetInstallTime() << " ms");
+      // The traces are bound to the callbacks by address, so the vector
+      // must not reallocate while they are added
+      m_callbacks.reserve(m_numNodes);
       for (uint32_t i = 0; i < m_numNodes; i++) {
-        m_callbacks.push_back(NodeCallback(m_nodeTranslate[i], this));
-        NS_ASSERT(!m_connectivityGraph[i]->empty());
-        for ( std::list<uint32_t>::iterator iterator = m_connectivityGraph[i]->begin(); 
-        iterator != m_connectivityGraph[i]->end();
-        iterator++) {
-          if (*iterator < i) {
-            continue;
-          }
-          pointToPoint.SetDeviceAttribute ("DataRate", DataRateValue(DataRate("10Gbps")));
-          pointToPoint.SetChannelAttribute("Delay", TimeValue(MilliSeconds(m_linkLatency))); 
-          NetDeviceContainer p2pDevices = 
-            pointToPoint.Install (m_nodes.Get(i), m_nodes.Get(*iterator));
-          m_nodeDevices[i].Add(p2pDevices.Get(0));
-          p2pDevices.Get(0)->TraceConnectWithoutContext("MacTxDrop", MakeCallback(&NodeCallback::PhyDropTrace, &m_callbacks[i]));
-          m_nodeDevices[*iterator].Add(p2pDevices.Get(1));
-          p2pDevices.Get(1)->TraceConnectWithoutContext("MacTxDrop", MakeCallback(&NodeCallback::PhyDropTrace, &m_callbacks[*iterator]));
-          m_linkDevices.push_back(p2pDevices);
-          PointToPointChannel* channel = (PointToPointChannel*)GetPointer(p2pDevices.Get(0)->GetChannel());
-          m_channels.push_back(channel);
-          std::pair<uint32_t, uint32_t> normalizedLink;
-          if (m_nodeTranslate[i] < m_nodeTranslate[*iterator]) {
-            normalizedLink = std::pair<uint32_t, uint32_t>(m_nodeTranslate[i], m_nodeTranslate[*iterator]);
-          }
-          else {
-            normalizedLink = std::pair<uint32_t, uint32_t>(m_nodeTranslate[i], m_nodeTranslate[*iterator]);
-          }
-          m_channelMap[normalizedLink] = channel;
-        }
+        m_callbacks.push_back(NodeCallback(m_graph.GetId(i), this));
       }
-
-      InternetStackHelper stack;
-      stack.Install (m_nodes);
-      Ipv4AddressHelper address;
-      address.SetBase ("10.1.1.0", "255.255.255.0");
-      NS_LOG_INFO("Assigning address");
-      for (int i = 0; i < (int)m_linkDevices.size(); i++) {
-        Ipv4InterfaceContainer current = address.Assign(m_linkDevices[i]);
-        address.NewNetwork();
-      }
-      NS_LOG_INFO("Assigned addresses");
-
-      for (NodeList::Iterator it = NodeList::Begin(); it != NodeList::End(); it++) {
-        Ptr<Node> node = *it;
-        Ptr<Ipv4> ipv4 = node->GetObject<Ipv4>();
-        for (uint32_t i = 1; i < ipv4->GetNInterfaces (); i++) {
-          for (uint32_t j = 0; j < ipv4->GetNAddresses (i); j++) {
-            m_addressToNodeMap[ipv4->GetAddress(i, j).GetLocal ()] = node->GetId(); 
-          }
+      for (uint32_t link = 0; link < m_links.GetNLinks(); link++) {
+        for (uint32_t side = 0; side < 2; side++) {
+          m_links.GetLinkDevice(link, side)->TraceConnectWithoutContext("MacTxDrop",
+              MakeCallback(&NodeCallback::PhyDropTrace, &m_callbacks[m_links.GetLinkNode(link, side)]));
         }
       }
-      NS_LOG_INFO("Added addresses");
 
       Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
 
@@ -318,15 +250,16 @@ class Topology : public Object
       ApplicationContainer sinks = sink.Install (m_nodes);
       sinks.Start (Seconds (0.0));
       serverApps.Start (Seconds (1.0));
-      serverApps.Stop (m_simulationEnd);
+      if (!m_simulationEnd.IsZero()) {
+        serverApps.Stop (m_simulationEnd);
+      }
       m_clients.resize(m_numNodes);
       m_servers.resize(m_numNodes);
       for (uint32_t i = 0; i < m_numNodes; i++) {
         sinks.Get(i)->TraceConnectWithoutContext(std::string("Rx"), MakeCallback(&Topology::ReceivePacketCallback, this));
         Ptr<GlobalRouter> router = m_nodes.Get(i)->GetObject<GlobalRouter>();
         Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol();
-        gr->SetAttribute("ReverseOutputToInputDelay", TimeValue(MilliSeconds(m_delay * 1e-6)));
-        gr->SetAttribute("ReverseInputToOutputDelay", TimeValue(MilliSeconds(m_delay * 1e-6)));
+        SetRepairDelay(gr);
         Ptr<Ipv4L3Protocol> l3 = m_nodes.Get(i)->GetObject<Ipv4L3Protocol>();
         l3->TraceConnectWithoutContext("Drop", MakeCallback(&NodeCallback::DropTrace, &m_callbacks[i]));
         l3->SetAttribute("DefaultTtl", UintegerValue(255));
@@ -350,6 +283,14 @@ class Topology : public Object
       Simulator::Schedule(Seconds(1.0), &UdpEchoClient::SendBurst, client, m_packets, MilliSeconds(0.012));
     }
     
+    // The link between two nodes, named as in the topology file
+    uint32_t GetLink(std::pair<uint32_t, uint32_t> key)
+    {
+      uint32_t link = m_links.GetLink(m_graph.GetNode(key.first), m_graph.GetNode(key.second));
+      NS_ABORT_MSG_IF(link == PointToPointTopologyHelper::NO_LINK, "No link between " << key.first << " and " << key.second);
+      return link;
+    }
+
     void FailLink (uint32_t from, uint32_t to)
     {
       NS_ASSERT(from < to);
@@ -360,8 +301,48 @@ class Topology : public Object
     void FailLinkPair(std::pair<uint32_t, uint32_t> key)
     {
       NS_LOG_LOGIC("Failing link between " << key.first << " and " << key.second);
-      std::cout << key.first << "," << key.second << ",F" << std::endl;
-      m_channelMap[key]->SetLinkDown();
+      if (m_events.IsOpen()) {
+        m_events.Record(EVENT_FAIL, key.first, key.first, key.second);
+      }
+      else {
+        std::cout << key.first << "," << key.second << ",F" << std::endl;
+      }
+      m_links.GetLinkChannel(GetLink(key))->SetLinkDown();
+    }
+
+    void StartScenario(const BatchScenario& scenario)
+    {
+      BeginScenario(scenario, m_nodes);
+      if (scenario.Has("events")) {
+        m_events.Open(scenario.Get("events"));
+      }
+      SetPackets(scenario.Has("packets") ? std::atoi(scenario.Get("packets").c_str()) : m_defaultPackets);
+      std::vector<std::pair<uint32_t, uint32_t> > linksToFail;
+      std::vector<std::pair<uint32_t, uint32_t> > pathsToTest;
+      ParseLinks(scenario.Get("links"), linksToFail);
+      ParseLinks(scenario.Get("paths"), pathsToTest);
+      WeibullVariable weibull(2.0, 0.5);
+      for (std::vector<std::pair<uint32_t, uint32_t> >::iterator it = linksToFail.begin();
+           it != linksToFail.end();
+           it++) {
+        double failTime = 3.0 + weibull.GetValue();
+        Simulator::Schedule(Seconds(failTime), &Topology::FailLinkPair, this, *it);
+      }
+      AddPathsToTest(pathsToTest);
+    }
+
+    // The transfers belong to one scenario, so the next scenario in the
+    // same process starts without them
+    void EndScenario()
+    {
+      m_events.Close();
+      for (std::list<TcpFileTransfer*>::iterator it = m_fileTransfers.begin(); it != m_fileTransfers.end(); it++) {
+        (*it)->Stop();
+        delete *it;
+      }
+      m_fileTransfers.clear();
+      m_pathsToTest.clear();
+      m_currentPath = 0;
     }
 };
 
@@ -370,6 +351,10 @@ void NodeCallback::RxPacket (Ptr<const Packet> packet, Ipv4Header& header) {
   NS_LOG_LOGIC(m_id << " Received packet " << (uint32_t)header.GetTtl());
   uint32_t seq = 0;
   packet->CopyData ((uint8_t*)&seq, sizeof(seq));
+  if (m_topology->Events().IsOpen()) {
+    m_topology->Events().Record(EVENT_RX, m_id, m_topology->CannonicalNode(m_topology->AddressForNode(header.GetSource())), m_id, seq, header.GetTtl());
+    return;
+  }
   std::cout << m_topology->CannonicalNode(m_topology->AddressForNode(header.GetSource()))
             <<"," << m_id << ","<< seq << std::endl;
 }
@@ -378,6 +363,10 @@ void NodeCallback::ServerRxPacket (Ptr<const Packet> packet, Ipv4Header& header)
   NS_LOG_LOGIC(m_id << " Server Received packet " << (uint32_t)header.GetTtl());
   uint32_t seq = 0;
   packet->CopyData ((uint8_t*)&seq, sizeof(seq));
+  if (m_topology->Events().IsOpen()) {
+    m_topology->Events().Record(EVENT_SERVER_RX, m_id, m_topology->CannonicalNode(m_topology->AddressForNode(header.GetSource())), m_id, seq, header.GetTtl());
+    return;
+  }
   std::cout << m_topology->CannonicalNode(m_topology->AddressForNode(header.GetSource()))
             <<"," << m_id << ","<< seq << std::endl;
   //std::cout << seq << ",";
@@ -385,33 +374,33 @@ void NodeCallback::ServerRxPacket (Ptr<const Packet> packet, Ipv4Header& header)
 
 void NodeCallback::NodeReversal (uint32_t iface, Ipv4Address addr) {
   NS_LOG_LOGIC(m_id << " reversed iface " << iface << " for " << addr);
+  if (m_topology->Events().IsOpen()) {
+    m_topology->Events().Record(EVENT_REVERSAL, m_id, m_id, m_topology->CannonicalNode(m_topology->AddressForNode(addr)), iface);
+    return;
+  }
   std::cout << m_id << ",R" << std::endl;
 }
 
 void NodeCallback::DropTrace (const Ipv4Header& hdr, Ptr<const Packet> packet, Ipv4L3Protocol::DropReason drop, Ptr<Ipv4> ipv4, uint32_t iface) {
   NS_LOG_LOGIC(m_id << " dropped packet " << iface);
+  if (m_topology->Events().IsOpen()) {
+    m_topology->Events().Record(EVENT_DROP, m_id,
+                                m_topology->CannonicalNode(m_topology->AddressForNode(hdr.GetSource())),
+                                m_topology->CannonicalNode(m_topology->AddressForNode(hdr.GetDestination())),
+                                0, hdr.GetTtl());
+    return;
+  }
   std::cout << m_topology->CannonicalNode(m_topology->AddressForNode(hdr.GetSource()))
             << "," << m_topology->CannonicalNode(m_topology->AddressForNode(hdr.GetDestination()))
             << ",D(" << (uint32_t)hdr.GetTtl() << ")" << std::endl;
 }
 
 void NodeCallback::PhyDropTrace (Ptr<const Packet> packet) {
-  std::cout << m_id << ",P" << std::endl;
-}
-
-void
-ParseLinks(std::string links, std::vector<std::pair<uint32_t, uint32_t> >& results)
-{
-  std::vector<std::string> linkParts;
-  
-  boost::split(linkParts, links, boost::is_any_of(","));
-  for (std::vector<std::string>::iterator it = linkParts.begin(); 
-       it != linkParts.end(); it++) {
-    std::vector<std::string> nodeParts;
-    boost::split(nodeParts, *it, boost::is_any_of("="));
-    NS_ASSERT(nodeParts.size() == 2);
-    results.push_back(std::pair<uint32_t, uint32_t>(std::atoi(nodeParts[0].c_str()), std::atoi(nodeParts[1].c_str())));
+  if (m_topology->Events().IsOpen()) {
+    m_topology->Events().Record(EVENT_PHY_DROP, m_id, m_id, m_id);
+    return;
   }
+  std::cout << m_id << ",P" << std::endl;
 }
 
 int
@@ -427,8 +416,10 @@ main (int argc, char *argv[])
   uint32_t packets = 1;
   double delay = 0.0;
   double linkLatency = 1.0;
-  std::vector<std::pair<uint32_t, uint32_t> > linksToFail;
-  std::vector<std::pair<uint32_t, uint32_t> > pathsToTest;
+  std::string batch;
+  std::string output;
+  std::string events;
+  uint32_t jobs = 1;
   CommandLine cmd;
   cmd.AddValue("packets", "Number of packets to echo", packets);
   cmd.AddValue("error", "Simulate error", simulateError);
@@ -438,34 +429,34 @@ main (int argc, char *argv[])
   cmd.AddValue("packets", "Packets to send per trial", packets);
   cmd.AddValue("delay", "Delay for repairs", delay);
   cmd.AddValue("latency", "Propagation delay (ms)", linkLatency);
+  cmd.AddValue("batch", "Run every scenario (links, paths, packets, delay, events) in this file", batch);
+  cmd.AddValue("output", "Write each batch scenario's results to <output>/<scenario>.txt", output);
+  cmd.AddValue("events", "Record per packet events to this binary file instead of printing them", events);
+  cmd.AddValue("jobs", "Batch scenarios to run at once in forked processes (0 for one per core)", jobs);
   cmd.Parse(argc, argv);
-  if (!links.empty()) {
-    ParseLinks(links, linksToFail);
-  }
-  if (!paths.empty()) {
-    ParseLinks(paths, pathsToTest);
-  }
   Topology simulationTopology;
   simulationTopology.SetDelay(delay);
-  simulationTopology.SetPackets(packets);
+  simulationTopology.SetDefaultPackets(packets);
   simulationTopology.SetPropagationDelay(linkLatency);
+  if (!batch.empty()) {
+    simulationTopology.SetSimulationEnd(Seconds(0));
+  }
   simulationTopology.PopulateGraph(topology);
   simulationTopology.HookupSimulation();
-  //LogComponentEnable ("UdpEchoClientApplication", LOG_LEVEL_INFO);
-  //LogComponentEnable ("UdpEchoServerApplication", LOG_LEVEL_INFO);
-  //Simulator::ScheduleNow(&Topology::FailLink, &simulationTopology, 5, 6);
-  //Simulator::ScheduleNow(&Topology::FailLink, &simulationTopology, 6, 7);
-  WeibullVariable weibull(2.0, 0.5);
-  for (std::vector<std::pair<uint32_t, uint32_t> >::iterator it = linksToFail.begin();
-       it != linksToFail.end();
-       it++) {
-    double failTime = 3.0 + weibull.GetValue();
-    Simulator::Schedule(Seconds(failTime), &Topology::FailLinkPair, &simulationTopology, *it);
+  if (!batch.empty()) {
+    RunBatchScenarios(simulationTopology, batch, output, jobs);
+    Simulator::Destroy ();
+    return 0;
+  }
+  BatchScenario scenario;
+  scenario.Set("links", links);
+  scenario.Set("paths", paths);
+  if (!events.empty()) {
+    scenario.Set("events", events);
   }
-  simulationTopology.AddPathsToTest(pathsToTest);
-  //Simulator::Schedule(Seconds(1.0), &Topology::PingMachines, &simulationTopology, 1, 6);
-  //simulationTopology.PingMachines(1, 6);
+  simulationTopology.StartScenario(scenario);
   Simulator::Run ();
+  simulationTopology.EndScenario();
   Simulator::Destroy ();
 
   return 0;
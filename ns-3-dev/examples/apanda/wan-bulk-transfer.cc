@@ -18,6 +18,7 @@
 #include "ns3/network-module.h"
 #include "ns3/internet-module.h"
 #include "ns3/point-to-point-module.h"
+#include "ns3/topology-read-module.h"
 #include "ns3/applications-module.h"
 #include "ns3/random-variable.h"
 #include "ns3/ipv4-l3-protocol.h"
@@ -39,6 +40,7 @@
 #include <utility>
 #include <functional>
 #include "stretch-classes.h"
+#include "schedule-source.h"
 
 using namespace ns3;
 
@@ -49,19 +51,13 @@ class Topology : public Object
 {
   protected:
     std::map<uint32_t, WanSendApplication*> m_partClients;
-    std::vector<PointToPointChannel* > m_channels;
     UniformVariable randVar;
     uint32_t m_numNodes;
-    std::vector<std::list<uint32_t>*> m_connectivityGraph;
+    TopologyGraph m_graph;
+    PointToPointTopologyHelper m_links;
     Time m_simulationEnd;
     std::vector<uint32_t> m_hosts;
-    std::vector<uint32_t> m_nodeTranslate;
-    std::map<std::pair<uint32_t, uint32_t>, PointToPointChannel*> m_channelMap;
-    std::map<uint32_t, uint32_t> m_nodeForwardTranslationMap;
-    std::map<Ipv4Address, uint32_t> m_addressToNodeMap; 
     NodeContainer m_nodes;
-    std::vector<NetDeviceContainer> m_nodeDevices;
-    std::vector<NetDeviceContainer> m_linkDevices;
     std::vector<NodeCallback> m_callbacks;
     std::vector<std::pair<uint32_t, std::list<uint32_t> > > m_pathsToTest;
     uint32_t m_currentPath;
@@ -70,6 +66,8 @@ class Topology : public Object
     double m_linkLatency;
     bool m_repair;
     bool m_fail;
+    ScheduleSource<Topology> m_schedule;
+    Time m_scheduleWindow;
   public:
     void SetRepair (bool repair)
     {
@@ -94,22 +92,22 @@ class Topology : public Object
     void ReceivePacketCallback (Ptr<const Packet> packet, const Address& addr)
     {
       Ipv4Address ipAddr = InetSocketAddress::ConvertFrom(addr).GetIpv4();
-      std::cout << m_addressToNodeMap[ipAddr] << ",RX," << Simulator::Now().ToDouble(Time::US) << "," << packet->GetSize() << std::endl;
+      std::cout << m_links.GetAddressNode(ipAddr) << ",RX," << Simulator::Now().ToDouble(Time::US) << "," << packet->GetSize() << std::endl;
     }
 
     inline uint32_t CannonicalNode (const uint32_t node) 
     {
-      return m_nodeTranslate[node];
+      return m_graph.GetId(node);
     }
 
     inline uint32_t PhysicalNode (const uint32_t node)
     {
-      return m_nodeForwardTranslationMap[node];
+      return m_graph.GetNode(node);
     }
 
     inline uint32_t AddressForNode (const Ipv4Address address) 
     {
-      return m_addressToNodeMap[address];
+      return m_links.GetAddressNode(address);
     }
 
     void SetDelay(double delay)
@@ -130,141 +128,40 @@ class Topology : public Object
       m_currentPath = 0;
       m_currentTrial = 0;
       m_simulationEnd = Seconds(60.0 * 60.0 * 24 * 100);
+      m_scheduleWindow = Seconds(1.0);
       m_linkLatency = 10.0;
       m_repair = true;
    }
    
-    virtual ~Topology()
+    void PopulateGraph (const std::string& filename, const std::string& hostFile)
     {
-        for (uint32_t i = 0; i < m_numNodes; i++) {
-            delete m_connectivityGraph[i];
-        }
-    }
-    
-    void PopulateGraph (const std::string& filename)
-    {
-      std::map<uint32_t, std::list<uint32_t>*> tempConnectivityGraph;
       NS_LOG_INFO("Entering PopulateGraph with file " << filename);
-      std::ifstream topology(filename.c_str());
-      NS_ASSERT(topology.is_open());
-      //boost::split(linkParts, links, boost::is_any_of(","));
-      while (topology.good()) {
-        std::string input;
-        getline(topology, input);
-        std::vector<std::string> topoParts;
-        boost::split(topoParts, input, boost::is_any_of(" "));
-        if (topoParts.size() < 2) {
-          continue;
-        }
-        uint32_t node1 = std::atoi(topoParts[0].c_str());
-        uint32_t node2 = std::atoi(topoParts[1].c_str());
-        bool isHost = topoParts.size() > 2 && (topoParts[2].compare("h") == 0);
-        if (!tempConnectivityGraph[node1]) {
-          tempConnectivityGraph[node1] = new std::list<uint32_t>;
-        }
-        if (!tempConnectivityGraph[node2]) {
-          tempConnectivityGraph[node2] = new std::list<uint32_t>;
-        }
-        tempConnectivityGraph[node1]->push_back(node2);
-        tempConnectivityGraph[node2]->push_back(node1);
-        if (isHost) {
-          m_hosts.push_back(node2);
-        }
-      }
-
-      m_numNodes = tempConnectivityGraph.size();
-      uint32_t last = 0;
-      m_connectivityGraph.resize(m_numNodes);
-    
-      for (std::map<uint32_t, std::list<uint32_t>*>::iterator it = tempConnectivityGraph.begin();
-          it != tempConnectivityGraph.end();
-          it++) {
-          m_nodeTranslate.push_back(it->first);
-          m_nodeForwardTranslationMap[it->first] = last;
-          NS_LOG_LOGIC("TRANSLATION: " << it->first << " = " << last);
-          last++;
-      }
-      for (uint32_t i = 0; i < m_numNodes; i++) {
-        m_connectivityGraph[i] = new std::list<uint32_t>;
-        for (std::list<uint32_t>::iterator it = tempConnectivityGraph[m_nodeTranslate[i]]->begin();
-             it != tempConnectivityGraph[m_nodeTranslate[i]]->end();
-             it++) {
-          NS_LOG_LOGIC("Link " << m_nodeTranslate[i] << " " << *it << " translated " << i << " " << m_nodeForwardTranslationMap[*it]);
-          m_connectivityGraph[i]->push_back(m_nodeForwardTranslationMap[*it]);
-        }
-        NS_ASSERT_MSG(!m_connectivityGraph[i]->empty(), "Empty for " << i);
-      }
+      Ptr<EdgeListTopologyReader> reader = CreateObject<EdgeListTopologyReader> ();
+      reader->SetFileName(filename);
+      reader->SetAttribute("HostFileName", StringValue(hostFile));
+      NS_ABORT_MSG_UNLESS(reader->ReadGraph(), "Cannot read topology " << filename);
+      m_graph = reader->GetGraph();
+      m_hosts = reader->GetHosts();
+      m_numNodes = m_graph.GetNNodes();
     }
 
     void HookupSimulation()
     {
-      NS_LOG_INFO("Creating nodes");
-      m_nodes.Create (m_numNodes);
-      m_nodeDevices.resize(m_numNodes);
-      NS_LOG_INFO("Creating point to point connections");
-      PointToPointHelper pointToPoint;
-      pointToPoint.SetDeviceAttribute ("DataRate", StringValue ("1Gbps"));
+      NS_LOG_INFO("Creating nodes and point to point connections");
+      m_links.SetDeviceAttribute ("DataRate", StringValue ("1Gbps"));
       std::cout << "Latency = " << Time::FromDouble(m_linkLatency, Time::MS).GetMicroSeconds() << " us" << std::endl;
-      pointToPoint.SetChannelAttribute("Delay", TimeValue(Time::FromDouble(m_linkLatency, Time::MS))); 
+      m_links.SetChannelAttribute("Delay", TimeValue(Time::FromDouble(m_linkLatency, Time::MS)));
+      m_links.SetMergeParallelEdges(true);
+      m_nodes = m_links.Install(m_graph);
+      NS_LOG_INFO("Built " << m_numNodes << " nodes and " << m_links.GetNLinks() << " links in "
+                  << m_links.GetInstallTime() << " ms");
       Config::SetDefault ("ns3::RttEstimator::MinRTO", TimeValue(MilliSeconds(11)));
       Config::SetDefault ("ns3::TcpSocket::InitialCwnd", UintegerValue(10));
       Config::SetDefault ("ns3::TcpSocket::SegmentSize", UintegerValue(1200));
       for (uint32_t i = 0; i < m_numNodes; i++) {
-        m_callbacks.push_back(NodeCallback(m_nodeTranslate[i], this));
-        NS_ASSERT(!m_connectivityGraph[i]->empty());
-        for ( std::list<uint32_t>::iterator iterator = m_connectivityGraph[i]->begin(); 
-        iterator != m_connectivityGraph[i]->end();
-        iterator++) {
-          NS_LOG_LOGIC("ITER " << i << " " << *iterator);
-          std::pair<uint32_t, uint32_t> normalizedLink;
-          if (m_nodeTranslate[i] < m_nodeTranslate[*iterator]) {
-            normalizedLink = std::pair<uint32_t, uint32_t>(m_nodeTranslate[i], m_nodeTranslate[*iterator]);
-          }
-          else {
-            normalizedLink = std::pair<uint32_t, uint32_t>(m_nodeTranslate[*iterator], m_nodeTranslate[i]);
-          }
-          if (m_channelMap[normalizedLink] != 0) {
-            NS_LOG_LOGIC ("NOT adding link " << normalizedLink.first << " " << normalizedLink.second << " already exists");
-            continue;
-          }
-          pointToPoint.SetDeviceAttribute ("DataRate", DataRateValue(DataRate("1Gbps")));
-          pointToPoint.SetChannelAttribute("Delay", TimeValue(Time::FromDouble(m_linkLatency, Time::MS))); 
-          NetDeviceContainer p2pDevices = 
-            pointToPoint.Install (m_nodes.Get(i), m_nodes.Get(*iterator));
-          m_nodeDevices[i].Add(p2pDevices.Get(0));
-          //p2pDevices.Get(0)->TraceConnectWithoutContext("MacTxDrop", MakeCallback(&NodeCallback::PhyDropTrace, &m_callbacks[i]));
-          m_nodeDevices[*iterator].Add(p2pDevices.Get(1));
-          //p2pDevices.Get(1)->TraceConnectWithoutContext("MacTxDrop", MakeCallback(&NodeCallback::PhyDropTrace, &m_callbacks[*iterator]));
-          m_linkDevices.push_back(p2pDevices);
-          PointToPointChannel* channel = (PointToPointChannel*)GetPointer(p2pDevices.Get(0)->GetChannel());
-          m_channels.push_back(channel);
-          NS_LOG_LOGIC ("Adding link " << normalizedLink.first << " " << normalizedLink.second);
-          m_channelMap[normalizedLink] = channel;
-        }
+        m_callbacks.push_back(NodeCallback(m_graph.GetId(i), this));
       }
 
-      InternetStackHelper stack;
-      stack.Install (m_nodes);
-      Ipv4AddressHelper address;
-      address.SetBase ("10.1.1.0", "255.255.255.0");
-      NS_LOG_INFO("Assigning address");
-      for (int i = 0; i < (int)m_linkDevices.size(); i++) {
-        Ipv4InterfaceContainer current = address.Assign(m_linkDevices[i]);
-        address.NewNetwork();
-      }
-      NS_LOG_INFO("Assigned addresses");
-
-      for (NodeList::Iterator it = NodeList::Begin(); it != NodeList::End(); it++) {
-        Ptr<Node> node = *it;
-        Ptr<Ipv4> ipv4 = node->GetObject<Ipv4>();
-        for (uint32_t i = 1; i < ipv4->GetNInterfaces (); i++) {
-          for (uint32_t j = 0; j < ipv4->GetNAddresses (i); j++) {
-            m_addressToNodeMap[ipv4->GetAddress(i, j).GetLocal ()] = node->GetId(); 
-          }
-        }
-      }
-      NS_LOG_INFO("Added addresses");
-
       Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
 
       NS_LOG_INFO("Done populating routing table");
@@ -298,6 +195,14 @@ class Topology : public Object
       SimulationSingleton<GlobalRouteManagerImpl>::Get ()->SendHeartbeats();
     }
     
+    // The link between two nodes, named as in the topology file
+    uint32_t GetLink(std::pair<uint32_t, uint32_t> key)
+    {
+      uint32_t link = m_links.GetLink(m_graph.GetNode(key.first), m_graph.GetNode(key.second));
+      NS_ABORT_MSG_IF(link == PointToPointTopologyHelper::NO_LINK, "No link between " << key.first << " and " << key.second);
+      return link;
+    }
+
     void FailLink (uint32_t from, uint32_t to)
     {
       NS_ASSERT(from < to);
@@ -309,50 +214,50 @@ class Topology : public Object
     {
       NS_LOG_LOGIC("Failing link between " << key.first << " and " << key.second);
       std::cout << Simulator::Now() << " " <<  key.first << "," << key.second << ",F" << std::endl;
-      m_channelMap[key]->SetLinkDown();
+      m_links.GetLinkChannel(GetLink(key))->SetLinkDown();
     }
 
+    void SetScheduleWindow (double window)
+    {
+      m_scheduleWindow = Seconds(window);
+    }
+
+    // The schedule is read a window at a time as the simulation runs
     void ScheduleEvents (std::string schedule)
     {
-      std::ifstream scheduleFile(schedule.c_str());
-      NS_ASSERT(scheduleFile.is_open());
-      while (scheduleFile.good()) {
-        std::string input;
-        getline(scheduleFile, input);
-        if (input.empty()) {
-          continue;
-        }
-        std::vector<std::string> parts;
-        boost::split(parts, input, boost::is_any_of(" "));
-        double time = (double)std::atof(parts[0].c_str());
-        bool query = (parts[1].compare("q") == 0);
-        bool linkfail = (parts[1].compare("f") == 0);
-        if (query) {
-          std::cout << input << std::endl;
-          uint32_t client = std::atoi(parts[2].c_str());
-          uint32_t serverIndex = std::atoi(parts[3].c_str());
-          Ipv4Address server  = m_nodes.Get(PhysicalNode(serverIndex))->GetObject<Ipv4>()->GetAddress(1, 0).GetLocal();
-          std::cerr << m_partClients[client];
-          Simulator::Schedule(Seconds(time), &WanSendApplication::IssueRequest, m_partClients[client], InetSocketAddress(server, 5000), serverIndex, (uint64_t)std::atof(parts[4].c_str()));
-        }
-        else if (linkfail) {
-          for (uint32_t it3 = 2; it3 < parts.size(); it3++) {
-            std::vector<std::string> nodeParts;
-            boost::split(nodeParts, parts[it3], boost::is_any_of("="));
-            NS_ASSERT(nodeParts.size() == 2);
-            uint32_t node0 = std::atoi(nodeParts[0].c_str());
-            uint32_t node1 = std::atoi(nodeParts[1].c_str());
-            std::pair<uint32_t, uint32_t> key = std::pair<uint32_t, uint32_t>(std::min(node0, node1), std::max(node0, node1));
-            NS_LOG_LOGIC (node0 << " " << node1 << " " << nodeParts[0] << " " << nodeParts[1]);
-            NS_ASSERT(m_channelMap[key] != 0);
-            //NS_ASSERT(m_channelMap[std::pair<uint32_t, uint32_t>(std::min(node0, node1), std::max(node0, node1))] != 0);
-            if (m_fail) {
-              Simulator::Schedule(Seconds(time), &Topology::FailLink, this, std::min(node0, node1), std::max(node0, node1));
-            }
+      m_schedule.Open(schedule, m_scheduleWindow, this, &Topology::ScheduleLine);
+      std::cout << "Done scheduling" << std::endl;
+    }
+
+    void ScheduleLine (const std::string& input, Time delay)
+    {
+      std::vector<std::string> parts;
+      boost::split(parts, input, boost::is_any_of(" "));
+      bool query = (parts[1].compare("q") == 0);
+      bool linkfail = (parts[1].compare("f") == 0);
+      if (query) {
+        std::cout << input << std::endl;
+        uint32_t client = std::atoi(parts[2].c_str());
+        uint32_t serverIndex = std::atoi(parts[3].c_str());
+        Ipv4Address server  = m_nodes.Get(PhysicalNode(serverIndex))->GetObject<Ipv4>()->GetAddress(1, 0).GetLocal();
+        std::cerr << m_partClients[client];
+        Simulator::Schedule(delay, &WanSendApplication::IssueRequest, m_partClients[client], InetSocketAddress(server, 5000), serverIndex, (uint64_t)std::atof(parts[4].c_str()));
+      }
+      else if (linkfail) {
+        for (uint32_t it3 = 2; it3 < parts.size(); it3++) {
+          std::vector<std::string> nodeParts;
+          boost::split(nodeParts, parts[it3], boost::is_any_of("="));
+          NS_ASSERT(nodeParts.size() == 2);
+          uint32_t node0 = std::atoi(nodeParts[0].c_str());
+          uint32_t node1 = std::atoi(nodeParts[1].c_str());
+          std::pair<uint32_t, uint32_t> key = std::pair<uint32_t, uint32_t>(std::min(node0, node1), std::max(node0, node1));
+          NS_LOG_LOGIC (node0 << " " << node1 << " " << nodeParts[0] << " " << nodeParts[1]);
+          NS_ASSERT(m_links.GetLink(PhysicalNode(key.first), PhysicalNode(key.second)) != PointToPointTopologyHelper::NO_LINK);
+          if (m_fail) {
+            Simulator::Schedule(delay, &Topology::FailLink, this, std::min(node0, node1), std::max(node0, node1));
           }
         }
       }
-      std::cout << "Done scheduling" << std::endl;
     }
 };
 
@@ -430,16 +335,20 @@ main (int argc, char *argv[])
 
   Ptr<OutputStreamWrapper> stream = asciiHelper.CreateFileStream ("tcp-trace.tr");
   std::string topology;
+  std::string hosts;
   double delay = 0.0;
   double linkLatency = 0.5;
   std::string schedule;
+  double window = 1.0;
   bool repair;
   bool fail = true;
   CommandLine cmd;
   cmd.AddValue("topology", "Topology file", topology);
+  cmd.AddValue("hosts", "End host list (an .es file), besides the hosts marked in the topology", hosts);
   cmd.AddValue("delay", "Delay for repairs", delay);
   cmd.AddValue("latency", "Propagation delay (ms)", linkLatency);
   cmd.AddValue("schedule", "Simulation schedule", schedule);
+  cmd.AddValue("window", "Seconds of the schedule to read ahead of the simulation", window);
   cmd.AddValue("repair", "Allow reversals", repair);
   cmd.AddValue("fail",  "Actually fail links", fail);
   cmd.Parse(argc, argv);
@@ -450,7 +359,8 @@ main (int argc, char *argv[])
   simulationTopology.SetRepair(repair);
   simulationTopology.SetDelay(delay);
   simulationTopology.SetPropagationDelay(linkLatency);
-  simulationTopology.PopulateGraph(topology);
+  simulationTopology.SetScheduleWindow(window);
+  simulationTopology.PopulateGraph(topology, hosts);
   simulationTopology.HookupSimulation();
   simulationTopology.ScheduleEvents(schedule);
   Simulator::Run ();
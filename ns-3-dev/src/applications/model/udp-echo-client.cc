@@ -119,6 +119,11 @@ void
 UdpEchoClient::DoDispose (void)
 {
   NS_LOG_FUNCTION_NOARGS ();
+  for (std::list<Burst>::iterator it = m_bursts.begin (); it != m_bursts.end (); it++)
+    {
+      Simulator::Cancel (it->m_event);
+    }
+  m_bursts.clear ();
   Application::DoDispose ();
 }
 
@@ -333,38 +338,75 @@ UdpEchoClient::SendInternal (Ptr<Packet> p)
 }
 
 void 
-UdpEchoClient::SendBurst (uint32_t burstLength, Time time)
+UdpEchoClient::SendBurst (uint32_t burstLength, Time interval)
+{
+  NS_LOG_FUNCTION (this << burstLength << interval);
+  Burst burst;
+  burst.m_remaining = burstLength;
+  burst.m_count = 0;
+  burst.m_interval = interval;
+  burst.m_paced = false;
+  // A RandomVariable cannot be copied until it holds a distribution
+  burst.m_pacing = ConstantVariable (0);
+  StartBurst (burst);
+}
+
+void 
+UdpEchoClient::SendPacedBurst (uint32_t burstLength, RandomVariable pacing)
+{
+  NS_LOG_FUNCTION (this << burstLength);
+  Burst burst;
+  burst.m_remaining = burstLength;
+  burst.m_count = 0;
+  burst.m_paced = true;
+  burst.m_pacing = pacing;
+  StartBurst (burst);
+}
+
+void
+UdpEchoClient::StartBurst (const Burst &burst)
+{
+  if (burst.m_remaining == 0)
+    {
+      return;
+    }
+  std::list<Burst>::iterator it = m_bursts.insert (m_bursts.end (), burst);
+  it->m_event = Simulator::Schedule (Simulator::Now (), &UdpEchoClient::SendBurstPacket, this, it);
+}
+
+void
+UdpEchoClient::SendBurstPacket (std::list<Burst>::iterator burst)
 {
   NS_LOG_FUNCTION_NOARGS ();
-  uint32_t burstCount = 0;
-  Time packetTime = Simulator::Now();
-  while (burstLength > 0) {
-    Ptr<Packet> p;
-    p = Create<Packet> ((uint8_t*)&burstCount, sizeof(burstCount));
-    burstCount++;
-    burstLength--;
-    // call to the trace sinks before the packet is actually sent,
-    // so that tags added to the packet can be sent as well
-    Simulator::Schedule(packetTime, &UdpEchoClient::SendInternal, this, p);
-    packetTime = packetTime + time;
-    ++m_sent;
-
-    if (Ipv4Address::IsMatchingType (m_peerAddress))
-      {
-        NS_LOG_INFO ("At time " << Simulator::Now ().GetSeconds () << "s client sent " << m_size << " bytes to " <<
-                     Ipv4Address::ConvertFrom (m_peerAddress) << " port " << m_peerPort);
-      }
-    else if (Ipv6Address::IsMatchingType (m_peerAddress))
-      {
-        NS_LOG_INFO ("At time " << Simulator::Now ().GetSeconds () << "s client sent " << m_size << " bytes to " <<
-                     Ipv6Address::ConvertFrom (m_peerAddress) << " port " << m_peerPort);
-      }
-  }
+  uint32_t burstCount = burst->m_count;
+  Ptr<Packet> p = Create<Packet> ((uint8_t*)&burstCount, sizeof(burstCount));
+  burst->m_count++;
+  burst->m_remaining--;
+  ++m_sent;
 
-  //if (m_sent < m_count) 
-  //  {
-  //    ScheduleTransmit (m_interval);
-  //  }
+  if (Ipv4Address::IsMatchingType (m_peerAddress))
+    {
+      NS_LOG_INFO ("At time " << Simulator::Now ().GetSeconds () << "s client sent " << m_size << " bytes to " <<
+                   Ipv4Address::ConvertFrom (m_peerAddress) << " port " << m_peerPort);
+    }
+  else if (Ipv6Address::IsMatchingType (m_peerAddress))
+    {
+      NS_LOG_INFO ("At time " << Simulator::Now ().GetSeconds () << "s client sent " << m_size << " bytes to " <<
+                   Ipv6Address::ConvertFrom (m_peerAddress) << " port " << m_peerPort);
+    }
+
+  // Schedule the next packet before sending this one, so that it is queued
+  // ahead of anything the send itself schedules for the same time
+  if (burst->m_remaining > 0)
+    {
+      Time next = burst->m_paced ? Seconds (burst->m_pacing.GetValue ()) : burst->m_interval;
+      burst->m_event = Simulator::Schedule (next, &UdpEchoClient::SendBurstPacket, this, burst);
+    }
+  else
+    {
+      m_bursts.erase (burst);
+    }
+  SendInternal (p);
 }
 
 void
@@ -25,6 +25,9 @@
 #include "ns3/ipv4-address.h"
 #include "ns3/traced-callback.h"
 #include "ns3/ipv4-header.h"
+#include "ns3/nstime.h"
+#include "ns3/random-variable.h"
+#include <list>
 
 namespace ns3 {
 
@@ -123,7 +126,26 @@ public:
    */
   void SetFill (uint8_t *fill, uint32_t fillSize, uint32_t dataSize);
 
-  void SendBurst (uint32_t, Time);
+  /**
+   * Send burstLength packets, each carrying its 32 bit position in the
+   * burst, interval apart. The first packet leaves after a delay equal to
+   * the current simulation time. Packets are created as they are sent, and
+   * a burst only ever has its next packet scheduled, so long bursts cost
+   * one pending event rather than one per packet.
+   *
+   * \param burstLength The number of packets to send.
+   * \param interval The time between consecutive packets.
+   */
+  void SendBurst (uint32_t burstLength, Time interval);
+
+  /**
+   * Send a burst like SendBurst, with the time between consecutive packets
+   * drawn from pacing, in seconds, as each packet is sent.
+   *
+   * \param burstLength The number of packets to send.
+   * \param pacing The distribution of the time between packets.
+   */
+  void SendPacedBurst (uint32_t burstLength, RandomVariable pacing);
   void Send (void);
   virtual void StartApplication (void);
   virtual void StopApplication (void);
@@ -136,7 +158,19 @@ protected:
 
 private:
 
+  struct Burst
+  {
+    uint32_t m_remaining;
+    uint32_t m_count;
+    Time m_interval;
+    bool m_paced;
+    RandomVariable m_pacing;
+    EventId m_event;
+  };
+
   void SendInternal (Ptr<Packet> p);
+  void StartBurst (const Burst &burst);
+  void SendBurstPacket (std::list<Burst>::iterator burst);
   void ScheduleTransmit (Time dt);
 
   void HandleRead (Ptr<Socket> socket);
@@ -152,6 +186,7 @@ private:
   Address m_peerAddress;
   uint16_t m_peerPort;
   EventId m_sendEvent;
+  std::list<Burst> m_bursts;
   /// Callbacks for tracing the packet Tx events
   TracedCallback<Ptr<const Packet>, uint32_t, Ipv4Address > m_txTrace;
   /// Callbacks for tracing the packet Rx events
@@ -71,5 +71,17 @@ Ipv4GlobalRoutingHelper::RecomputeRoutingTables (void)
   GlobalRouteManager::InitializeRoutes ();
 }
 
+void
+Ipv4GlobalRoutingHelper::SaveRoutingState (void)
+{
+  GlobalRouteManager::SaveRoutingState ();
+}
+
+void
+Ipv4GlobalRoutingHelper::RestoreRoutingState (void)
+{
+  GlobalRouteManager::RestoreRoutingState ();
+}
+
 
 } // namespace ns3
@@ -83,6 +83,22 @@ public:
    *
    */
   static void RecomputeRoutingTables (void);
+  /**
+   * \brief Remember which links are up and the routing state of every node
+   * (DDC link directions, sequence numbers, vnodes, priorities and the
+   * distances they come from).
+   *
+   * Together with RestoreRoutingState() this lets one process run many
+   * failure scenarios on a topology built and populated once: save after
+   * PopulateRoutingTables() and the initial Simulator::Run(), then restore
+   * after every scenario. Call both while nothing routing related is
+   * scheduled.
+   */
+  static void SaveRoutingState (void);
+  /**
+   * \brief Go back to the links and routing state SaveRoutingState() saw
+   */
+  static void RestoreRoutingState (void);
 private:
   /**
    * \internal
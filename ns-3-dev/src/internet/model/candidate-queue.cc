@@ -44,22 +44,25 @@ operator<< (std::ostream& os, const CandidateQueue& q)
 {
   typedef CandidateQueue::CandidateList_t List_t;
   typedef List_t::const_iterator CIter_t;
-  const CandidateQueue::CandidateList_t& list = q.m_candidates;
+  List_t list = q.m_candidates;
+  std::sort (list.begin (), list.end (), &CandidateQueue::CompareCandidate);
 
   os << "*** CandidateQueue Begin (<id, distance, LSA-type>) ***" << std::endl;
   for (CIter_t iter = list.begin (); iter != list.end (); iter++)
     {
       os << "<" 
-      << (*iter)->GetVertexId () << ", "
-      << (*iter)->GetDistanceFromRoot () << ", "
-      << (*iter)->GetVertexType () << ">" << std::endl;
+      << iter->m_vertex->GetVertexId () << ", "
+      << iter->m_vertex->GetDistanceFromRoot () << ", "
+      << iter->m_vertex->GetVertexType () << ">" << std::endl;
     }
   os << "*** CandidateQueue End ***";
   return os;
 }
 
 CandidateQueue::CandidateQueue()
-  : m_candidates ()
+  : m_candidates (),
+    m_index (),
+    m_sequence (0)
 {
   NS_LOG_FUNCTION_NOARGS ();
 }
@@ -87,11 +90,12 @@ CandidateQueue::Push (SPFVertex *vNew)
 {
   NS_LOG_FUNCTION (this << vNew);
 
-  CandidateList_t::iterator i = std::upper_bound (
-      m_candidates.begin (), m_candidates.end (), vNew,
-      &CandidateQueue::CompareSPFVertex
-      );
-  m_candidates.insert (i, vNew);
+  Candidate c;
+  c.m_vertex = vNew;
+  c.m_sequence = m_sequence++;
+  m_candidates.push_back (c);
+  m_index[vNew->GetVertexId ()] = m_candidates.size () - 1;
+  SiftUp (m_candidates.size () - 1);
 }
 
 SPFVertex *
@@ -103,8 +107,19 @@ CandidateQueue::Pop (void)
       return 0;
     }
 
-  SPFVertex *v = m_candidates.front ();
-  m_candidates.pop_front ();
+  SPFVertex *v = m_candidates.front ().m_vertex;
+  CandidateIndex_t::iterator i = m_index.find (v->GetVertexId ());
+  if (i != m_index.end () && i->second == 0)
+    {
+      m_index.erase (i);
+    }
+  Candidate last = m_candidates.back ();
+  m_candidates.pop_back ();
+  if (!m_candidates.empty ())
+    {
+      Place (last, 0);
+      SiftDown (0);
+    }
   return v;
 }
 
@@ -117,7 +132,7 @@ CandidateQueue::Top (void) const
       return 0;
     }
 
-  return m_candidates.front ();
+  return m_candidates.front ().m_vertex;
 }
 
 bool
@@ -138,18 +153,12 @@ SPFVertex *
 CandidateQueue::Find (const Ipv4Address addr) const
 {
   NS_LOG_FUNCTION_NOARGS ();
-  CandidateList_t::const_iterator i = m_candidates.begin ();
-
-  for (; i != m_candidates.end (); i++)
+  CandidateIndex_t::const_iterator i = m_index.find (addr);
+  if (i == m_index.end ())
     {
-      SPFVertex *v = *i;
-      if (v->GetVertexId () == addr)
-        {
-          return v;
-        }
+      return 0;
     }
-
-  return 0;
+  return m_candidates[i->second].m_vertex;
 }
 
 void
@@ -157,11 +166,90 @@ CandidateQueue::Reorder (void)
 {
   NS_LOG_FUNCTION_NOARGS ();
 
-  m_candidates.sort (&CandidateQueue::CompareSPFVertex);
+  // Rebuild the whole heap from the bottom up, since any number of keys may
+  // have changed
+  for (uint32_t i = m_candidates.size () / 2; i-- > 0; )
+    {
+      SiftDown (i);
+    }
   NS_LOG_LOGIC ("After reordering the CandidateQueue");
   NS_LOG_LOGIC (*this);
 }
 
+void
+CandidateQueue::Update (SPFVertex *v)
+{
+  NS_LOG_FUNCTION (this << v);
+
+  CandidateIndex_t::iterator i = m_index.find (v->GetVertexId ());
+  NS_ASSERT_MSG (i != m_index.end () && m_candidates[i->second].m_vertex == v,
+                 "CandidateQueue::Update (): vertex is not in the queue");
+  // A vertex whose key changed goes behind the vertices it now ties with,
+  // as it would have after a stable sort of the old list
+  m_candidates[i->second].m_sequence = m_sequence++;
+  SiftUp (i->second);
+}
+
+void
+CandidateQueue::Place (const Candidate &c, uint32_t slot)
+{
+  m_candidates[slot] = c;
+  m_index[c.m_vertex->GetVertexId ()] = slot;
+}
+
+void
+CandidateQueue::SiftUp (uint32_t slot)
+{
+  Candidate c = m_candidates[slot];
+  while (slot > 0)
+    {
+      uint32_t parent = (slot - 1) / 2;
+      if (!CompareCandidate (c, m_candidates[parent]))
+        {
+          break;
+        }
+      Place (m_candidates[parent], slot);
+      slot = parent;
+    }
+  Place (c, slot);
+}
+
+void
+CandidateQueue::SiftDown (uint32_t slot)
+{
+  Candidate c = m_candidates[slot];
+  uint32_t size = m_candidates.size ();
+  while (2 * slot + 1 < size)
+    {
+      uint32_t child = 2 * slot + 1;
+      if (child + 1 < size && CompareCandidate (m_candidates[child + 1], m_candidates[child]))
+        {
+          child++;
+        }
+      if (!CompareCandidate (m_candidates[child], c))
+        {
+          break;
+        }
+      Place (m_candidates[child], slot);
+      slot = child;
+    }
+  Place (c, slot);
+}
+
+bool
+CandidateQueue::CompareCandidate (const Candidate &c1, const Candidate &c2)
+{
+  if (CompareSPFVertex (c1.m_vertex, c2.m_vertex))
+    {
+      return true;
+    }
+  if (CompareSPFVertex (c2.m_vertex, c1.m_vertex))
+    {
+      return false;
+    }
+  return c1.m_sequence < c2.m_sequence;
+}
+
 /*
  * In this implementation, SPFVertex follows the ordering where
  * a vertex is ranked first if its GetDistanceFromRoot () is smaller;
@@ -22,8 +22,9 @@
 #define CANDIDATE_QUEUE_H
 
 #include <stdint.h>
-#include <list>
+#include <vector>
 #include "ns3/ipv4-address.h"
+#include "ns3/sgi-hashmap.h"
 
 namespace ns3 {
 
@@ -45,6 +46,11 @@ class SPFVertex;
  * for a Find () operation, the dynamic nature of the data and the derived
  * requirement for a Reorder () operation led us to implement this simple 
  * enhanced priority queue.
+ *
+ * The queue is a binary heap with an index from vertex ID to heap slot, so
+ * Push, Pop and Update take O(log n) and Find takes O(1).  Vertices with
+ * equal keys are popped in the order they were pushed (or last updated),
+ * which is the order the original sorted list gave.
  */
 class CandidateQueue
 {
@@ -162,6 +168,19 @@ public:
  */
   void Reorder (void);
 
+/**
+ * @brief Restore the priority order after the m_distanceFromRoot of a
+ * single vertex in the queue has been lowered.
+ * @internal
+ *
+ * This is the decrease-key operation of the heap and is much cheaper than
+ * Reorder () when only one vertex changed.
+ *
+ * @see SPFVertex
+ * @param v The Shortest Path First Vertex whose distance decreased.
+ */
+  void Update (SPFVertex *v);
+
 private:
 /**
  * Candidate Queue copy construction is disallowed (not implemented) to 
@@ -189,8 +208,24 @@ private:
  */
   static bool CompareSPFVertex (const SPFVertex* v1, const SPFVertex* v2);
 
-  typedef std::list<SPFVertex*> CandidateList_t;
+  /// A vertex in the heap and the order it was pushed in
+  struct Candidate
+  {
+    SPFVertex *m_vertex;
+    uint64_t m_sequence;
+  };
+  typedef std::vector<Candidate> CandidateList_t;
+  typedef sgi::hash_map<Ipv4Address, uint32_t, Ipv4AddressHash> CandidateIndex_t;
+
+  /// True if c1 should be popped before c2
+  static bool CompareCandidate (const Candidate &c1, const Candidate &c2);
+  void Place (const Candidate &c, uint32_t slot);
+  void SiftUp (uint32_t slot);
+  void SiftDown (uint32_t slot);
+
   CandidateList_t m_candidates;
+  CandidateIndex_t m_index;
+  uint64_t m_sequence;
 
   friend std::ostream& operator<< (std::ostream& os, const CandidateQueue& q);
 };
@@ -0,0 +1,228 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <algorithm>
+#include "ns3/assert.h"
+#include "ns3/log.h"
+#include "ns3/packet.h"
+#include "ipv4-interface.h"
+#include "ddc-control-protocol.h"
+
+NS_LOG_COMPONENT_DEFINE ("DdcControlProtocol");
+
+namespace ns3 {
+
+NS_OBJECT_ENSURE_REGISTERED (DdcControlHeader);
+
+DdcControlHeader::DdcControlHeader ()
+{
+}
+
+void
+DdcControlHeader::AddMessage (MessageType type, Ipv4Address address, uint32_t value)
+{
+  Message message;
+  message.m_type = type;
+  message.m_address = address;
+  message.m_value = value;
+  m_messages.push_back (message);
+}
+
+uint32_t
+DdcControlHeader::GetNMessages (void) const
+{
+  return m_messages.size ();
+}
+
+const DdcControlHeader::Message&
+DdcControlHeader::GetMessage (uint32_t i) const
+{
+  NS_ASSERT (i < m_messages.size ());
+  return m_messages[i];
+}
+
+void
+DdcControlHeader::Clear (void)
+{
+  m_messages.clear ();
+}
+
+TypeId
+DdcControlHeader::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::DdcControlHeader")
+    .SetParent<Header> ()
+    .AddConstructor<DdcControlHeader> ()
+  ;
+  return tid;
+}
+
+TypeId
+DdcControlHeader::GetInstanceTypeId (void) const
+{
+  return GetTypeId ();
+}
+
+void
+DdcControlHeader::Print (std::ostream &os) const
+{
+  os << "messages " << m_messages.size ();
+  for (std::vector<Message>::const_iterator it = m_messages.begin (); it != m_messages.end (); it++)
+    {
+      os << " (" << (uint32_t)it->m_type << " " << it->m_address << " " << it->m_value << ")";
+    }
+}
+
+uint32_t
+DdcControlHeader::GetMaxMessages (uint32_t payload)
+{
+  if (payload < 2 + 9)
+    {
+      return 1;
+    }
+  return std::min<uint32_t> ((payload - 2) / 9, 0xffff);
+}
+
+uint32_t
+DdcControlHeader::GetSerializedSize (void) const
+{
+  // Count, then type, address and value for each message
+  return 2 + m_messages.size () * 9;
+}
+
+void
+DdcControlHeader::Serialize (Buffer::Iterator start) const
+{
+  Buffer::Iterator i = start;
+  i.WriteHtonU16 (m_messages.size ());
+  for (std::vector<Message>::const_iterator it = m_messages.begin (); it != m_messages.end (); it++)
+    {
+      i.WriteU8 (it->m_type);
+      i.WriteHtonU32 (it->m_address.Get ());
+      i.WriteHtonU32 (it->m_value);
+    }
+}
+
+uint32_t
+DdcControlHeader::Deserialize (Buffer::Iterator start)
+{
+  Buffer::Iterator i = start;
+  uint16_t count = i.ReadNtohU16 ();
+  m_messages.resize (count);
+  for (uint16_t j = 0; j < count; j++)
+    {
+      m_messages[j].m_type = i.ReadU8 ();
+      m_messages[j].m_address.Set (i.ReadNtohU32 ());
+      m_messages[j].m_value = i.ReadNtohU32 ();
+    }
+  return GetSerializedSize ();
+}
+
+NS_OBJECT_ENSURE_REGISTERED (DdcControlProtocol);
+
+const uint8_t DdcControlProtocol::PROT_NUMBER = 253;
+
+TypeId
+DdcControlProtocol::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::DdcControlProtocol")
+    .SetParent<IpL4Protocol> ()
+    .AddConstructor<DdcControlProtocol> ()
+  ;
+  return tid;
+}
+
+DdcControlProtocol::DdcControlProtocol ()
+{
+}
+
+DdcControlProtocol::~DdcControlProtocol ()
+{
+}
+
+void
+DdcControlProtocol::SetReceiveCallback (ReceiveCallback callback)
+{
+  m_receive = callback;
+}
+
+uint16_t
+DdcControlProtocol::GetStaticProtocolNumber (void)
+{
+  return PROT_NUMBER;
+}
+
+int
+DdcControlProtocol::GetProtocolNumber (void) const
+{
+  return PROT_NUMBER;
+}
+
+enum IpL4Protocol::RxStatus
+DdcControlProtocol::Receive (Ptr<Packet> p,
+                             Ipv4Header const &header,
+                             Ptr<Ipv4Interface> incomingInterface)
+{
+  NS_LOG_FUNCTION (this << p << header << incomingInterface);
+  if (m_receive.IsNull ())
+    {
+      return IpL4Protocol::RX_ENDPOINT_UNREACH;
+    }
+  m_receive (p, header, incomingInterface);
+  return IpL4Protocol::RX_OK;
+}
+
+enum IpL4Protocol::RxStatus
+DdcControlProtocol::Receive (Ptr<Packet> p,
+                             Ipv6Address &src,
+                             Ipv6Address &dst,
+                             Ptr<Ipv6Interface> incomingInterface)
+{
+  return IpL4Protocol::RX_ENDPOINT_UNREACH;
+}
+
+void
+DdcControlProtocol::DoDispose (void)
+{
+  m_receive.Nullify ();
+  m_downTarget.Nullify ();
+  IpL4Protocol::DoDispose ();
+}
+
+void
+DdcControlProtocol::SetDownTarget (IpL4Protocol::DownTargetCallback callback)
+{
+  m_downTarget = callback;
+}
+
+void
+DdcControlProtocol::SetDownTarget6 (IpL4Protocol::DownTargetCallback6 callback)
+{
+}
+
+IpL4Protocol::DownTargetCallback
+DdcControlProtocol::GetDownTarget (void) const
+{
+  return m_downTarget;
+}
+
+IpL4Protocol::DownTargetCallback6
+DdcControlProtocol::GetDownTarget6 (void) const
+{
+  return (IpL4Protocol::DownTargetCallback6)NULL;
+}
+
+} // namespace ns3
@@ -0,0 +1,134 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef DDC_CONTROL_PROTOCOL_H
+#define DDC_CONTROL_PROTOCOL_H
+
+#include <vector>
+#include <stdint.h>
+#include "ns3/header.h"
+#include "ns3/callback.h"
+#include "ns3/ipv4-address.h"
+#include "ip-l4-protocol.h"
+
+namespace ns3 {
+
+class Packet;
+class Ipv4Interface;
+
+/**
+ * @apanda
+ * \brief A batch of DDC control messages exchanged between neighbours.
+ *
+ * Each message names the destination it is about, so one packet can carry
+ * lock, vnode and heartbeat traffic for many destinations at once.
+ */
+class DdcControlHeader : public Header
+{
+public:
+  enum MessageType
+  {
+    LOCK = 1,
+    LOCK_GRANTED = 2,
+    LOCK_DENIED = 3,
+    UNLOCK = 4,
+    SET_VNODE = 5,
+    HEARTBEAT = 6,
+    ROUND = 7
+  };
+
+  struct Message
+  {
+    uint8_t m_type;
+    Ipv4Address m_address;
+    /// Vnode for SET_VNODE, sequence number for HEARTBEAT and ROUND,
+    /// otherwise 0
+    uint32_t m_value;
+  };
+
+  DdcControlHeader ();
+
+  void AddMessage (MessageType type, Ipv4Address address, uint32_t value);
+  uint32_t GetNMessages (void) const;
+  const Message& GetMessage (uint32_t i) const;
+  void Clear (void);
+
+  /**
+   * \returns the most messages one header can hold in payload bytes, at
+   * least one
+   */
+  static uint32_t GetMaxMessages (uint32_t payload);
+
+  static TypeId GetTypeId (void);
+  virtual TypeId GetInstanceTypeId (void) const;
+  virtual void Print (std::ostream &os) const;
+  virtual uint32_t GetSerializedSize (void) const;
+  virtual void Serialize (Buffer::Iterator start) const;
+  virtual uint32_t Deserialize (Buffer::Iterator start);
+
+private:
+  std::vector<Message> m_messages;
+};
+
+/**
+ * @apanda
+ * \brief IP protocol that hands DDC control packets to the routing protocol.
+ *
+ * Ipv4GlobalRouting inserts one of these into its Ipv4 stack when it uses
+ * the message based control plane. The protocol does no processing of its
+ * own and passes every packet up through the receive callback.
+ */
+class DdcControlProtocol : public IpL4Protocol
+{
+public:
+  /// IANA protocol number reserved for experimentation (RFC 3692)
+  static const uint8_t PROT_NUMBER;
+
+  typedef Callback<void, Ptr<Packet>, const Ipv4Header &, Ptr<Ipv4Interface> > ReceiveCallback;
+
+  static TypeId GetTypeId (void);
+
+  DdcControlProtocol ();
+  virtual ~DdcControlProtocol ();
+
+  void SetReceiveCallback (ReceiveCallback callback);
+
+  static uint16_t GetStaticProtocolNumber (void);
+  virtual int GetProtocolNumber (void) const;
+  virtual enum IpL4Protocol::RxStatus Receive (Ptr<Packet> p,
+                                               Ipv4Header const &header,
+                                               Ptr<Ipv4Interface> incomingInterface);
+  virtual enum IpL4Protocol::RxStatus Receive (Ptr<Packet> p,
+                                               Ipv6Address &src,
+                                               Ipv6Address &dst,
+                                               Ptr<Ipv6Interface> incomingInterface);
+
+  virtual void SetDownTarget (IpL4Protocol::DownTargetCallback cb);
+  virtual void SetDownTarget6 (IpL4Protocol::DownTargetCallback6 cb);
+  virtual IpL4Protocol::DownTargetCallback GetDownTarget (void) const;
+  virtual IpL4Protocol::DownTargetCallback6 GetDownTarget6 (void) const;
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  ReceiveCallback m_receive;
+  IpL4Protocol::DownTargetCallback m_downTarget;
+};
+
+} // namespace ns3
+
+#endif /* DDC_CONTROL_PROTOCOL_H */
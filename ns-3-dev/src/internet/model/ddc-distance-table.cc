@@ -0,0 +1,325 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <algorithm>
+#include <map>
+#include "ns3/assert.h"
+#include "ddc-distance-table.h"
+
+namespace ns3 {
+
+const uint32_t DdcDistanceTable::NO_NODE;
+const uint32_t DdcDistanceTable::UNREACHABLE;
+
+DdcDistanceTable::DdcDistanceTable (uint32_t nNodes)
+  : m_nNodes (nNodes),
+    m_distances ((uint64_t)nNodes * nNodes, UNREACHABLE),
+    m_reversalFrozen (false),
+    m_nodeAddresses (nNodes),
+    m_neighbours (nNodes),
+    m_orders (nNodes)
+{
+  for (uint32_t node = 0; node < nNodes; node++)
+    {
+      m_distances[(uint64_t)node * nNodes + node] = 0;
+    }
+}
+
+DdcDistanceTable::~DdcDistanceTable ()
+{
+  for (uint32_t node = 0; node < m_nNodes; node++)
+    {
+      RetirePriorityOrders (node);
+    }
+  ReleasePriorityOrders ();
+}
+
+uint32_t
+DdcDistanceTable::GetNNodes (void) const
+{
+  return m_nNodes;
+}
+
+void
+DdcDistanceTable::SetDistance (uint32_t from, uint32_t to, uint32_t distance)
+{
+  NS_ASSERT (from < m_nNodes && to < m_nNodes);
+  uint32_t &entry = m_distances[(uint64_t)from * m_nNodes + to];
+  if (m_reversalFrozen && m_reversalDistances.empty () && entry != distance)
+    {
+      m_reversalDistances = m_distances;
+    }
+  entry = distance;
+}
+
+void
+DdcDistanceTable::FreezeReversalOrders (void)
+{
+  m_reversalFrozen = true;
+}
+
+bool
+DdcDistanceTable::UpdateReversalOrders (uint32_t dest)
+{
+  NS_ASSERT (dest < m_nNodes);
+  if (m_reversalDistances.empty ())
+    {
+      return false;
+    }
+  bool changed = false;
+  for (uint32_t node = 0; node < m_nNodes; node++)
+    {
+      uint64_t entry = (uint64_t)node * m_nNodes + dest;
+      if (m_reversalDistances[entry] != m_distances[entry])
+        {
+          m_reversalDistances[entry] = m_distances[entry];
+          changed = true;
+        }
+    }
+  if (!changed)
+    {
+      return false;
+    }
+  // Orders towards dest read the column from every node and its neighbours
+  for (uint32_t node = 0; node < m_nNodes; node++)
+    {
+      std::vector<DdcPriorityOrder *> &row = m_orders[node];
+      if (!row.empty () && row[dest] != 0)
+        {
+          m_retired.push_back (row[dest]);
+          row[dest] = 0;
+        }
+    }
+  return true;
+}
+
+uint32_t
+DdcDistanceTable::GetDistance (uint32_t from, uint32_t to) const
+{
+  NS_ASSERT (from < m_nNodes && to < m_nNodes);
+  return m_distances[(uint64_t)from * m_nNodes + to];
+}
+
+void
+DdcDistanceTable::AddAddress (Ipv4Address address, uint32_t node)
+{
+  NS_ASSERT (node < m_nNodes);
+  m_addresses[address] = node;
+  if (m_nodeAddresses[node] == Ipv4Address ())
+    {
+      m_nodeAddresses[node] = address;
+    }
+}
+
+uint32_t
+DdcDistanceTable::GetNode (Ipv4Address address) const
+{
+  AddressMap::const_iterator it = m_addresses.find (address);
+  if (it == m_addresses.end ())
+    {
+      return NO_NODE;
+    }
+  return it->second;
+}
+
+Ipv4Address
+DdcDistanceTable::GetNodeAddress (uint32_t node) const
+{
+  NS_ASSERT (node < m_nNodes);
+  return m_nodeAddresses[node];
+}
+
+void
+DdcDistanceTable::SetNeighbours (uint32_t node, const std::vector<uint32_t> &neighbours)
+{
+  NS_ASSERT (node < m_nNodes);
+  m_neighbours[node] = neighbours;
+  RetirePriorityOrders (node);
+}
+
+const DdcPriorityOrder*
+DdcDistanceTable::GetPriorityOrder (uint32_t node, uint32_t dest)
+{
+  NS_ASSERT (node < m_nNodes && dest < m_nNodes);
+  std::vector<DdcPriorityOrder *> &row = m_orders[node];
+  if (row.empty ())
+    {
+      row.assign (m_nNodes, 0);
+    }
+  if (row[dest] == 0)
+    {
+      row[dest] = new DdcPriorityOrder ();
+      BuildPriorityOrder (node, dest, *row[dest]);
+    }
+  return row[dest];
+}
+
+void
+DdcDistanceTable::SortNeighbours (uint32_t node, uint32_t dest, const std::vector<uint32_t> &distances,
+                                  std::vector<std::pair<uint32_t, uint32_t> > &sorted) const
+{
+  const std::vector<uint32_t> &neighbours = m_neighbours[node];
+  // Order the node and its neighbours by (distance to destination, node ID);
+  // a neighbour reached over several interfaces is represented by the first
+  std::map<uint32_t, uint32_t> nodeInterface;
+  std::vector<std::pair<uint32_t, uint32_t> > nodes;
+  nodeInterface.insert (std::make_pair (node, 0));
+  nodes.push_back (std::make_pair (distances[(uint64_t)node * m_nNodes + dest], node));
+  for (uint32_t i = 1; i < neighbours.size (); i++)
+    {
+      if (neighbours[i] == NO_NODE)
+        {
+          continue;
+        }
+      nodeInterface.insert (std::make_pair (neighbours[i], i));
+      nodes.push_back (std::make_pair (distances[(uint64_t)neighbours[i] * m_nNodes + dest], neighbours[i]));
+    }
+  std::sort (nodes.begin (), nodes.end ());
+  sorted.clear ();
+  for (std::vector<std::pair<uint32_t, uint32_t> >::const_iterator it = nodes.begin (); it != nodes.end (); it++)
+    {
+      sorted.push_back (std::make_pair (it->first, nodeInterface[it->second]));
+    }
+}
+
+void
+DdcDistanceTable::SaveDistances (void)
+{
+  m_savedDistances = m_distances;
+  m_savedReversalDistances = m_reversalDistances;
+}
+
+void
+DdcDistanceTable::RestoreDistances (void)
+{
+  NS_ASSERT_MSG (m_savedDistances.size () == m_distances.size (), "No distances were saved");
+  if (m_distances == m_savedDistances && m_reversalDistances == m_savedReversalDistances)
+    {
+      return;
+    }
+  m_distances = m_savedDistances;
+  m_reversalDistances = m_savedReversalDistances;
+  for (uint32_t node = 0; node < m_nNodes; node++)
+    {
+      RetirePriorityOrders (node);
+    }
+}
+
+void
+DdcDistanceTable::BuildPriorityOrder (uint32_t node, uint32_t dest, DdcPriorityOrder &order) const
+{
+  uint32_t nInterfaces = std::max<uint32_t> (m_neighbours[node].size (), 1);
+  std::vector<std::pair<uint32_t, uint32_t> > nodes;
+  SortNeighbours (node, dest, m_distances, nodes);
+  order.m_priority.assign (nInterfaces, 0);
+  std::vector<bool> seen (nInterfaces, false);
+  std::vector<uint32_t> reverse;
+  for (std::vector<std::pair<uint32_t, uint32_t> >::const_iterator it = nodes.begin (); it != nodes.end (); it++)
+    {
+      uint32_t iface = it->second;
+      reverse.push_back (iface);
+      if (!seen[iface])
+        {
+          seen[iface] = true;
+          if (iface != 0)
+            {
+              order.m_priority[iface] = it->first;
+            }
+        }
+    }
+  if (!m_reversalDistances.empty ())
+    {
+      SortNeighbours (node, dest, m_reversalDistances, nodes);
+      reverse.clear ();
+      for (std::vector<std::pair<uint32_t, uint32_t> >::const_iterator it = nodes.begin (); it != nodes.end (); it++)
+        {
+          reverse.push_back (it->second);
+        }
+    }
+  std::vector<uint32_t>::iterator self = std::find (reverse.begin (), reverse.end (), 0u);
+  order.m_reverseBefore.assign (reverse.begin (), self);
+  order.m_reverseAfter.assign (self + 1, reverse.end ());
+
+  std::vector<std::pair<uint32_t, uint32_t> > ranked;
+  for (uint32_t i = 1; i < nInterfaces; i++)
+    {
+      ranked.push_back (std::make_pair (order.m_priority[i], i));
+    }
+  std::sort (ranked.begin (), ranked.end ());
+  order.m_order.resize (ranked.size ());
+  order.m_rank.assign (nInterfaces, 0);
+  for (uint32_t rank = 0; rank < ranked.size (); rank++)
+    {
+      order.m_order[rank] = ranked[rank].second;
+      order.m_rank[ranked[rank].second] = rank;
+    }
+}
+
+void
+DdcDistanceTable::RetirePriorityOrders (uint32_t node)
+{
+  NS_ASSERT (node < m_nNodes);
+  std::vector<DdcPriorityOrder *> &row = m_orders[node];
+  for (std::vector<DdcPriorityOrder *>::iterator it = row.begin (); it != row.end (); it++)
+    {
+      if (*it != 0)
+        {
+          m_retired.push_back (*it);
+        }
+    }
+  row.clear ();
+}
+
+void
+DdcDistanceTable::ReleasePriorityOrders (void)
+{
+  for (std::vector<DdcPriorityOrder *>::iterator it = m_retired.begin (); it != m_retired.end (); it++)
+    {
+      delete *it;
+    }
+  m_retired.clear ();
+}
+
+uint64_t
+DdcDistanceTable::GetMemoryUsage (void) const
+{
+  // Hash map nodes hold the pair and a next pointer, plus a bucket pointer
+  uint64_t bytes = sizeof (*this)
+    + (m_distances.capacity () + m_reversalDistances.capacity ()
+       + m_savedDistances.capacity () + m_savedReversalDistances.capacity ()) * sizeof (uint32_t)
+    + m_nodeAddresses.capacity () * sizeof (Ipv4Address)
+    + m_addresses.size () * (sizeof (AddressMap::value_type) + sizeof (void *))
+    + m_addresses.bucket_count () * sizeof (void *);
+  for (uint32_t node = 0; node < m_nNodes; node++)
+    {
+      bytes += m_neighbours[node].capacity () * sizeof (uint32_t);
+      bytes += m_orders[node].capacity () * sizeof (DdcPriorityOrder *);
+      for (std::vector<DdcPriorityOrder *>::const_iterator it = m_orders[node].begin (); it != m_orders[node].end (); it++)
+        {
+          if (*it == 0)
+            {
+              continue;
+            }
+          bytes += sizeof (DdcPriorityOrder)
+            + ((*it)->m_priority.capacity () + (*it)->m_order.capacity ()) * sizeof (uint32_t)
+            + (*it)->m_rank.capacity () * sizeof (uint16_t)
+            + ((*it)->m_reverseBefore.capacity () + (*it)->m_reverseAfter.capacity ()) * sizeof (uint32_t);
+        }
+    }
+  return bytes;
+}
+
+} // namespace ns3
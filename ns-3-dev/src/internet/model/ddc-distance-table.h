@@ -0,0 +1,176 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef DDC_DISTANCE_TABLE_H
+#define DDC_DISTANCE_TABLE_H
+
+#include <vector>
+#include <stdint.h>
+#include "ns3/simple-ref-count.h"
+#include "ns3/ipv4-address.h"
+#include "ns3/sgi-hashmap.h"
+
+namespace ns3 {
+
+/**
+ * @apanda
+ * \brief How one node ranks its interfaces towards one destination node.
+ *
+ * Built by DdcDistanceTable the first time it is asked for, then shared by
+ * every address of the destination and never changed.
+ */
+struct DdcPriorityOrder
+{
+  /// Distance from the neighbour on each interface, 0 for loopback and
+  /// interfaces that don't lead to a (first seen) neighbour
+  std::vector<uint32_t> m_priority;
+  /// Interfaces other than loopback sorted by (priority, interface)
+  std::vector<uint32_t> m_order;
+  /// Position of each interface in m_order
+  std::vector<uint16_t> m_rank;
+  /// AEO reversal order, the interfaces to nodes ranked before and after
+  /// this one
+  std::vector<uint32_t> m_reverseBefore;
+  std::vector<uint32_t> m_reverseAfter;
+};
+
+/**
+ * @apanda
+ * \brief Shortest path distances between all pairs of nodes, shared by
+ * every Ipv4GlobalRouting instance in the simulation.
+ *
+ * The GlobalRouteManagerImpl fills this in while running SPF, and the DDC
+ * code derives link priorities and AEO reversal orders for a destination
+ * from it the first time that destination is needed, instead of having
+ * them pushed into every node for every address up front.
+ */
+class DdcDistanceTable : public SimpleRefCount<DdcDistanceTable>
+{
+public:
+  /// Node ID used for "no node", e.g. an interface without a neighbour
+  static const uint32_t NO_NODE = 0xffffffff;
+  /// Distance to a node that can't be reached
+  static const uint32_t UNREACHABLE = 0xffffffff;
+
+  /// Every node starts out UNREACHABLE from every other node
+  DdcDistanceTable (uint32_t nNodes);
+  ~DdcDistanceTable ();
+
+  uint32_t GetNNodes (void) const;
+
+  void SetDistance (uint32_t from, uint32_t to, uint32_t distance);
+  uint32_t GetDistance (uint32_t from, uint32_t to) const;
+
+  /**
+   * \brief Keep AEO reversal orders on the distances set so far. Heartbeat
+   * rounds need every node to agree on who comes before whom, so distances
+   * changed afterwards only move link priorities, also for orders that are
+   * first built later.
+   */
+  void FreezeReversalOrders (void);
+
+  /**
+   * \brief Move reversal orders towards dest over to the current distances,
+   * before a new heartbeat round for dest. Orders that change are retired
+   * as with RetirePriorityOrders.
+   * \returns true if any order changed
+   */
+  bool UpdateReversalOrders (uint32_t dest);
+
+  /**
+   * \brief Remember the distances (and those reversal orders are built
+   * from), to go back to them with RestoreDistances. Priority orders built
+   * since are retired if anything changed, as with RetirePriorityOrders.
+   */
+  void SaveDistances (void);
+  void RestoreDistances (void);
+
+  /**
+   * \brief Record that address belongs to node. The first address recorded
+   * for a node is its canonical address.
+   */
+  void AddAddress (Ipv4Address address, uint32_t node);
+
+  /**
+   * \brief Find the node an address belongs to
+   * \returns NO_NODE if the address is not known
+   */
+  uint32_t GetNode (Ipv4Address address) const;
+
+  /**
+   * \brief The canonical address of node
+   */
+  Ipv4Address GetNodeAddress (uint32_t node) const;
+
+  /**
+   * \brief Record the node at the other end of each of node's interfaces,
+   * NO_NODE for loopback and interfaces without one
+   */
+  void SetNeighbours (uint32_t node, const std::vector<uint32_t> &neighbours);
+
+  /**
+   * \brief The priority order node uses towards dest, built from the
+   * distances the first time it is needed. All distances have to be set by
+   * then.
+   */
+  const DdcPriorityOrder* GetPriorityOrder (uint32_t node, uint32_t dest);
+
+  /**
+   * \brief Drop the priority orders built for node, after its distances or
+   * those of its neighbours changed. The old orders stay valid until
+   * ReleasePriorityOrders, so routers can move their destinations over.
+   */
+  void RetirePriorityOrders (uint32_t node);
+  void ReleasePriorityOrders (void);
+
+  /**
+   * \brief Approximate number of bytes used by the table
+   */
+  uint64_t GetMemoryUsage (void) const;
+
+private:
+  typedef sgi::hash_map<Ipv4Address, uint32_t, Ipv4AddressHash> AddressMap;
+
+  DdcDistanceTable (const DdcDistanceTable &);
+  DdcDistanceTable& operator= (const DdcDistanceTable &);
+
+  void BuildPriorityOrder (uint32_t node, uint32_t dest, DdcPriorityOrder &order) const;
+  // Interfaces to node and its neighbours sorted by (distance to dest, node
+  // ID) in distances, a neighbour reached over several interfaces once
+  void SortNeighbours (uint32_t node, uint32_t dest, const std::vector<uint32_t> &distances,
+                       std::vector<std::pair<uint32_t, uint32_t> > &sorted) const;
+
+  uint32_t m_nNodes;
+  /// Row major, m_distances[from * m_nNodes + to]
+  std::vector<uint32_t> m_distances;
+  /// Distances reversal orders are built from once they differ from
+  /// m_distances, empty until then
+  std::vector<uint32_t> m_reversalDistances;
+  bool m_reversalFrozen;
+  /// What SaveDistances saw
+  std::vector<uint32_t> m_savedDistances;
+  std::vector<uint32_t> m_savedReversalDistances;
+  AddressMap m_addresses;
+  std::vector<Ipv4Address> m_nodeAddresses;
+  std::vector<std::vector<uint32_t> > m_neighbours;
+  /// m_orders[node][dest], rows are only allocated for nodes that ask
+  std::vector<std::vector<DdcPriorityOrder *> > m_orders;
+  std::vector<DdcPriorityOrder *> m_retired;
+};
+
+} // namespace ns3
+
+#endif /* DDC_DISTANCE_TABLE_H */
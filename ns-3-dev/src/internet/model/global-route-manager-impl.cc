@@ -30,6 +30,8 @@
 #include <sstream>
 #include <functional>
 #include <utility>
+#include <unistd.h>
+#include <set>
 #include "ns3/assert.h"
 #include "ns3/fatal-error.h"
 #include "ns3/log.h"
@@ -38,6 +40,14 @@
 #include "ns3/ipv4-routing-protocol.h"
 #include "ns3/ipv4-list-routing.h"
 #include "ns3/mpi-interface.h"
+#include "ns3/global-value.h"
+#include "ns3/uinteger.h"
+#include "ns3/boolean.h"
+#include "ns3/core-config.h"
+#ifdef HAVE_PTHREAD_H
+#include "ns3/system-thread.h"
+#include "ns3/system-mutex.h"
+#endif
 #include "global-router-interface.h"
 #include "global-route-manager-impl.h"
 #include "candidate-queue.h"
@@ -47,6 +57,12 @@ NS_LOG_COMPONENT_DEFINE ("GlobalRouteManager");
 
 namespace ns3 {
 
+// @apanda Number of threads InitializeRoutes runs the per root SPFs on
+static GlobalValue g_spfThreads = GlobalValue ("GlobalRoutingThreads",
+                                               "Number of threads to compute the global routes on (0 for one per processor)",
+                                               UintegerValue (0),
+                                               MakeUintegerChecker<uint32_t> ());
+
 std::ostream& 
 operator<< (std::ostream& os, const SPFVertex::NodeExit_t& exit)
 {
@@ -416,7 +432,9 @@ SPFVertex::ClearVertexProcessed (void)
 GlobalRouteManagerLSDB::GlobalRouteManagerLSDB ()
   :
     m_database (),
-    m_extdatabase ()
+    m_extdatabase (),
+    m_index (),
+    m_linkDataIndex ()
 {
   NS_LOG_FUNCTION_NOARGS ();
 }
@@ -439,6 +457,8 @@ GlobalRouteManagerLSDB::~GlobalRouteManagerLSDB ()
     }
   NS_LOG_LOGIC ("clear map");
   m_database.clear ();
+  m_index.clear ();
+  m_linkDataIndex.clear ();
 }
 
 void
@@ -461,10 +481,39 @@ GlobalRouteManagerLSDB::Insert (Ipv4Address addr, GlobalRoutingLSA* lsa)
     {
       m_extdatabase.push_back (lsa);
     } 
-  else
+  else if (m_database.insert (LSDBPair_t (addr, lsa)).second)
+    {
+      m_index[addr] = lsa;
+      for (uint32_t j = 0; j < lsa->GetNLinkRecords (); j++)
+        {
+          GlobalRoutingLinkRecord *lr = lsa->GetLinkRecord (j);
+          if (lr->GetLinkType () != GlobalRoutingLinkRecord::TransitNetwork)
+            {
+              continue;
+            }
+          LinkDataIndex_t::iterator i = m_linkDataIndex.find (lr->GetLinkData ());
+          if (i == m_linkDataIndex.end () || addr < i->second)
+            {
+              m_linkDataIndex[lr->GetLinkData ()] = addr;
+            }
+        }
+    }
+}
+
+GlobalRouteManagerLSDB*
+GlobalRouteManagerLSDB::Copy (void) const
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  GlobalRouteManagerLSDB *lsdb = new GlobalRouteManagerLSDB ();
+  for (LSDBMap_t::const_iterator i = m_database.begin (); i != m_database.end (); i++)
+    {
+      lsdb->Insert (i->first, new GlobalRoutingLSA (*i->second));
+    }
+  for (uint32_t j = 0; j < m_extdatabase.size (); j++)
     {
-      m_database.insert (LSDBPair_t (addr, lsa));
+      lsdb->Insert (m_extdatabase[j]->GetLinkStateId (), new GlobalRoutingLSA (*m_extdatabase[j]));
     }
+  return lsdb;
 }
 
 GlobalRoutingLSA*
@@ -486,15 +535,12 @@ GlobalRouteManagerLSDB::GetLSA (Ipv4Address addr) const
 //
 // Look up an LSA by its address.
 //
-  LSDBMap_t::const_iterator i;
-  for (i= m_database.begin (); i!= m_database.end (); i++)
+  LSDBIndex_t::const_iterator i = m_index.find (addr);
+  if (i == m_index.end ())
     {
-      if (i->first == addr)
-        {
-          return i->second;
-        }
+      return 0;
     }
-  return 0;
+  return i->second;
 }
 
 GlobalRoutingLSA*
@@ -502,24 +548,14 @@ GlobalRouteManagerLSDB::GetLSAByLinkData (Ipv4Address addr) const
 {
   NS_LOG_FUNCTION (addr);
 //
-// Look up an LSA by its address.
+// Look up an LSA by the LinkData of one of its TransitNetwork records.
 //
-  LSDBMap_t::const_iterator i;
-  for (i= m_database.begin (); i!= m_database.end (); i++)
+  LinkDataIndex_t::const_iterator i = m_linkDataIndex.find (addr);
+  if (i == m_linkDataIndex.end ())
     {
-      GlobalRoutingLSA* temp = i->second;
-// Iterate among temp's Link Records
-      for (uint32_t j = 0; j < temp->GetNLinkRecords (); j++)
-        {
-          GlobalRoutingLinkRecord *lr = temp->GetLinkRecord (j);
-          if ( lr->GetLinkType () == GlobalRoutingLinkRecord::TransitNetwork &&
-               lr->GetLinkData () == addr)
-            {
-              return temp;
-            }
-        }
+      return 0;
     }
-  return 0;
+  return GetLSA (i->second);
 }
 
 // ---------------------------------------------------------------------------
@@ -530,7 +566,11 @@ GlobalRouteManagerLSDB::GetLSAByLinkData (Ipv4Address addr) const
 
 GlobalRouteManagerImpl::GlobalRouteManagerImpl () 
   :
-    m_spfroot (0)
+    m_spfroot (0),
+    m_spfrootNode (DdcDistanceTable::NO_NODE),
+    m_spfResult (0),
+    m_routerNodes (),
+    m_jobs (0)
 {
   NS_LOG_FUNCTION_NOARGS ();
   m_lsdb = new GlobalRouteManagerLSDB ();
@@ -693,6 +733,9 @@ GlobalRouteManagerImpl::InitializeRoutes ()
   NS_LOG_INFO ("About to start SPF calculation");
   NodeList::Iterator listEnd = NodeList::End ();
   std::map<Ipv4Address, Ptr<Node> > nodeMap;
+  m_distances = Create<DdcDistanceTable> (NodeList::GetNNodes ());
+  BuildRouterIndex ();
+  std::vector<Ipv4Address> roots;
   for (NodeList::Iterator i = NodeList::Begin (); i != listEnd; i++)
     {
       Ptr<Node> node = *i;
@@ -715,42 +758,48 @@ GlobalRouteManagerImpl::InitializeRoutes ()
 //
       if (rtr && rtr->GetNumLSAs () )
         {
-          m_reversalMap.insert(AEOMap::value_type(rtr->GetRouterId(), std::list<Ptr<Ipv4GlobalRouting> >())); 
-          m_distance.insert(Distances::value_type(node->GetId(), std::vector<uint32_t>(NodeList::GetNNodes(), 0)));
-          SPFCalculate (rtr->GetRouterId ());
+          roots.push_back (rtr->GetRouterId ());
           nodeMap.insert(std::map<Ipv4Address, Ptr<Node> >::value_type(rtr->GetRouterId(), node));
           NS_LOG_LOGIC("=== INSERT ROOT ===");
           NS_LOG_LOGIC("While adding, router ID " << rtr->GetRouterId());
           
         }
     }
-  NS_LOG_LOGIC("Final tally");
-  for (AEOMap::iterator it = m_reversalMap.begin(); it != m_reversalMap.end(); it++) {
-    NS_LOG_LOGIC(it->first <<" -> " << (uint32_t)it->second.size());
-    for (std::list<Ptr<Ipv4GlobalRouting> >::iterator it2 = it->second.begin();
-         it2 != it->second.end(); it2++) {
-      Ptr<Ipv4GlobalRouting> gr = *it2;
-      //NS_LOG_LOGIC("Reversing for address " << it->first);
-      //Simulator::ScheduleNow(&Ipv4GlobalRouting::PrimitiveAEO, gr, it->first); 
+  // @apanda The SPF computations are independent, so run them all (perhaps
+  // in parallel), then install the routes in the order the serial loop did
+  std::vector<SPFResult> results;
+  SPFCalculateAll (roots, results);
+  for (uint32_t i = 0; i < results.size (); i++)
+    {
+      InstallSPFResult (results[i]);
     }
-  }
+  BuildLinkGraph (roots);
+  // @apanda Link changes from here on only move priorities, heartbeats keep
+  // the reversal orders every node agreed on
+  m_distances->FreezeReversalOrders ();
   NS_LOG_LOGIC("===== NODE MAP ====");
-  NS_LOG_LOGIC("=== DISTANCES ===");
-  for (Distances::iterator it = m_distance.begin(); it != m_distance.end(); it++) {
-    std::stringstream line;
-    line << it->first << ": ";
-    for (std::vector<uint32_t>::iterator it2 = it->second.begin(); it2 != it->second.end(); it2++) {
-      line << *it2 << " ";
-    }
-    NS_LOG_LOGIC(line.str());
-  }
-  NS_LOG_LOGIC("=== DISTANCES ===");
   for (std::map<Ipv4Address, Ptr<Node> >::iterator it = nodeMap.begin(); it != nodeMap.end(); it++) {
     Ptr<Node> node = it->second;
     NS_LOG_LOGIC(node->GetId() << "  " << it->first);
   }
   NS_LOG_LOGIC("===== NODE MAP ====");
-  listEnd = NodeList::End ();
+  // @apanda Every (non-loopback) address maps to its node, so that DDC can
+  // find the distances for a destination address
+  for (NodeList::Iterator i = NodeList::Begin (); i != listEnd; i++)
+    {
+      Ptr<Ipv4> ipv4 = (*i)->GetObject<Ipv4> ();
+      if (ipv4 == 0)
+        {
+          continue;
+        }
+      for (uint32_t iface = 1; iface < ipv4->GetNInterfaces (); iface++)
+        {
+          for (uint32_t addr = 0; addr < ipv4->GetNAddresses (iface); addr++)
+            {
+              m_distances->AddAddress (ipv4->GetAddress (iface, addr).GetLocal (), (*i)->GetId ());
+            }
+        }
+    }
   NS_LOG_LOGIC("===== NODE LINKS ====");
   for (NodeList::Iterator i = NodeList::Begin (); i != listEnd; i++)
     {
@@ -779,66 +828,21 @@ GlobalRouteManagerImpl::InitializeRoutes ()
         {
           Ipv4Address rtrId = rtr->GetRouterId (); 
           GlobalRoutingLSA *rlsa = m_lsdb->GetLSA (rtrId);
-          std::map<uint32_t, Ipv4Address> interfaceMap;
-          std::map<uint32_t, uint32_t> inverseInterfaceMap;
+          // Record the node at the other end of each point to point
+          // interface; DDC derives priorities and reversal orders for each
+          // destination from these and the distance table when it needs them
+          std::vector<uint32_t> neighbours (ipv4->GetNInterfaces (), DdcDistanceTable::NO_NODE);
           for (uint32_t i = 0; i < rlsa->GetNLinkRecords (); i++) {
             GlobalRoutingLinkRecord *l = rlsa->GetLinkRecord (i);
             if (l->GetLinkType() == GlobalRoutingLinkRecord::PointToPoint) {
               uint32_t currIface = ipv4->GetInterfaceForAddress(l->GetLinkData());
-              interfaceMap.insert(std::map<uint32_t, Ipv4Address>::value_type(currIface,
-                                                        l->GetLinkId()));
-              Ptr<Node> nextHop = nodeMap[l->GetLinkId()];
-              // Record translation between node ID and interace
-              inverseInterfaceMap.insert(std::map<uint32_t, uint32_t>::value_type(nextHop->GetId(), currIface));
-            }
-          }
-          // Add one for the current node
-          inverseInterfaceMap.insert(std::map<uint32_t, uint32_t>::value_type(node->GetId(), 0));
-          for (uint32_t iface = 1; iface < ipv4->GetNInterfaces(); iface++) {
-            for (uint32_t addr = 0; addr < ipv4->GetNAddresses(iface); addr++) {
-              NS_LOG_LOGIC("InitialHeartbeat for " << ipv4->GetAddress(iface, addr) << " for node " << node->GetId());
-              Simulator::ScheduleNow(&Ipv4GlobalRouting::SendInitialHeartbeat, gr, ipv4->GetAddress(iface, addr).GetLocal());
-            }
-          }
-
-          for (NodeList::Iterator i2 = NodeList::Begin(); i2 != listEnd; i2++) {
-            Ptr<Node> dest = *i2;
-            Ptr<Ipv4> destIpv4 = dest->GetObject<Ipv4>();
-            typedef std::pair<uint32_t, uint32_t> IntPair;
-            typedef std::priority_queue<IntPair, 
-                        std::vector<IntPair>,
-                        std::greater<std::vector<IntPair>::value_type> > InterfaceQueue;
-            InterfaceQueue intQueue;
-            // Add the current node in
-            intQueue.push(std::pair<uint32_t, uint32_t>(m_distance[node->GetId()][dest->GetId()], node->GetId()));
-            for (std::map<uint32_t, Ipv4Address>::iterator it = interfaceMap.begin();
-                it != interfaceMap.end(); it++) {
-                Ptr<Node> nextHop = nodeMap[it->second];
-                // Add IDs for every subsequent interface
-                intQueue.push(std::pair<uint32_t, uint32_t>(m_distance[nextHop->GetId()][dest->GetId()], nextHop->GetId()));
-            }
-            std::stringstream outline;
-            std::list<uint32_t> interfaces;
-            std::map<uint32_t, uint32_t> ifaceDistances;
-            while (!intQueue.empty()) {
-              uint32_t interface = inverseInterfaceMap[intQueue.top().second];
-              outline << interface << "(" << intQueue.top().first <<")   ";
-              interfaces.push_back(interface);
-              ifaceDistances.insert(std::map<uint32_t, uint32_t>::value_type(interface, intQueue.top().first));
-              intQueue.pop();
-            }
-            
-            NS_LOG_LOGIC ( node->GetId() << " (dest = " << dest-> GetId() << ") " << outline.str());
-
-            for (uint32_t iface = 1; iface < destIpv4->GetNInterfaces(); iface++) {
-              for (uint32_t addr = 0; addr < destIpv4->GetNAddresses(iface); addr++) {
-                gr->SetReversalOrder(destIpv4->GetAddress (iface, addr).GetLocal (), interfaces);
-                for (uint32_t oiface = 1; oiface < ipv4->GetNInterfaces(); oiface++) {
-                  gr->SetInterfacePriority(destIpv4->GetAddress(iface, addr).GetLocal(), oiface, ifaceDistances[oiface]);
-                }
+              if (neighbours[currIface] == DdcDistanceTable::NO_NODE) {
+                neighbours[currIface] = nodeMap[l->GetLinkId()]->GetId();
               }
             }
           }
+          gr->SetDistanceTable (m_distances, node->GetId (), neighbours);
+          ScheduleHeartbeats (node);
         }
     }
   NS_LOG_LOGIC("===== NODE LINKS ====");
@@ -1076,7 +1080,7 @@ GlobalRouteManagerImpl::SPFNext (SPFVertex* v, CandidateQueue& candidate)
 // If we've changed the cost to get to the vertex represented by <w>, we 
 // must reorder the priority queue keyed to that cost.
 //
-                  candidate.Reorder ();
+                  candidate.Update (cw);
                 }
             } // new lower cost path found
         } // end W is already on the candidate list
@@ -1363,7 +1367,10 @@ void
 GlobalRouteManagerImpl::DebugSPFCalculate (Ipv4Address root)
 {
   NS_LOG_FUNCTION (root);
-  SPFCalculate (root);
+  BuildRouterIndex ();
+  SPFResult result;
+  SPFCalculate (root, result);
+  InstallSPFResult (result);
 }
 
 //
@@ -1455,7 +1462,7 @@ GlobalRouteManagerImpl::CheckForStubNode (Ipv4Address root)
 
 // quagga ospf_spf_calculate
 void
-GlobalRouteManagerImpl::SPFCalculate (Ipv4Address root)
+GlobalRouteManagerImpl::SPFCalculate (Ipv4Address root, SPFResult &result)
 {
   NS_LOG_FUNCTION (this << root);
 
@@ -1482,6 +1489,14 @@ GlobalRouteManagerImpl::SPFCalculate (Ipv4Address root)
 // We also mark this vertex as being in the SPF tree.
 //
   m_spfroot= v;
+//
+// @apanda Find the node the root vertex belongs to once, rather than for
+// every vertex that is added to the tree.  Routes are collected in result
+// and installed by the caller.
+//
+  m_spfrootNode = GetRouterNode (root);
+  m_spfResult = &result;
+  result.m_node = m_spfrootNode;
   v->SetDistanceFromRoot (0);
   v->GetLSA ()->SetStatus (GlobalRoutingLSA::LSA_SPF_IN_SPFTREE);
   NS_LOG_LOGIC ("Starting SPFCalculate for node " << root);
@@ -1620,6 +1635,8 @@ GlobalRouteManagerImpl::SPFCalculate (Ipv4Address root)
 //
   delete m_spfroot;
   m_spfroot = 0;
+  m_spfrootNode = DdcDistanceTable::NO_NODE;
+  m_spfResult = 0;
 }
 
 void
@@ -1678,58 +1695,29 @@ GlobalRouteManagerImpl::SPFAddASExternal (GlobalRoutingLSA *extlsa, SPFVertex *v
 
   NS_LOG_LOGIC ("Vertex ID = " << routerId);
 //
-// We need to walk the list of nodes looking for the one that has the router
-// ID corresponding to the root vertex.  This is the one we're going to write
-// the routing information to.
+// SPFCalculate looked up the node that has the router ID corresponding to the
+// root vertex.  This is the one we're going to write the routing information
+// to.
 //
-  NodeList::Iterator i = NodeList::Begin (); 
-  NodeList::Iterator listEnd = NodeList::End ();
-  for (; i != listEnd; i++)
+  uint32_t node = m_spfrootNode;
+  if (node == DdcDistanceTable::NO_NODE)
     {
-      Ptr<Node> node = *i;
-//
-// The router ID is accessible through the GlobalRouter interface, so we need
-// to QI for that interface.  If there's no GlobalRouter interface, the node
-// in question cannot be the router we want, so we continue.
-// 
-      Ptr<GlobalRouter> rtr = node->GetObject<GlobalRouter> ();
-
-      if (rtr == 0)
-        {
-          NS_LOG_LOGIC ("No GlobalRouter interface on node " << node->GetId ());
-          continue;
-        }
-//
-// If the router ID of the current node is equal to the router ID of the 
-// root of the SPF tree, then this node is the one for which we need to 
-// write the routing tables.
-//
-      NS_LOG_LOGIC ("Considering router " << rtr->GetRouterId ());
-
-      if (rtr->GetRouterId () == routerId)
-        {
-          NS_LOG_LOGIC ("Setting routes for node " << node->GetId ());
-//
-// Routing information is updated using the Ipv4 interface.  We need to QI
-// for that interface.  If the node is acting as an IP version 4 router, it
-// should absolutely have an Ipv4 interface.
-//
-          Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
-          NS_ASSERT_MSG (ipv4, 
-                         "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
-                         "QI for <Ipv4> interface failed");
+      NS_LOG_LOGIC ("Can't find root node " << routerId);
+      return;
+    }
+  NS_LOG_LOGIC ("Setting routes for node " << node);
 //
 // Get the Global Router Link State Advertisement from the vertex we're
 // adding the routes to.  The LSA will have a number of attached Global Router
 // Link Records corresponding to links off of that vertex / node.  We're going
 // to be interested in the records corresponding to point-to-point links.
 //
-          NS_ASSERT_MSG (v->GetLSA (), 
-                         "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
-                         "Expected valid LSA in SPFVertex* v");
-          Ipv4Mask tempmask = extlsa->GetNetworkLSANetworkMask ();
-          Ipv4Address tempip = extlsa->GetLinkStateId ();
-          tempip = tempip.CombineMask (tempmask);
+  NS_ASSERT_MSG (v->GetLSA (), 
+                 "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
+                 "Expected valid LSA in SPFVertex* v");
+  Ipv4Mask tempmask = extlsa->GetNetworkLSANetworkMask ();
+  Ipv4Address tempip = extlsa->GetLinkStateId ();
+  tempip = tempip.CombineMask (tempmask);
 
 //
 // Here's why we did all of that work.  We're going to add a host route to the
@@ -1744,39 +1732,29 @@ GlobalRouteManagerImpl::SPFAddASExternal (GlobalRoutingLSA *extlsa, SPFVertex *v
 // Similarly, the vertex <v> has an m_rootOif (outbound interface index) to
 // which the packets should be send for forwarding.
 //
-          Ptr<GlobalRouter> router = node->GetObject<GlobalRouter> ();
-          if (router == 0)
-            {
-              continue;
-            }
-          Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
-          NS_ASSERT (gr);
-          // walk through all next-hop-IPs and out-going-interfaces for reaching
-          // the stub network gateway 'v' from the root node
-          for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
-            {
-              SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
-              Ipv4Address nextHop = exit.first;
-              int32_t outIf = exit.second;
-              if (outIf >= 0)
-                {
-                  gr->AddASExternalRouteTo (tempip, tempmask, nextHop, outIf);
-                  NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                " add external network route to " << tempip <<
-                                " using next hop " << nextHop <<
-                                " via interface " << outIf);
-                }
-              else
-                {
-                  NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                " NOT able to add network route to " << tempip <<
-                                " using next hop " << nextHop <<
-                                " since outgoing interface id is negative");
-                }
-            }
-          return;
-        } // if
-    } // for
+  // walk through all next-hop-IPs and out-going-interfaces for reaching
+  // the stub network gateway 'v' from the root node
+  for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
+    {
+      SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
+      Ipv4Address nextHop = exit.first;
+      int32_t outIf = exit.second;
+      if (outIf >= 0)
+        {
+          SPFAddRoute (SPFRoute::EXTERNAL, tempip, tempmask, nextHop, outIf);
+          NS_LOG_LOGIC ("(Route " << i << ") Node " << node <<
+                        " add external network route to " << tempip <<
+                        " using next hop " << nextHop <<
+                        " via interface " << outIf);
+        }
+      else
+        {
+          NS_LOG_LOGIC ("(Route " << i << ") Node " << node <<
+                        " NOT able to add network route to " << tempip <<
+                        " using next hop " << nextHop <<
+                        " since outgoing interface id is negative");
+        }
+    }
 }
 
 
@@ -1847,60 +1825,29 @@ GlobalRouteManagerImpl::SPFIntraAddStub (GlobalRoutingLinkRecord *l, SPFVertex*
 
   NS_LOG_LOGIC ("Vertex ID = " << routerId);
 //
-// We need to walk the list of nodes looking for the one that has the router
-// ID corresponding to the root vertex.  This is the one we're going to write
-// the routing information to.
+// SPFCalculate looked up the node that has the router ID corresponding to the
+// root vertex.  This is the one we're going to write the routing information
+// to.
 //
-  NodeList::Iterator i = NodeList::Begin (); 
-  NodeList::Iterator listEnd = NodeList::End ();
-  for (; i != listEnd; i++)
+  uint32_t node = m_spfrootNode;
+  if (node == DdcDistanceTable::NO_NODE)
     {
-      Ptr<Node> node = *i;
-//
-// The router ID is accessible through the GlobalRouter interface, so we need
-// to QI for that interface.  If there's no GlobalRouter interface, the node
-// in question cannot be the router we want, so we continue.
-// 
-      Ptr<GlobalRouter> rtr = 
-        node->GetObject<GlobalRouter> ();
-
-      if (rtr == 0)
-        {
-          NS_LOG_LOGIC ("No GlobalRouter interface on node " << 
-                        node->GetId ());
-          continue;
-        }
-//
-// If the router ID of the current node is equal to the router ID of the 
-// root of the SPF tree, then this node is the one for which we need to 
-// write the routing tables.
-//
-      NS_LOG_LOGIC ("Considering router " << rtr->GetRouterId ());
-
-      if (rtr->GetRouterId () == routerId)
-        {
-          NS_LOG_LOGIC ("Setting routes for node " << node->GetId ());
-//
-// Routing information is updated using the Ipv4 interface.  We need to QI
-// for that interface.  If the node is acting as an IP version 4 router, it
-// should absolutely have an Ipv4 interface.
-//
-          Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
-          NS_ASSERT_MSG (ipv4, 
-                         "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
-                         "QI for <Ipv4> interface failed");
+      NS_LOG_LOGIC ("Can't find root node " << routerId);
+      return;
+    }
+  NS_LOG_LOGIC ("Setting routes for node " << node);
 //
 // Get the Global Router Link State Advertisement from the vertex we're
 // adding the routes to.  The LSA will have a number of attached Global Router
 // Link Records corresponding to links off of that vertex / node.  We're going
 // to be interested in the records corresponding to point-to-point links.
 //
-          NS_ASSERT_MSG (v->GetLSA (), 
-                         "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
-                         "Expected valid LSA in SPFVertex* v");
-          Ipv4Mask tempmask (l->GetLinkData ().Get ());
-          Ipv4Address tempip = l->GetLinkId ();
-          tempip = tempip.CombineMask (tempmask);
+  NS_ASSERT_MSG (v->GetLSA (), 
+                 "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
+                 "Expected valid LSA in SPFVertex* v");
+  Ipv4Mask tempmask (l->GetLinkData ().Get ());
+  Ipv4Address tempip = l->GetLinkId ();
+  tempip = tempip.CombineMask (tempmask);
 //
 // Here's why we did all of that work.  We're going to add a host route to the
 // host address found in the m_linkData field of the point-to-point link
@@ -1915,39 +1862,29 @@ GlobalRouteManagerImpl::SPFIntraAddStub (GlobalRoutingLinkRecord *l, SPFVertex*
 // which the packets should be send for forwarding.
 //
 
-          Ptr<GlobalRouter> router = node->GetObject<GlobalRouter> ();
-          if (router == 0)
-            {
-              continue;
-            }
-          Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
-          NS_ASSERT (gr);
-          // walk through all next-hop-IPs and out-going-interfaces for reaching
-          // the stub network gateway 'v' from the root node
-          for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
-            {
-              SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
-              Ipv4Address nextHop = exit.first;
-              int32_t outIf = exit.second;
-              if (outIf >= 0)
-                {
-                  gr->AddNetworkRouteTo (tempip, tempmask, nextHop, outIf);
-                  NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                " add network route to " << tempip <<
-                                " using next hop " << nextHop <<
-                                " via interface " << outIf);
-                }
-              else
-                {
-                  NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                " NOT able to add network route to " << tempip <<
-                                " using next hop " << nextHop <<
-                                " since outgoing interface id is negative");
-                }
-            }
-          return;
-        } // if
-    } // for
+  // walk through all next-hop-IPs and out-going-interfaces for reaching
+  // the stub network gateway 'v' from the root node
+  for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
+    {
+      SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
+      Ipv4Address nextHop = exit.first;
+      int32_t outIf = exit.second;
+      if (outIf >= 0)
+        {
+          SPFAddRoute (SPFRoute::NETWORK, tempip, tempmask, nextHop, outIf);
+          NS_LOG_LOGIC ("(Route " << i << ") Node " << node <<
+                        " add network route to " << tempip <<
+                        " using next hop " << nextHop <<
+                        " via interface " << outIf);
+        }
+      else
+        {
+          NS_LOG_LOGIC ("(Route " << i << ") Node " << node <<
+                        " NOT able to add network route to " << tempip <<
+                        " using next hop " << nextHop <<
+                        " since outgoing interface id is negative");
+        }
+    }
 }
 
 //
@@ -1971,61 +1908,39 @@ GlobalRouteManagerImpl::FindOutgoingInterfaceId (Ipv4Address a, Ipv4Mask amask)
 //
   Ipv4Address routerId = m_spfroot->GetVertexId ();
 //
-// Walk the list of nodes in the system looking for the one corresponding to
-// the node at the root of the SPF tree.  This is the node for which we are
-// building the routing table.
+// SPFCalculate looked up the node at the root of the SPF tree.  This is the
+// node for which we are building the routing table.
 //
-  NodeList::Iterator i = NodeList::Begin (); 
-  NodeList::Iterator listEnd = NodeList::End ();
-  for (; i != listEnd; i++)
+  uint32_t node = m_spfrootNode;
+  if (node == DdcDistanceTable::NO_NODE)
     {
-      Ptr<Node> node = *i;
-
-      Ptr<GlobalRouter> rtr = 
-        node->GetObject<GlobalRouter> ();
+      NS_LOG_LOGIC ("Can't find root node " << routerId);
+      return -1;
+    }
 //
-// If the node doesn't have a GlobalRouter interface it can't be the one
-// we're interested in.
+// Look through the interfaces on this node for one that has the IP address
+// we're looking for, as Ipv4::GetInterfaceForPrefix () would.  If we find
+// one, return the corresponding interface index, or -1 if not found.
 //
-      if (rtr == 0)
+  int32_t interface = -1;
+  const InterfaceList_t &interfaces = m_nodeInterfaces[node];
+  for (InterfaceList_t::const_iterator i = interfaces.begin (); i != interfaces.end (); i++)
+    {
+      if (i->second.CombineMask (amask) == a.CombineMask (amask))
         {
-          continue;
+          interface = i->first;
+          break;
         }
-
-      if (rtr->GetRouterId () == routerId)
-        {
-//
-// This is the node we're building the routing table for.  We're going to need
-// the Ipv4 interface to look for the ipv4 interface index.  Since this node
-// is participating in routing IP version 4 packets, it certainly must have 
-// an Ipv4 interface.
-//
-          Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
-          NS_ASSERT_MSG (ipv4, 
-                         "GlobalRouteManagerImpl::FindOutgoingInterfaceId (): "
-                         "GetObject for <Ipv4> interface failed");
-//
-// Look through the interfaces on this node for one that has the IP address
-// we're looking for.  If we find one, return the corresponding interface
-// index, or -1 if not found.
-//
-          int32_t interface = ipv4->GetInterfaceForPrefix (a, amask);
+    }
 
 #if 0
-          if (interface < 0)
-            {
-              NS_FATAL_ERROR ("GlobalRouteManagerImpl::FindOutgoingInterfaceId(): "
-                              "Expected an interface associated with address a:" << a);
-            }
-#endif 
-          return interface;
-        }
+  if (interface < 0)
+    {
+      NS_FATAL_ERROR ("GlobalRouteManagerImpl::FindOutgoingInterfaceId(): "
+                      "Expected an interface associated with address a:" << a);
     }
-//
-// Couldn't find it.
-//
-  NS_LOG_LOGIC ("FindOutgoingInterfaceId():Can't find root node " << routerId);
-  return -1;
+#endif 
+  return interface;
 }
 
 //
@@ -2062,85 +1977,32 @@ GlobalRouteManagerImpl::SPFIntraAddRouter (SPFVertex* v)
 
   NS_LOG_LOGIC ("Vertex ID = " << routerId);
 // @apanda Find destination node, so we can get a nice distance map here
-  Ptr<Node> dest = 0;
-  NodeList::Iterator i = NodeList::Begin (); 
-  NodeList::Iterator listEnd = NodeList::End ();
-  for (; i != listEnd; i++) 
-    {
-      dest = *i;
-      Ptr<GlobalRouter> rtr =
-        dest->GetObject<GlobalRouter> ();
-        if (rtr == 0)
-          {
-            continue;
-          }
-
-        if (rtr->GetRouterId () == v->GetVertexId ()) 
-          {
-            break;
-          }
-        else
-          {
-            dest = 0;
-          }
-    }
-    NS_ASSERT_MSG(dest != 0, "Could not find destination");
-  
+  uint32_t dest = GetRouterNode (v->GetVertexId ());
+  NS_ASSERT_MSG(dest != DdcDistanceTable::NO_NODE, "Could not find destination");
 //
-// We need to walk the list of nodes looking for the one that has the router
-// ID corresponding to the root vertex.  This is the one we're going to write
-// the routing information to.
+// SPFCalculate looked up the node that has the router ID corresponding to the
+// root vertex.  This is the one we're going to write the routing information
+// to.
 //
-  i = NodeList::Begin (); 
-  listEnd = NodeList::End ();
-  for (; i != listEnd; i++)
+  uint32_t node = m_spfrootNode;
+  if (node == DdcDistanceTable::NO_NODE)
     {
-      Ptr<Node> node = *i;
-//
-// The router ID is accessible through the GlobalRouter interface, so we need
-// to GetObject for that interface.  If there's no GlobalRouter interface, 
-// the node in question cannot be the router we want, so we continue.
-// 
-      Ptr<GlobalRouter> rtr = 
-        node->GetObject<GlobalRouter> ();
-
-      if (rtr == 0)
-        {
-          NS_LOG_LOGIC ("No GlobalRouter interface on node " << 
-                        node->GetId ());
-          continue;
-        }
-//
-// If the router ID of the current node is equal to the router ID of the 
-// root of the SPF tree, then this node is the one for which we need to 
-// write the routing tables.
-//
-      NS_LOG_LOGIC ("Considering router " << rtr->GetRouterId ());
-
-      if (rtr->GetRouterId () == routerId)
-        {
-          NS_LOG_LOGIC ("Setting routes for node " << node->GetId ());
-//
-// Routing information is updated using the Ipv4 interface.  We need to 
-// GetObject for that interface.  If the node is acting as an IP version 4 
-// router, it should absolutely have an Ipv4 interface.
-//
-          Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
-          NS_ASSERT_MSG (ipv4, 
-                         "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
-                         "GetObject for <Ipv4> interface failed");
+      NS_LOG_LOGIC ("Can't find root node " << routerId);
+      return;
+    }
+  NS_LOG_LOGIC ("Setting routes for node " << node);
 //
 // Get the Global Router Link State Advertisement from the vertex we're
 // adding the routes to.  The LSA will have a number of attached Global Router
 // Link Records corresponding to links off of that vertex / node.  We're going
 // to be interested in the records corresponding to point-to-point links.
 //
-          GlobalRoutingLSA *lsa = v->GetLSA ();
-          NS_ASSERT_MSG (lsa, 
-                         "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
-                         "Expected valid LSA in SPFVertex* v");
+  GlobalRoutingLSA *lsa = v->GetLSA ();
+  NS_ASSERT_MSG (lsa, 
+                 "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
+                 "Expected valid LSA in SPFVertex* v");
 
-          uint32_t nLinkRecords = lsa->GetNLinkRecords ();
+  uint32_t nLinkRecords = lsa->GetNLinkRecords ();
 //
 // Iterate through the link records on the vertex to which we're going to add
 // routes.  To make sure we're being clear, we're going to add routing table
@@ -2149,18 +2011,18 @@ GlobalRouteManagerImpl::SPFIntraAddRouter (SPFVertex* v)
 // the local side of the point-to-point links found on the node described by
 // the vertex <v>.
 //
-          NS_LOG_LOGIC (" Node " << node->GetId () <<
-                        " found " << nLinkRecords << " link records in LSA " << lsa << "with LinkStateId "<< lsa->GetLinkStateId ());
-          for (uint32_t j = 0; j < nLinkRecords; ++j)
-            {
+  NS_LOG_LOGIC (" Node " << node <<
+                " found " << nLinkRecords << " link records in LSA " << lsa << "with LinkStateId "<< lsa->GetLinkStateId ());
+  for (uint32_t j = 0; j < nLinkRecords; ++j)
+    {
 //
 // We are only concerned about point-to-point links
 //
-              GlobalRoutingLinkRecord *lr = lsa->GetLinkRecord (j);
-              if (lr->GetLinkType () != GlobalRoutingLinkRecord::PointToPoint)
-                {
-                  continue;
-                }
+      GlobalRoutingLinkRecord *lr = lsa->GetLinkRecord (j);
+      if (lr->GetLinkType () != GlobalRoutingLinkRecord::PointToPoint)
+        {
+          continue;
+        }
 //
 // Here's why we did all of that work.  We're going to add a host route to the
 // host address found in the m_linkData field of the point-to-point link
@@ -2174,49 +2036,42 @@ GlobalRouteManagerImpl::SPFIntraAddRouter (SPFVertex* v)
 // Similarly, the vertex <v> has an m_rootOif (outbound interface index) to
 // which the packets should be send for forwarding.
 //
-              Ptr<GlobalRouter> router = node->GetObject<GlobalRouter> ();
-              if (router == 0)
-                {
-                  continue;
-                }
-              Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
-              NS_ASSERT (gr);
-              // walk through all available exit directions due to ECMP,
-              // and add host route for each of the exit direction toward
-              // the vertex 'v'
-              for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
-                {
-                  SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
-                  Ipv4Address nextHop = exit.first;
-                  int32_t outIf = exit.second;
-                  if (outIf >= 0)
-                    {
-                      gr->AddHostRouteTo (lr->GetLinkData (), nextHop,
-                                          outIf);
-                      NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                    " adding host route to " << lr->GetLinkData () <<
-                                    " using next hop " << nextHop <<
-                                    " and outgoing interface " << outIf);
-                    }
-                  else
-                    {
-                      NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                    " NOT able to add host route to " << lr->GetLinkData () <<
-                                    " using next hop " << nextHop <<
-                                    " since outgoing interface id is negative " << outIf);
-                    }
-                } // for all routes from the root the vertex 'v'
-                m_reversalMap[lr->GetLinkData ()].push_back(gr);
-                m_distance[node->GetId()][dest->GetId()] = v->GetDistanceFromRoot();
-                //gr->PrimitiveAEO (lr->GetLinkData ());
-                // Record this order and then call stuff in order
+      // walk through all available exit directions due to ECMP,
+      // and add host route for each of the exit direction toward
+      // the vertex 'v'
+      for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
+        {
+          SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
+          Ipv4Address nextHop = exit.first;
+          int32_t outIf = exit.second;
+          if (outIf >= 0)
+            {
+              SPFAddRoute (SPFRoute::HOST, lr->GetLinkData (), Ipv4Mask::GetOnes (),
+                           nextHop, outIf);
+              NS_LOG_LOGIC ("(Route " << i << ") Node " << node <<
+                            " adding host route to " << lr->GetLinkData () <<
+                            " using next hop " << nextHop <<
+                            " and outgoing interface " << outIf);
+            }
+          else
+            {
+              NS_LOG_LOGIC ("(Route " << i << ") Node " << node <<
+                            " NOT able to add host route to " << lr->GetLinkData () <<
+                            " using next hop " << nextHop <<
+                            " since outgoing interface id is negative " << outIf);
             }
+        } // for all routes from the root the vertex 'v'
+        if (m_spfResult->m_distances.empty () || m_spfResult->m_distances.back ().first != dest)
+          {
+            m_spfResult->m_distances.push_back (std::make_pair (dest, v->GetDistanceFromRoot ()));
+          }
+        //gr->PrimitiveAEO (lr->GetLinkData ());
+        // Record this order and then call stuff in order
+    }
 //
 // Done adding the routes for the selected node.
 //
-          return;
-        }
-    }
+  return;
 }
 void
 GlobalRouteManagerImpl::SPFIntraAddTransit (SPFVertex* v)
@@ -2236,95 +2091,55 @@ GlobalRouteManagerImpl::SPFIntraAddTransit (SPFVertex* v)
 
   NS_LOG_LOGIC ("Vertex ID = " << routerId);
 //
-// We need to walk the list of nodes looking for the one that has the router
-// ID corresponding to the root vertex.  This is the one we're going to write
-// the routing information to.
+// SPFCalculate looked up the node that has the router ID corresponding to the
+// root vertex.  This is the one we're going to write the routing information
+// to.
 //
-  NodeList::Iterator i = NodeList::Begin (); 
-  NodeList::Iterator listEnd = NodeList::End ();
-  for (; i != listEnd; i++)
+  uint32_t node = m_spfrootNode;
+  if (node == DdcDistanceTable::NO_NODE)
     {
-      Ptr<Node> node = *i;
-//
-// The router ID is accessible through the GlobalRouter interface, so we need
-// to GetObject for that interface.  If there's no GlobalRouter interface, 
-// the node in question cannot be the router we want, so we continue.
-// 
-      Ptr<GlobalRouter> rtr = 
-        node->GetObject<GlobalRouter> ();
-
-      if (rtr == 0)
-        {
-          NS_LOG_LOGIC ("No GlobalRouter interface on node " << 
-                        node->GetId ());
-          continue;
-        }
-//
-// If the router ID of the current node is equal to the router ID of the 
-// root of the SPF tree, then this node is the one for which we need to 
-// write the routing tables.
-//
-      NS_LOG_LOGIC ("Considering router " << rtr->GetRouterId ());
-
-      if (rtr->GetRouterId () == routerId)
-        {
-          NS_LOG_LOGIC ("setting routes for node " << node->GetId ());
-//
-// Routing information is updated using the Ipv4 interface.  We need to 
-// GetObject for that interface.  If the node is acting as an IP version 4 
-// router, it should absolutely have an Ipv4 interface.
-//
-          Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
-          NS_ASSERT_MSG (ipv4, 
-                         "GlobalRouteManagerImpl::SPFIntraAddTransit (): "
-                         "GetObject for <Ipv4> interface failed");
+      NS_LOG_LOGIC ("Can't find root node " << routerId);
+      return;
+    }
+  NS_LOG_LOGIC ("setting routes for node " << node);
 //
 // Get the Global Router Link State Advertisement from the vertex we're
 // adding the routes to.  The LSA will have a number of attached Global Router
 // Link Records corresponding to links off of that vertex / node.  We're going
 // to be interested in the records corresponding to point-to-point links.
 //
-          GlobalRoutingLSA *lsa = v->GetLSA ();
-          NS_ASSERT_MSG (lsa, 
-                         "GlobalRouteManagerImpl::SPFIntraAddTransit (): "
-                         "Expected valid LSA in SPFVertex* v");
-          Ipv4Mask tempmask = lsa->GetNetworkLSANetworkMask ();
-          Ipv4Address tempip = lsa->GetLinkStateId ();
-          tempip = tempip.CombineMask (tempmask);
-          Ptr<GlobalRouter> router = node->GetObject<GlobalRouter> ();
-          if (router == 0)
-            {
-              continue;
-            }
-          Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
-          NS_ASSERT (gr);
-          // walk through all available exit directions due to ECMP,
-          // and add host route for each of the exit direction toward
-          // the vertex 'v'
-          for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
-            {
-              SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
-              Ipv4Address nextHop = exit.first;
-              int32_t outIf = exit.second;
+  GlobalRoutingLSA *lsa = v->GetLSA ();
+  NS_ASSERT_MSG (lsa, 
+                 "GlobalRouteManagerImpl::SPFIntraAddTransit (): "
+                 "Expected valid LSA in SPFVertex* v");
+  Ipv4Mask tempmask = lsa->GetNetworkLSANetworkMask ();
+  Ipv4Address tempip = lsa->GetLinkStateId ();
+  tempip = tempip.CombineMask (tempmask);
+  // walk through all available exit directions due to ECMP,
+  // and add host route for each of the exit direction toward
+  // the vertex 'v'
+  for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
+    {
+      SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
+      Ipv4Address nextHop = exit.first;
+      int32_t outIf = exit.second;
 
-              if (outIf >= 0)
-                {
-                  gr->AddNetworkRouteTo (tempip, tempmask, nextHop, outIf);
-                  NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                " add network route to " << tempip <<
-                                " using next hop " << nextHop <<
-                                " via interface " << outIf);
-                }
-              else
-                {
-                  NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                " NOT able to add network route to " << tempip <<
-                                " using next hop " << nextHop <<
-                                " since outgoing interface id is negative " << outIf);
-                }
-            }
+      if (outIf >= 0)
+        {
+          SPFAddRoute (SPFRoute::NETWORK, tempip, tempmask, nextHop, outIf);
+          NS_LOG_LOGIC ("(Route " << i << ") Node " << node <<
+                        " add network route to " << tempip <<
+                        " using next hop " << nextHop <<
+                        " via interface " << outIf);
         }
-    } 
+      else
+        {
+          NS_LOG_LOGIC ("(Route " << i << ") Node " << node <<
+                        " NOT able to add network route to " << tempip <<
+                        " using next hop " << nextHop <<
+                        " since outgoing interface id is negative " << outIf);
+        }
+    }
 }
 
 // Derived from quagga ospf_vertex_add_parents ()
@@ -2350,22 +2165,768 @@ GlobalRouteManagerImpl::SPFVertexAddParent (SPFVertex* v)
     }
 }
 
+Ptr<DdcDistanceTable>
+GlobalRouteManagerImpl::GetDistanceTable (void) const
+{
+  return m_distances;
+}
+
 void
-GlobalRouteManagerImpl::SendHeartbeats()
+GlobalRouteManagerImpl::BuildRouterIndex (void)
 {
+  NS_LOG_FUNCTION_NOARGS ();
+  m_routerNodes.clear ();
+  m_nodeInterfaces.clear ();
+  m_nodeInterfaces.resize (NodeList::GetNNodes ());
+  m_nodeRouting.clear ();
+  m_nodeRouting.resize (NodeList::GetNNodes ());
   for (NodeList::Iterator i = NodeList::Begin (); i != NodeList::End (); i++)
     {
-      Ptr<Node> node = *i;
-      Ptr<Ipv4> ipv4 = node->GetObject<Ipv4>();
-      Ptr<GlobalRouter> router = node->GetObject<GlobalRouter> ();
-      Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
-      for (uint32_t iface = 1; iface < ipv4->GetNInterfaces(); iface++) {
-        for (uint32_t addr = 0; addr < ipv4->GetNAddresses(iface); addr++) {
-          NS_LOG_LOGIC("InitialHeartbeat for " << ipv4->GetAddress(iface, addr) << " for node " << node->GetId());
-          Simulator::ScheduleNow(&Ipv4GlobalRouting::SendInitialHeartbeat, gr, ipv4->GetAddress(iface, addr).GetLocal());
+      uint32_t id = (*i)->GetId ();
+      Ptr<GlobalRouter> rtr = (*i)->GetObject<GlobalRouter> ();
+      if (rtr == 0)
+        {
+          continue;
         }
-      }
-    }
+      // Keep the first node with an ID, as walking the node list did
+      m_routerNodes.insert (RouterIndex_t::value_type (rtr->GetRouterId (), id));
+      m_nodeRouting[id] = rtr->GetRoutingProtocol ();
+      Ptr<Ipv4> ipv4 = (*i)->GetObject<Ipv4> ();
+      if (ipv4 == 0)
+        {
+          continue;
+        }
+      for (uint32_t iface = 0; iface < ipv4->GetNInterfaces (); iface++)
+        {
+          for (uint32_t addr = 0; addr < ipv4->GetNAddresses (iface); addr++)
+            {
+              m_nodeInterfaces[id].push_back (std::make_pair (iface, ipv4->GetAddress (iface, addr).GetLocal ()));
+            }
+        }
+    }
+}
+
+uint32_t
+GlobalRouteManagerImpl::GetRouterNode (Ipv4Address routerId) const
+{
+  RouterIndex_t::const_iterator i = m_routerNodes.find (routerId);
+  if (i == m_routerNodes.end ())
+    {
+      return DdcDistanceTable::NO_NODE;
+    }
+  return i->second;
+}
+
+//
+// The roots still to be computed, shared by all of the workers of one
+// SPFCalculateAll.  Each worker writes only to the results of the roots it
+// takes, so only the next index needs the lock.
+//
+struct GlobalRouteManagerImpl::SPFJobs
+{
+  const std::vector<Ipv4Address> *m_roots;
+  std::vector<SPFResult> *m_results;
+  uint32_t m_next;
+#ifdef HAVE_PTHREAD_H
+  SystemMutex m_mutex;
+#endif
+};
+
+void
+GlobalRouteManagerImpl::SPFCalculateAll (const std::vector<Ipv4Address> &roots,
+                                         std::vector<SPFResult> &results)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  results.clear ();
+  results.resize (roots.size ());
+
+  SPFJobs jobs;
+  jobs.m_roots = &roots;
+  jobs.m_results = &results;
+  jobs.m_next = 0;
+
+  UintegerValue threadsValue;
+  g_spfThreads.GetValue (threadsValue);
+  uint32_t threads = threadsValue.Get ();
+  if (threads == 0)
+    {
+      long cpus = sysconf (_SC_NPROCESSORS_ONLN);
+      threads = cpus > 0 ? cpus : 1;
+    }
+  if (threads > roots.size ())
+    {
+      threads = roots.size ();
+    }
+
+#ifdef HAVE_PTHREAD_H
+  if (threads > 1)
+    {
+      NS_LOG_LOGIC ("Running SPF for " << roots.size () << " roots on " << threads << " threads");
+//
+// Every worker searches its own copy of the LSDB, since the SPF marks the
+// LSAs it has visited.  The workers are set up and torn down here, so that
+// no reference counted object is touched from more than one thread.
+//
+      std::vector<GlobalRouteManagerImpl *> workers;
+      std::vector<Ptr<SystemThread> > pool;
+      for (uint32_t i = 0; i < threads; i++)
+        {
+          GlobalRouteManagerImpl *worker = new GlobalRouteManagerImpl ();
+          worker->DebugUseLsdb (m_lsdb->Copy ());
+          worker->m_routerNodes = m_routerNodes;
+          worker->m_nodeInterfaces = m_nodeInterfaces;
+          worker->m_jobs = &jobs;
+          workers.push_back (worker);
+          pool.push_back (Create<SystemThread> (MakeCallback (&GlobalRouteManagerImpl::RunSPFJobs, worker)));
+        }
+      for (uint32_t i = 0; i < pool.size (); i++)
+        {
+          pool[i]->Start ();
+        }
+      for (uint32_t i = 0; i < pool.size (); i++)
+        {
+          pool[i]->Join ();
+        }
+      pool.clear ();
+      for (uint32_t i = 0; i < workers.size (); i++)
+        {
+          delete workers[i];
+        }
+      return;
+    }
+#endif
+
+  m_jobs = &jobs;
+  RunSPFJobs ();
+  m_jobs = 0;
+}
+
+void
+GlobalRouteManagerImpl::RunSPFJobs (void)
+{
+  NS_ASSERT (m_jobs);
+  for (;;)
+    {
+      uint32_t next;
+      {
+#ifdef HAVE_PTHREAD_H
+        CriticalSection cs (m_jobs->m_mutex);
+#endif
+        next = m_jobs->m_next++;
+      }
+      if (next >= m_jobs->m_roots->size ())
+        {
+          return;
+        }
+      SPFCalculate ((*m_jobs->m_roots)[next], (*m_jobs->m_results)[next]);
+    }
+}
+
+void
+GlobalRouteManagerImpl::SPFAddRoute (SPFRoute::Type type, Ipv4Address dest, Ipv4Mask mask,
+                                     Ipv4Address nextHop, uint32_t iface)
+{
+  NS_ASSERT (m_spfResult);
+  SPFRoute route;
+  route.m_type = type;
+  route.m_dest = dest;
+  route.m_mask = mask;
+  route.m_nextHop = nextHop;
+  route.m_interface = iface;
+  m_spfResult->m_routes.push_back (route);
+}
+
+void
+GlobalRouteManagerImpl::InstallSPFResult (const SPFResult &result)
+{
+  NS_LOG_FUNCTION (result.m_node);
+  if (result.m_node == DdcDistanceTable::NO_NODE)
+    {
+      return;
+    }
+  Ptr<Ipv4GlobalRouting> gr = m_nodeRouting[result.m_node];
+  NS_ASSERT_MSG (gr, "GlobalRouteManagerImpl::InstallSPFResult (): GetGlobalRoutingProtocol () returned zero");
+  for (std::vector<SPFRoute>::const_iterator i = result.m_routes.begin (); i != result.m_routes.end (); i++)
+    {
+      switch (i->m_type)
+        {
+        case SPFRoute::HOST:
+          gr->AddHostRouteTo (i->m_dest, i->m_nextHop, i->m_interface);
+          break;
+        case SPFRoute::NETWORK:
+          gr->AddNetworkRouteTo (i->m_dest, i->m_mask, i->m_nextHop, i->m_interface);
+          break;
+        case SPFRoute::EXTERNAL:
+          gr->AddASExternalRouteTo (i->m_dest, i->m_mask, i->m_nextHop, i->m_interface);
+          break;
+        }
+    }
+  if (m_distances != 0)
+    {
+      for (std::vector<std::pair<uint32_t, uint32_t> >::const_iterator i = result.m_distances.begin ();
+           i != result.m_distances.end (); i++)
+        {
+          m_distances->SetDistance (result.m_node, i->first, i->second);
+        }
+    }
+}
+
+void
+GlobalRouteManagerImpl::BuildLinkGraph (const std::vector<Ipv4Address> &roots)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  uint32_t nNodes = NodeList::GetNNodes ();
+  m_linkGraph.clear ();
+  m_linkGraph.resize (nNodes);
+  m_graphRoots.clear ();
+  m_interfaceUp.clear ();
+  m_interfaceUp.resize (nNodes);
+  m_linkChanges.clear ();
+  m_linkChangeEvent.Cancel ();
+  for (std::list<EventId>::iterator e = m_convergenceEvents.begin (); e != m_convergenceEvents.end (); e++)
+    {
+      e->Cancel ();
+    }
+  m_convergenceEvents.clear ();
+  m_pendingDistances.clear ();
+  m_lastSpf.clear ();
+  m_spfPending.clear ();
+  for (NodeList::Iterator i = NodeList::Begin (); i != NodeList::End (); i++)
+    {
+      Ptr<Ipv4> ipv4 = (*i)->GetObject<Ipv4> ();
+      if (ipv4 == 0)
+        {
+          continue;
+        }
+      std::vector<bool> &up = m_interfaceUp[(*i)->GetId ()];
+      for (uint32_t iface = 0; iface < ipv4->GetNInterfaces (); iface++)
+        {
+          up.push_back (ipv4->GetNetDevice (iface)->IsLinkUp ());
+        }
+    }
+
+  std::map<Ipv4Address, uint32_t> networks;
+  for (std::vector<Ipv4Address>::const_iterator r = roots.begin (); r != roots.end (); r++)
+    {
+      uint32_t node = GetRouterNode (*r);
+      GlobalRoutingLSA *lsa = m_lsdb->GetLSA (*r);
+      if (node == DdcDistanceTable::NO_NODE || lsa == 0)
+        {
+          continue;
+        }
+      m_graphRoots.push_back (node);
+      for (uint32_t j = 0; j < lsa->GetNLinkRecords (); j++)
+        {
+          GlobalRoutingLinkRecord *l = lsa->GetLinkRecord (j);
+          int32_t iface = FindInterface (node, l->GetLinkData ());
+          if (iface < 0)
+            {
+              continue;
+            }
+          SPFEdge edge;
+          edge.m_metric = l->GetMetric ();
+          edge.m_node = node;
+          edge.m_interface = iface;
+          if (l->GetLinkType () == GlobalRoutingLinkRecord::PointToPoint)
+            {
+              edge.m_to = GetRouterNode (l->GetLinkId ());
+              if (edge.m_to != DdcDistanceTable::NO_NODE)
+                {
+                  m_linkGraph[node].push_back (edge);
+                }
+            }
+          else if (l->GetLinkType () == GlobalRoutingLinkRecord::TransitNetwork)
+            {
+              // The network is a vertex of its own; leaving it costs nothing
+              std::map<Ipv4Address, uint32_t>::iterator network = networks.find (l->GetLinkId ());
+              if (network == networks.end ())
+                {
+                  network = networks.insert (std::make_pair (l->GetLinkId (), m_linkGraph.size ())).first;
+                  m_linkGraph.push_back (std::vector<SPFEdge> ());
+                }
+              edge.m_to = network->second;
+              m_linkGraph[node].push_back (edge);
+              edge.m_to = node;
+              edge.m_metric = 0;
+              m_linkGraph[network->second].push_back (edge);
+            }
+        }
+    }
+}
+
+int32_t
+GlobalRouteManagerImpl::FindInterface (uint32_t node, Ipv4Address address) const
+{
+  const InterfaceList_t &interfaces = m_nodeInterfaces[node];
+  for (InterfaceList_t::const_iterator i = interfaces.begin (); i != interfaces.end (); i++)
+    {
+      if (i->second == address)
+        {
+          return i->first;
+        }
+    }
+  return -1;
+}
+
+bool
+GlobalRouteManagerImpl::IsEdgeUp (const SPFEdge &edge) const
+{
+  const std::vector<bool> &up = m_interfaceUp[edge.m_node];
+  return edge.m_interface >= up.size () || up[edge.m_interface];
+}
+
+void
+GlobalRouteManagerImpl::ComputeDistances (uint32_t root, std::vector<uint32_t> &distances) const
+{
+  distances.assign (m_linkGraph.size (), DdcDistanceTable::UNREACHABLE);
+  std::priority_queue<std::pair<uint32_t, uint32_t>,
+                      std::vector<std::pair<uint32_t, uint32_t> >,
+                      std::greater<std::pair<uint32_t, uint32_t> > > queue;
+  distances[root] = 0;
+  queue.push (std::make_pair (0, root));
+  while (!queue.empty ())
+    {
+      std::pair<uint32_t, uint32_t> top = queue.top ();
+      queue.pop ();
+      if (top.first != distances[top.second])
+        {
+          continue;
+        }
+      const std::vector<SPFEdge> &edges = m_linkGraph[top.second];
+      for (std::vector<SPFEdge>::const_iterator e = edges.begin (); e != edges.end (); e++)
+        {
+          if (!IsEdgeUp (*e) || top.first + e->m_metric >= distances[e->m_to])
+            {
+              continue;
+            }
+          distances[e->m_to] = top.first + e->m_metric;
+          queue.push (std::make_pair (distances[e->m_to], e->m_to));
+        }
+    }
+}
+
+void
+GlobalRouteManagerImpl::NotifyLinkChange (uint32_t node, uint32_t iface, bool up)
+{
+  NS_LOG_FUNCTION (node << iface << up);
+  if (node >= m_interfaceUp.size () || iface >= m_interfaceUp[node].size () ||
+      m_interfaceUp[node][iface] == up)
+    {
+      return;
+    }
+  m_interfaceUp[node][iface] = up;
+  m_linkChanges.push_back (std::make_pair (node, iface));
+  // Both ends of a link report, and several links may fail at once
+  if (!m_linkChangeEvent.IsRunning ())
+    {
+      m_linkChangeEvent = Simulator::ScheduleNow (&GlobalRouteManagerImpl::ProcessLinkChanges, this);
+    }
+}
+
+void
+GlobalRouteManagerImpl::ProcessLinkChanges (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  std::vector<std::pair<uint32_t, uint32_t> > changes;
+  changes.swap (m_linkChanges);
+  if (m_distances == 0)
+    {
+      return;
+    }
+//
+// A root can only be affected by a failed link its shortest paths use, or a
+// repaired link that is shorter than the way it goes now. Links to transit
+// networks have no distances of their own in the table, so they affect every
+// root.
+//
+  std::vector<bool> affected (m_linkGraph.size (), false);
+  bool all = false;
+  for (uint32_t from = 0; from < m_linkGraph.size () && !all; from++)
+    {
+      for (std::vector<SPFEdge>::const_iterator e = m_linkGraph[from].begin (); e != m_linkGraph[from].end (); e++)
+        {
+          std::pair<uint32_t, uint32_t> key (e->m_node, e->m_interface);
+          if (std::find (changes.begin (), changes.end (), key) == changes.end ())
+            {
+              continue;
+            }
+          if (from >= m_distances->GetNNodes () || e->m_to >= m_distances->GetNNodes ())
+            {
+              all = true;
+              break;
+            }
+          bool up = IsEdgeUp (*e);
+          for (std::vector<uint32_t>::const_iterator r = m_graphRoots.begin (); r != m_graphRoots.end (); r++)
+            {
+              uint32_t dFrom = GetLatestDistance (*r, from);
+              uint32_t dTo = GetLatestDistance (*r, e->m_to);
+              if (dFrom == DdcDistanceTable::UNREACHABLE)
+                {
+                  continue;
+                }
+              if (up ? (dTo == DdcDistanceTable::UNREACHABLE || dFrom + e->m_metric < dTo)
+                     : (dFrom + e->m_metric == dTo))
+                {
+                  affected[*r] = true;
+                }
+            }
+        }
+    }
+
+  uint32_t nNodes = m_distances->GetNNodes ();
+  std::vector<uint32_t> changed;
+  std::vector<uint32_t> distances;
+  for (std::vector<uint32_t>::const_iterator r = m_graphRoots.begin (); r != m_graphRoots.end (); r++)
+    {
+      if (!all && !affected[*r])
+        {
+          continue;
+        }
+      ComputeDistances (*r, distances);
+      std::vector<uint32_t> row (nNodes);
+      bool rowChanged = false;
+      for (uint32_t dest = 0; dest < nNodes; dest++)
+        {
+          row[dest] = GetLatestDistance (*r, dest);
+        }
+      for (std::vector<uint32_t>::const_iterator dest = m_graphRoots.begin (); dest != m_graphRoots.end (); dest++)
+        {
+          // The root's own entry stays what SPF left it
+          if (*dest == *r || row[*dest] == distances[*dest])
+            {
+              continue;
+            }
+          row[*dest] = distances[*dest];
+          rowChanged = true;
+        }
+      if (rowChanged)
+        {
+          m_pendingDistances[*r].swap (row);
+          changed.push_back (*r);
+        }
+    }
+  NS_LOG_LOGIC ("Recomputed distances changed for " << changed.size () << " roots");
+
+//
+// Each node only acts once its own control plane has caught up: the link
+// state update floods out from both ends of every changed link, taking each
+// node's LsaHopDelay to be passed on, and the SPF it triggers runs SpfDelay
+// later, but no sooner than SpfHoldTime after the node's previous SPF. An
+// SPF still to come after the update arrives covers it. With no delays
+// configured every node converges right here, as one batch.
+//
+  std::vector<Time> lsaHopDelay (nNodes);
+  std::vector<Time> spfDelay (nNodes);
+  std::vector<Time> spfHoldTime (nNodes);
+  for (uint32_t node = 0; node < nNodes; node++)
+    {
+      if (m_nodeRouting[node] != 0)
+        {
+          bool reset;
+          m_nodeRouting[node]->GetConvergenceModel (lsaHopDelay[node], spfDelay[node], spfHoldTime[node], reset);
+        }
+    }
+  std::vector<Time> arrival;
+  std::vector<bool> reached;
+  std::vector<uint32_t> sources;
+  for (std::vector<std::pair<uint32_t, uint32_t> >::const_iterator c = changes.begin (); c != changes.end (); c++)
+    {
+      sources.push_back (c->first);
+    }
+  ComputeFloodTimes (sources, lsaHopDelay, arrival, reached);
+  m_lastSpf.resize (nNodes, Time (-1));
+  m_spfPending.resize (nNodes, false);
+  Time now = Simulator::Now ();
+  std::map<Time, std::vector<uint32_t> > spfs;
+  for (uint32_t node = 0; node < nNodes; node++)
+    {
+      if (!reached[node] || m_nodeRouting[node] == 0)
+        {
+          // Nobody here runs an SPF we could wait for
+          if (m_pendingDistances.find (node) != m_pendingDistances.end ())
+            {
+              spfs[now].push_back (node);
+            }
+          continue;
+        }
+      Time lsa = now + arrival[node];
+      if (m_spfPending[node] && m_lastSpf[node] >= lsa)
+        {
+          continue;
+        }
+      Time spf = lsa + spfDelay[node];
+      if (!m_lastSpf[node].IsNegative () && m_lastSpf[node] + spfHoldTime[node] > spf)
+        {
+          spf = m_lastSpf[node] + spfHoldTime[node];
+        }
+      m_lastSpf[node] = spf;
+      m_spfPending[node] = true;
+      spfs[spf].push_back (node);
+    }
+  while (!m_convergenceEvents.empty () && m_convergenceEvents.front ().IsExpired ())
+    {
+      m_convergenceEvents.pop_front ();
+    }
+  for (std::map<Time, std::vector<uint32_t> >::iterator it = spfs.begin (); it != spfs.end (); it++)
+    {
+      if (it->first == now)
+        {
+          ConvergeNodes (it->second);
+        }
+      else
+        {
+          m_convergenceEvents.push_back (Simulator::Schedule (it->first - now, &GlobalRouteManagerImpl::ConvergeNodes, this, it->second));
+        }
+    }
+}
+
+uint32_t
+GlobalRouteManagerImpl::GetLatestDistance (uint32_t root, uint32_t node) const
+{
+  std::map<uint32_t, std::vector<uint32_t> >::const_iterator pending = m_pendingDistances.find (root);
+  if (pending != m_pendingDistances.end ())
+    {
+      return pending->second[node];
+    }
+  return m_distances->GetDistance (root, node);
+}
+
+void
+GlobalRouteManagerImpl::ComputeFloodTimes (const std::vector<uint32_t> &sources, const std::vector<Time> &hopDelay,
+                                           std::vector<Time> &arrival, std::vector<bool> &reached) const
+{
+  arrival.assign (m_linkGraph.size (), Time (0));
+  reached.assign (m_linkGraph.size (), false);
+  std::set<std::pair<Time, uint32_t> > queue;
+  for (std::vector<uint32_t>::const_iterator s = sources.begin (); s != sources.end (); s++)
+    {
+      if (!reached[*s])
+        {
+          reached[*s] = true;
+          queue.insert (std::make_pair (Time (0), *s));
+        }
+    }
+  while (!queue.empty ())
+    {
+      std::pair<Time, uint32_t> top = *queue.begin ();
+      queue.erase (queue.begin ());
+      // Routers pass updates on, a transit network just connects them
+      Time hop = top.second < hopDelay.size () ? hopDelay[top.second] : Time (0);
+      const std::vector<SPFEdge> &edges = m_linkGraph[top.second];
+      for (std::vector<SPFEdge>::const_iterator e = edges.begin (); e != edges.end (); e++)
+        {
+          Time t = top.first + hop;
+          if (!IsEdgeUp (*e) || (reached[e->m_to] && arrival[e->m_to] <= t))
+            {
+              continue;
+            }
+          if (reached[e->m_to])
+            {
+              queue.erase (std::make_pair (arrival[e->m_to], e->m_to));
+            }
+          reached[e->m_to] = true;
+          arrival[e->m_to] = t;
+          queue.insert (std::make_pair (t, e->m_to));
+        }
+    }
+  arrival.resize (hopDelay.size ());
+  reached.resize (hopDelay.size ());
+}
+
+void
+GlobalRouteManagerImpl::ConvergeNodes (std::vector<uint32_t> nodes)
+{
+  NS_LOG_FUNCTION (nodes.size ());
+//
+// Install the distances the SPFs computed. A node orders its links towards
+// a destination by its own distance and its neighbours', so the nodes whose
+// row changed and all of their neighbours refresh their priorities.
+//
+  uint32_t nNodes = m_distances->GetNNodes ();
+  std::vector<bool> refresh (nNodes, false);
+  for (std::vector<uint32_t>::const_iterator n = nodes.begin (); n != nodes.end (); n++)
+    {
+      if (*n < m_spfPending.size ())
+        {
+          m_spfPending[*n] = false;
+        }
+      std::map<uint32_t, std::vector<uint32_t> >::iterator pending = m_pendingDistances.find (*n);
+      if (pending == m_pendingDistances.end ())
+        {
+          continue;
+        }
+      for (uint32_t dest = 0; dest < nNodes; dest++)
+        {
+          if (m_distances->GetDistance (*n, dest) != pending->second[dest])
+            {
+              m_distances->SetDistance (*n, dest, pending->second[dest]);
+            }
+        }
+      m_pendingDistances.erase (pending);
+      refresh[*n] = true;
+      for (std::vector<SPFEdge>::const_iterator e = m_linkGraph[*n].begin (); e != m_linkGraph[*n].end (); e++)
+        {
+          if (e->m_to < nNodes)
+            {
+              refresh[e->m_to] = true;
+            }
+        }
+    }
+  for (uint32_t node = 0; node < nNodes; node++)
+    {
+      if (refresh[node])
+        {
+          m_distances->RetirePriorityOrders (node);
+        }
+    }
+  for (uint32_t node = 0; node < nNodes; node++)
+    {
+      if (refresh[node] && m_nodeRouting[node] != 0)
+        {
+          m_nodeRouting[node]->RefreshDistances ();
+        }
+    }
+  m_distances->ReleasePriorityOrders ();
+
+//
+// A node that resets on convergence starts a heartbeat round for its
+// addresses, with every node moved over to a reversal order from the new
+// distances first so the round sees one consistent order.
+//
+  for (std::vector<uint32_t>::const_iterator n = nodes.begin (); n != nodes.end (); n++)
+    {
+      Time lsaHopDelay, spfDelay, spfHoldTime;
+      bool reset = false;
+      if (m_nodeRouting[*n] != 0)
+        {
+          m_nodeRouting[*n]->GetConvergenceModel (lsaHopDelay, spfDelay, spfHoldTime, reset);
+        }
+      if (!reset)
+        {
+          continue;
+        }
+      if (m_distances->UpdateReversalOrders (*n))
+        {
+          for (uint32_t node = 0; node < nNodes; node++)
+            {
+              if (m_nodeRouting[node] != 0)
+                {
+                  m_nodeRouting[node]->RefreshDestination (*n);
+                }
+            }
+          m_distances->ReleasePriorityOrders ();
+        }
+      ScheduleHeartbeats (NodeList::GetNode (*n));
+    }
+}
+
+void
+GlobalRouteManagerImpl::SaveRoutingState (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  m_savedLinkUp.assign (NodeList::GetNNodes (), std::vector<bool> ());
+  for (NodeList::Iterator i = NodeList::Begin (); i != NodeList::End (); i++)
+    {
+      std::vector<bool> &up = m_savedLinkUp[(*i)->GetId ()];
+      for (uint32_t j = 0; j < (*i)->GetNDevices (); j++)
+        {
+          up.push_back ((*i)->GetDevice (j)->IsLinkUp ());
+        }
+    }
+  m_savedInterfaceUp = m_interfaceUp;
+  m_savedLastSpf = m_lastSpf;
+  if (m_distances != 0)
+    {
+      m_distances->SaveDistances ();
+    }
+  for (std::vector<Ptr<Ipv4GlobalRouting> >::iterator gr = m_nodeRouting.begin (); gr != m_nodeRouting.end (); gr++)
+    {
+      if (*gr != 0)
+        {
+          (*gr)->SaveDdcState ();
+        }
+    }
+}
+
+void
+GlobalRouteManagerImpl::RestoreRoutingState (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+//
+// Put the links back without calling their link change callbacks: what the
+// routers would do about the change is undone below anyway.
+//
+  for (NodeList::Iterator i = NodeList::Begin (); i != NodeList::End (); i++)
+    {
+      uint32_t id = (*i)->GetId ();
+      for (uint32_t j = 0; id < m_savedLinkUp.size () && j < m_savedLinkUp[id].size (); j++)
+        {
+          Ptr<NetDevice> device = (*i)->GetDevice (j);
+          if (device->IsLinkUp () != m_savedLinkUp[id][j] &&
+              !device->SetAttributeFailSafe ("LinkUp", BooleanValue (m_savedLinkUp[id][j])))
+            {
+              NS_LOG_WARN ("Cannot restore the link of device " << j << " on node " << id);
+            }
+        }
+    }
+
+  m_linkChanges.clear ();
+  m_linkChangeEvent.Cancel ();
+  for (std::list<EventId>::iterator e = m_convergenceEvents.begin (); e != m_convergenceEvents.end (); e++)
+    {
+      e->Cancel ();
+    }
+  m_convergenceEvents.clear ();
+  m_pendingDistances.clear ();
+  m_spfPending.assign (m_spfPending.size (), false);
+  m_interfaceUp = m_savedInterfaceUp;
+  m_lastSpf = m_savedLastSpf;
+  if (m_distances != 0)
+    {
+      m_distances->RestoreDistances ();
+    }
+  for (std::vector<Ptr<Ipv4GlobalRouting> >::iterator gr = m_nodeRouting.begin (); gr != m_nodeRouting.end (); gr++)
+    {
+      if (*gr != 0)
+        {
+          (*gr)->RestoreDdcState ();
+        }
+    }
+  if (m_distances != 0)
+    {
+      m_distances->ReleasePriorityOrders ();
+    }
+}
+
+void
+GlobalRouteManagerImpl::SendHeartbeats()
+{
+  for (NodeList::Iterator i = NodeList::Begin (); i != NodeList::End (); i++)
+    {
+      ScheduleHeartbeats (*i);
+    }
+}
+
+void
+GlobalRouteManagerImpl::ScheduleHeartbeats (Ptr<Node> node)
+{
+  Ptr<Ipv4> ipv4 = node->GetObject<Ipv4>();
+  Ptr<Ipv4GlobalRouting> gr = node->GetObject<GlobalRouter> ()->GetRoutingProtocol ();
+  std::vector<Ipv4Address> addrs;
+  for (uint32_t iface = 1; iface < ipv4->GetNInterfaces(); iface++) {
+    for (uint32_t addr = 0; addr < ipv4->GetNAddresses(iface); addr++) {
+      Ipv4Address local = ipv4->GetAddress (iface, addr).GetLocal ();
+      if (gr->GetDestinationKey (local) != local) {
+        // DDC state for this address is shared with another one
+        continue;
+      }
+      NS_LOG_LOGIC("InitialHeartbeat for " << local << " for node " << node->GetId());
+      addrs.push_back (local);
+    }
+  }
+  if (!addrs.empty ()) {
+    Simulator::ScheduleNow(&Ipv4GlobalRouting::SendInitialHeartbeats, gr, addrs);
+  }
 }
 } // namespace ns3
 
@@ -30,7 +30,11 @@
 #include "ns3/object.h"
 #include "ns3/ptr.h"
 #include "ns3/ipv4-address.h"
+#include "ns3/sgi-hashmap.h"
+#include "ns3/event-id.h"
+#include "ns3/nstime.h"
 #include "global-router-interface.h"
+#include "ddc-distance-table.h"
 
 namespace ns3 {
 
@@ -662,6 +666,17 @@ public:
  */
   void Initialize ();
 
+/**
+ * @brief Copy every Link State Advertisement into a new database.
+ * @internal
+ *
+ * SPF marks the LSAs it visits, so each concurrent SPF computation works
+ * on its own copy.
+ *
+ * @returns A new database the caller must delete.
+ */
+  GlobalRouteManagerLSDB* Copy (void) const;
+
   GlobalRoutingLSA* GetExtLSA (uint32_t index) const;
   uint32_t GetNumExtLSAs () const;
 
@@ -670,8 +685,16 @@ private:
   typedef std::map<Ipv4Address, GlobalRoutingLSA*> LSDBMap_t;
   typedef std::pair<Ipv4Address, GlobalRoutingLSA*> LSDBPair_t;
 
+  typedef sgi::hash_map<Ipv4Address, GlobalRoutingLSA*, Ipv4AddressHash> LSDBIndex_t;
+  typedef sgi::hash_map<Ipv4Address, Ipv4Address, Ipv4AddressHash> LinkDataIndex_t;
+
   LSDBMap_t m_database;
   std::vector<GlobalRoutingLSA*> m_extdatabase;
+  // @apanda Hashed views of m_database for the lookups SPF does per link.
+  // m_linkDataIndex maps the LinkData of every TransitNetwork record to the
+  // lowest database address holding it, which is what the linear scan found.
+  LSDBIndex_t m_index;
+  LinkDataIndex_t m_linkDataIndex;
 
 /**
  * @brief GlobalRouteManagerLSDB copy construction is disallowed.  There's no 
@@ -739,10 +762,113 @@ public:
  */
   void DebugSPFCalculate (Ipv4Address root);
 
-  // @apanda
+  // @apanda Start a heartbeat round for every address in the network, one
+  // batched AEO per node
   void SendHeartbeats ();
 
+  // @apanda Distances computed by the last InitializeRoutes
+  Ptr<DdcDistanceTable> GetDistanceTable (void) const;
+
+  // @apanda The link on interface iface of node went up or down. All the
+  // changes at one time are handled together: only the roots whose shortest
+  // paths could use (or now improve through) a changed link are recomputed,
+  // and the DDC priorities of the nodes around them refreshed. Routes are
+  // left alone, DDC is what copes with the failure.
+  void NotifyLinkChange (uint32_t node, uint32_t iface, bool up);
+
+  // @apanda Remember the state of every link and all routing state that
+  // changes while a simulation runs (DDC state, recomputed distances, the
+  // convergence model), so that RestoreRoutingState can start the next run
+  // from it without rebuilding the topology or the routes. Call both while
+  // nothing routing related is scheduled, e.g. after Simulator::Run.
+  void SaveRoutingState (void);
+  void RestoreRoutingState (void);
+
 private:
+  // @apanda Schedule a batched initial heartbeat for node's addresses
+  void ScheduleHeartbeats (Ptr<Node> node);
+
+  // @apanda A route SPF computed for its root, not yet installed
+  struct SPFRoute
+  {
+    enum Type
+    {
+      HOST,
+      NETWORK,
+      EXTERNAL
+    };
+    Type m_type;
+    Ipv4Address m_dest;
+    Ipv4Mask m_mask;
+    Ipv4Address m_nextHop;
+    uint32_t m_interface;
+  };
+
+  // @apanda Everything one SPF computation produces for its root node. SPF
+  // only reads the LSDB (through its own copy) and the router index, and
+  // writes one of these, so separate roots can be computed on separate
+  // threads and installed afterwards in node order.
+  struct SPFResult
+  {
+    uint32_t m_node;
+    std::vector<SPFRoute> m_routes;
+    // (destination node, distance) pairs for m_node's row of m_distances
+    std::vector<std::pair<uint32_t, uint32_t> > m_distances;
+  };
+
+  // @apanda Roots shared between SPF threads
+  struct SPFJobs;
+
+  // @apanda Index every node with a GlobalRouter by its router ID and record
+  // its interface addresses and routing protocol, so SPF finds what it needs
+  // without walking the node list or touching the nodes
+  void BuildRouterIndex (void);
+  // @apanda The ID of the node with the given router ID, or
+  // DdcDistanceTable::NO_NODE
+  uint32_t GetRouterNode (Ipv4Address routerId) const;
+  // @apanda Run SPF for every root, on the number of threads given by the
+  // GlobalRoutingThreads global value, and return the results in root order
+  void SPFCalculateAll (const std::vector<Ipv4Address> &roots, std::vector<SPFResult> &results);
+  // @apanda Thread body: compute roots taken from m_jobs until none are left
+  void RunSPFJobs (void);
+  // @apanda Install the routes and distances in result on its node
+  void InstallSPFResult (const SPFResult &result);
+  void SPFAddRoute (SPFRoute::Type type, Ipv4Address dest, Ipv4Mask mask,
+                    Ipv4Address nextHop, uint32_t iface);
+
+  // @apanda A directed link of the graph kept for incremental SPF, usable
+  // while interface m_interface of node m_node is up
+  struct SPFEdge
+  {
+    uint32_t m_to;
+    uint32_t m_metric;
+    uint32_t m_node;
+    uint32_t m_interface;
+  };
+
+  // @apanda Build the graph incremental SPF works on from the router LSAs
+  // of roots: one vertex per node ID, then one per transit network
+  void BuildLinkGraph (const std::vector<Ipv4Address> &roots);
+  // @apanda The interface of node with local address, or -1
+  int32_t FindInterface (uint32_t node, Ipv4Address address) const;
+  bool IsEdgeUp (const SPFEdge &edge) const;
+  // @apanda Distances from root to every node over the links that are up,
+  // DdcDistanceTable::UNREACHABLE for the nodes that can't be reached
+  void ComputeDistances (uint32_t root, std::vector<uint32_t> &distances) const;
+  // @apanda Handle every link change noted since the last call
+  void ProcessLinkChanges (void);
+  // @apanda When a link state update flooded from sources reaches every
+  // node, with hopDelay[n] for node n to pass it on. Only nodes with
+  // reached set have an arrival time
+  void ComputeFloodTimes (const std::vector<uint32_t> &sources, const std::vector<Time> &hopDelay,
+                          std::vector<Time> &arrival, std::vector<bool> &reached) const;
+  // @apanda Distance from root to node, as the next SPF at root will see it
+  uint32_t GetLatestDistance (uint32_t root, uint32_t node) const;
+  // @apanda The SPFs nodes run after a link change: their new distances go
+  // into the table, the DDC priorities derived from them are refreshed, and
+  // nodes that reset on convergence start a heartbeat round
+  void ConvergeNodes (std::vector<uint32_t> nodes);
+
 /**
  * @brief GlobalRouteManagerImpl copy construction is disallowed.
  * There's no  need for it and a compiler provided shallow copy would be 
@@ -760,7 +886,7 @@ private:
   SPFVertex* m_spfroot;
   GlobalRouteManagerLSDB* m_lsdb;
   bool CheckForStubNode (Ipv4Address root);
-  void SPFCalculate (Ipv4Address root);
+  void SPFCalculate (Ipv4Address root, SPFResult &result);
   void SPFProcessStubs (SPFVertex* v);
   void ProcessASExternals (SPFVertex* v, GlobalRoutingLSA* extlsa);
   void SPFNext (SPFVertex*, CandidateQueue&);
@@ -775,11 +901,39 @@ private:
   void SPFAddASExternal (GlobalRoutingLSA *extlsa, SPFVertex *v);
   int32_t FindOutgoingInterfaceId (Ipv4Address a, 
                                    Ipv4Mask amask = Ipv4Mask ("255.255.255.255"));
-  // @apanda
-  typedef std::map<Ipv4Address, std::list<Ptr<Ipv4GlobalRouting> > > AEOMap;
-  AEOMap m_reversalMap;
-  typedef std::map<uint32_t, std::vector<uint32_t> > Distances;
-  Distances m_distance;
+  // @apanda Distances between all nodes, shared with the DDC routing code
+  Ptr<DdcDistanceTable> m_distances;
+  // @apanda The node for m_spfroot and where its results go, valid during
+  // SPFCalculate
+  uint32_t m_spfrootNode;
+  SPFResult *m_spfResult;
+  // @apanda Router ID to node ID, and for every node ID its (interface,
+  // local address) pairs in interface order and its routing protocol
+  typedef sgi::hash_map<Ipv4Address, uint32_t, Ipv4AddressHash> RouterIndex_t;
+  typedef std::vector<std::pair<uint32_t, Ipv4Address> > InterfaceList_t;
+  RouterIndex_t m_routerNodes;
+  std::vector<InterfaceList_t> m_nodeInterfaces;
+  std::vector<Ptr<Ipv4GlobalRouting> > m_nodeRouting;
+  SPFJobs *m_jobs;
+  // @apanda Incremental SPF state: the link graph, which nodes are roots,
+  // the state of every node's interfaces, and the (node, interface) pairs
+  // changed since the last ProcessLinkChanges
+  std::vector<std::vector<SPFEdge> > m_linkGraph;
+  std::vector<uint32_t> m_graphRoots;
+  std::vector<std::vector<bool> > m_interfaceUp;
+  std::vector<std::pair<uint32_t, uint32_t> > m_linkChanges;
+  EventId m_linkChangeEvent;
+  // @apanda Control plane convergence: distance rows computed but not yet
+  // installed by their root's SPF, when each node's last SPF runs (or ran)
+  // and whether it is still to come
+  std::map<uint32_t, std::vector<uint32_t> > m_pendingDistances;
+  std::vector<Time> m_lastSpf;
+  std::vector<bool> m_spfPending;
+  std::list<EventId> m_convergenceEvents;
+  // @apanda What SaveRoutingState saw, links by node and device index
+  std::vector<std::vector<bool> > m_savedLinkUp;
+  std::vector<std::vector<bool> > m_savedInterfaceUp;
+  std::vector<Time> m_savedLastSpf;
 
 };
 
@@ -53,6 +53,27 @@ GlobalRouteManager::InitializeRoutes (void)
   InitializeRoutes ();
 }
 
+void
+GlobalRouteManager::NotifyLinkChange (uint32_t node, uint32_t iface, bool up)
+{
+  SimulationSingleton<GlobalRouteManagerImpl>::Get ()->
+  NotifyLinkChange (node, iface, up);
+}
+
+void
+GlobalRouteManager::SaveRoutingState (void)
+{
+  SimulationSingleton<GlobalRouteManagerImpl>::Get ()->
+  SaveRoutingState ();
+}
+
+void
+GlobalRouteManager::RestoreRoutingState (void)
+{
+  SimulationSingleton<GlobalRouteManagerImpl>::Get ()->
+  RestoreRoutingState ();
+}
+
 uint32_t
 GlobalRouteManager::AllocateRouterId (void)
 {
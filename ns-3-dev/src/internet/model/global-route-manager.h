@@ -22,6 +22,7 @@
 #ifndef GLOBAL_ROUTE_MANAGER_H
 #define GLOBAL_ROUTE_MANAGER_H
 
+#include <stdint.h>
 #include "ns3/deprecated.h"
 
 namespace ns3 {
@@ -67,6 +68,21 @@ public:
  */
   static void InitializeRoutes ();
 
+/**
+ * @brief Note that the link on an interface of a node went up or down, so
+ * that the distances around it are recomputed
+ * @internal
+ */
+  static void NotifyLinkChange (uint32_t node, uint32_t iface, bool up);
+
+/**
+ * @brief Save the state of every link and the routing state that changes
+ * while a simulation runs, to go back to with RestoreRoutingState
+ * @internal
+ */
+  static void SaveRoutingState ();
+  static void RestoreRoutingState ();
+
 private:
 /**
  * @brief Global Route Manager copy construction is disallowed.  There's no 
@@ -17,6 +17,7 @@
 //
 
 #include <vector>
+#include <algorithm>
 #include <iomanip>
 #include "ns3/names.h"
 #include "ns3/log.h"
@@ -24,9 +25,15 @@
 #include "ns3/object.h"
 #include "ns3/packet.h"
 #include "ns3/net-device.h"
+#include "ns3/channel.h"
+#include "ns3/node.h"
 #include "ns3/ipv4-route.h"
 #include "ns3/ipv4-routing-table-entry.h"
 #include "ns3/boolean.h"
+#include "ns3/enum.h"
+#include "ns3/uinteger.h"
+#include "ipv4-l3-protocol.h"
+#include "ipv4-interface.h"
 #include "ipv4-global-routing.h"
 #include "global-route-manager.h"
 
@@ -66,15 +73,106 @@ Ipv4GlobalRouting::GetTypeId (void)
                    BooleanValue (true),
                    MakeBooleanAccessor (&Ipv4GlobalRouting::m_allowReversal),
                    MakeBooleanChecker ())
+    .AddAttribute ("FlowHashing",
+                   "Spread DDC traffic over all live output links sharing the best priority by hashing each packet's addresses, protocol and ports, instead of always using the first one. Packets of a flow stay on one link",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&Ipv4GlobalRouting::m_flowHashing),
+                   MakeBooleanChecker ())
+    .AddAttribute ("WeakEsModel",
+                   "RFC1222 Weak End System Model: accept packets for any local address, not just the addresses of the incoming interface",
+                   BooleanValue (true),
+                   MakeBooleanAccessor (&Ipv4GlobalRouting::m_weakEsModel),
+                   MakeBooleanChecker ())
+    .AddAttribute ("StateKey",
+                   "Keep DDC state per destination address, or per destination node (shared by all its addresses). Must be set before routes are populated",
+                   EnumValue (KEY_ADDRESS),
+                   MakeEnumAccessor (&Ipv4GlobalRouting::m_stateKey),
+                   MakeEnumChecker (KEY_ADDRESS, "Address",
+                                    KEY_NODE, "Node"))
+    .AddAttribute ("RecomputeOnLinkChange",
+                   "Recompute the distances around a link when it goes down or up, and refresh DDC link priorities from them. Routes are not changed",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&Ipv4GlobalRouting::m_recomputeOnLinkChange),
+                   MakeBooleanChecker ())
+    .AddAttribute ("LsaHopDelay",
+                   "Time this node takes to flood a link state update on to its neighbours, used with RecomputeOnLinkChange",
+                   TimeValue (Seconds (0)),
+                   MakeTimeAccessor (&Ipv4GlobalRouting::m_lsaHopDelay),
+                   MakeTimeChecker ())
+    .AddAttribute ("SpfDelay",
+                   "Time from a link state update reaching this node to the SPF it triggers, used with RecomputeOnLinkChange",
+                   TimeValue (Seconds (0)),
+                   MakeTimeAccessor (&Ipv4GlobalRouting::m_spfDelay),
+                   MakeTimeChecker ())
+    .AddAttribute ("SpfHoldTime",
+                   "Shortest time between two SPF runs on this node, used with RecomputeOnLinkChange",
+                   TimeValue (Seconds (0)),
+                   MakeTimeAccessor (&Ipv4GlobalRouting::m_spfHoldTime),
+                   MakeTimeChecker ())
+    .AddAttribute ("ResetOnConvergence",
+                   "Once this node's SPF has run after a link change, reset DDC state for its addresses with a new heartbeat round (one AEO per node), as a traditional control plane would install new routes",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&Ipv4GlobalRouting::m_resetOnConvergence),
+                   MakeBooleanChecker ())
+    .AddAttribute ("ControlPlane",
+                   "Reach neighbours for DDC locks, vnode updates and heartbeats by calling them Directly, or by sending Messages over the links. Must be set before the Ipv4 stack is installed",
+                   EnumValue (CONTROL_DIRECT),
+                   MakeEnumAccessor (&Ipv4GlobalRouting::m_controlPlane),
+                   MakeEnumChecker (CONTROL_DIRECT, "Direct",
+                                    CONTROL_MESSAGES, "Messages"))
+    .AddAttribute ("ControlProcessingDelay",
+                   "Time a node takes to act on a received DDC control packet",
+                   TimeValue (Seconds (0)),
+                   MakeTimeAccessor (&Ipv4GlobalRouting::m_controlProcessingDelay),
+                   MakeTimeChecker ())
+    .AddAttribute ("ControlBatchDelay",
+                   "Time DDC control messages wait for others to the same neighbour before being sent. With 0 only messages generated at the same instant share a packet",
+                   TimeValue (Seconds (0)),
+                   MakeTimeAccessor (&Ipv4GlobalRouting::m_controlBatchDelay),
+                   MakeTimeChecker ())
+    .AddAttribute ("ControlBatchSize",
+                   "Largest number of DDC control messages carried by one packet. A packet also holds no more than fit in the output device MTU, (MTU - 20 - 2) / 9 messages (162 for a 1500 byte MTU). Control packets are not retransmitted, so small batches that overflow the device queues lose messages",
+                   UintegerValue (64),
+                   MakeUintegerAccessor (&Ipv4GlobalRouting::m_controlBatchSize),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddTraceSource ("ScheduledReversals",
+                     "Number of delayed link reversals queued",
+                     MakeTraceSourceAccessor (&Ipv4GlobalRouting::m_scheduledReversals))
+    .AddTraceSource ("CoalescedReversals",
+                     "Number of delayed link reversal requests merged into one already queued",
+                     MakeTraceSourceAccessor (&Ipv4GlobalRouting::m_coalescedReversals))
+    .AddTraceSource ("ControlTx",
+                     "A DDC control packet is sent, with the outgoing interface",
+                     MakeTraceSourceAccessor (&Ipv4GlobalRouting::m_controlTxTrace))
+    .AddTraceSource ("ControlRx",
+                     "A DDC control packet is received, with the incoming interface",
+                     MakeTraceSourceAccessor (&Ipv4GlobalRouting::m_controlRxTrace))
   ;
   return tid;
 }
 
 Ipv4GlobalRouting::Ipv4GlobalRouting () 
   : m_randomEcmpRouting (false),
-    m_respondToInterfaceEvents (false)
+    m_respondToInterfaceEvents (false),
+    m_flowHashing (false),
+    m_stateKey (KEY_ADDRESS),
+    m_weakEsModel (true),
+    m_nodeId (0),
+    m_defaultOrder (0),
+    m_controlPlane (CONTROL_DIRECT),
+    m_controlBatchSize (64),
+    m_controlLinksWatched (1),
+    m_recomputeOnLinkChange (false),
+    m_routingLinksWatched (1),
+    m_resetOnConvergence (false),
+    m_collectAEO (false),
+    m_scheduledReversals (0),
+    m_coalescedReversals (0),
+    m_hasSaved (false)
 {
   NS_LOG_FUNCTION_NOARGS ();
+  m_toReverseEpoch[0] = 0;
+  m_toReverseEpoch[1] = 0;
 }
 
 Ipv4GlobalRouting::~Ipv4GlobalRouting ()
@@ -91,9 +189,7 @@ Ipv4GlobalRouting::AddHostRouteTo (Ipv4Address dest,
   Ipv4RoutingTableEntry *route = new Ipv4RoutingTableEntry ();
   *route = Ipv4RoutingTableEntry::CreateHostRouteTo (dest, nextHop, interface);
   m_hostRoutes.push_back (route);
-  InitializeDestination(dest);
-  m_vnodeState[0].m_directions[dest][interface] = Out;
-  m_vnodeState[0].m_outputs[dest].push(PriorityInterface(m_priorities[dest][interface], interface));
+  AddRouteInterface (dest, interface);
   
 }
 
@@ -105,9 +201,7 @@ Ipv4GlobalRouting::AddHostRouteTo (Ipv4Address dest,
   Ipv4RoutingTableEntry *route = new Ipv4RoutingTableEntry ();
   *route = Ipv4RoutingTableEntry::CreateHostRouteTo (dest, interface);
   m_hostRoutes.push_back (route);
-  InitializeDestination(dest);
-  m_vnodeState[0].m_directions[dest][interface] = Out;
-  m_vnodeState[0].m_outputs[dest].push(PriorityInterface(m_priorities[dest][interface], interface));
+  AddRouteInterface (dest, interface);
 }
 
 void 
@@ -124,9 +218,7 @@ Ipv4GlobalRouting::AddNetworkRouteTo (Ipv4Address network,
                                                         interface);
   m_networkRoutes.push_back (route);
   if (networkMask == Ipv4Mask(0xffffffff)) {
-    InitializeDestination(network);
-    m_vnodeState[0].m_directions[network][interface] = Out;
-    m_vnodeState[0].m_outputs[network].push(PriorityInterface(m_priorities[network][interface], interface));
+    AddRouteInterface (network, interface);
   }
 }
 
@@ -142,9 +234,7 @@ Ipv4GlobalRouting::AddNetworkRouteTo (Ipv4Address network,
                                                         interface);
   m_networkRoutes.push_back (route);
   if (networkMask == Ipv4Mask(0xffffffff)) {
-    InitializeDestination(network);
-    m_vnodeState[0].m_directions[network][interface] = Out;
-    m_vnodeState[0].m_outputs[network].push(PriorityInterface(m_priorities[network][interface], interface));
+    AddRouteInterface (network, interface);
   }
 }
 
@@ -302,6 +392,21 @@ Ipv4GlobalRouting::DoDispose (void)
     {
       delete (*l);
     }
+  m_interfaceRoutes.clear ();
+  for (PendingReversalMap::iterator it = m_pendingReversals.begin ();
+       it != m_pendingReversals.end (); it++)
+    {
+      it->second.m_timer.Cancel ();
+    }
+  m_pendingReversals.clear ();
+  for (std::vector<EventId>::iterator it = m_controlFlush.begin ();
+       it != m_controlFlush.end (); it++)
+    {
+      it->Cancel ();
+    }
+  m_controlFlush.clear ();
+  m_controlQueues.clear ();
+  m_controlProtocol = 0;
 
   Ipv4RoutingProtocol::DoDispose ();
 }
@@ -366,37 +471,19 @@ Ipv4GlobalRouting::RouteOutput (Ptr<Packet> p, Ipv4Header &header, Ptr<NetDevice
       //NS_LOG_LOGIC ("Multicast destination-- returning false");
       return 0; // Let other routing protocols try to handle this
     }
-  // TODO:  Configurable option to enable RFC 1222 Strong End System Model
-  // Right now, we will be permissive and allow a source to send us
-  // a packet to one of our other interface addresses; that is, the
-  // destination unicast address does not match one of the iif addresses,
-  // but we check our other interfaces.  This could be an option
-  // (to remove the outer loop immediately below and just check iif).
-  for (uint32_t j = 0; j < m_ipv4->GetNInterfaces (); j++)
+  // Locally originated packets have no incoming interface, so any of our
+  // addresses is fine regardless of the end system model
+  if (m_localAddresses.find (header.GetDestination ()) != m_localAddresses.end ())
     {
-      for (uint32_t i = 0; i < m_ipv4->GetNAddresses (j); i++)
-        {
-          Ipv4InterfaceAddress iaddr = m_ipv4->GetAddress (j, i);
-          Ipv4Address addr = iaddr.GetLocal ();
-          if (addr.IsEqual (header.GetDestination ()))
-            {
-              Ptr<Ipv4Route> route;
-              route = Create<Ipv4Route>();
-              route->SetDestination(header.GetDestination());
-              route->SetGateway(header.GetDestination());
-              Ptr<NetDevice> netdev = m_ipv4->GetNetDevice(0);
-              route->SetOutputDevice(netdev);
-              route->SetSource (m_ipv4->GetAddress (0, 0).GetLocal ());
-              return route;
-            }
-        }
+      return GetInterfaceRoute (0);
     }
 //
 // See if this is a unicast packet we have a route for.
 //
   Ptr<Ipv4Route> rtentry;
-  header.SetVnode(m_localVnode[header.GetDestination()]);
-  StandardReceive(header.GetDestination(), header, rtentry, sockerr, 0);
+  uint32_t dest = GetDestinationIndex(header.GetDestination());
+  header.SetVnode(m_destinations[dest].m_localVnode);
+  StandardReceive(dest, header, rtentry, sockerr, 0, m_flowHashing ? GetFlowHash(p, header) : 0);
   NS_LOG_LOGIC ("Unicast destination- looking up");
   return rtentry;
 }
@@ -425,39 +512,11 @@ Ipv4GlobalRouting::RouteInput  (Ptr<const Packet> p, Ipv4Header &header, Ptr<con
       // TODO:  Forward broadcast
     }
 
-  // TODO:  Configurable option to enable RFC 1222 Strong End System Model
-  // Right now, we will be permissive and allow a source to send us
-  // a packet to one of our other interface addresses; that is, the
-  // destination unicast address does not match one of the iif addresses,
-  // but we check our other interfaces.  This could be an option
-  // (to remove the outer loop immediately below and just check iif).
-  for (uint32_t j = 0; j < m_ipv4->GetNInterfaces (); j++)
+  if (IsLocalAddress (header.GetDestination (), iif, true))
     {
-      for (uint32_t i = 0; i < m_ipv4->GetNAddresses (j); i++)
-        {
-          Ipv4InterfaceAddress iaddr = m_ipv4->GetAddress (j, i);
-          Ipv4Address addr = iaddr.GetLocal ();
-          if (addr.IsEqual (header.GetDestination ()))
-            {
-              if (j == iif)
-                {
-                  NS_LOG_LOGIC ("For me (destination " << addr << " match)");
-                }
-              else
-                {
-                  NS_LOG_LOGIC ("For me (destination " << addr << " match) on another interface " << header.GetDestination ());
-                }
-              lcb (p, header, iif);
-              return true;
-            }
-          if (header.GetDestination ().IsEqual (iaddr.GetBroadcast ()))
-            {
-              NS_LOG_LOGIC ("For me (interface broadcast address)");
-              lcb (p, header, iif);
-              return true;
-            }
-          NS_LOG_LOGIC ("Address "<< addr << " not a match");
-        }
+      NS_LOG_LOGIC ("For me (destination " << header.GetDestination () << " match)");
+      lcb (p, header, iif);
+      return true;
     }
   // Check if input device supports IP forwarding
   if (m_ipv4->IsForwarding (iif) == false)
@@ -467,16 +526,18 @@ Ipv4GlobalRouting::RouteInput  (Ptr<const Packet> p, Ipv4Header &header, Ptr<con
       return false;
     }
 
-  Ipv4Address destination = header.GetDestination ();
+  uint32_t dest = GetDestinationIndex(header.GetDestination ());
   uint8_t vnode = header.GetVnode();
+  uint32_t flowHash = (m_flowHashing ? GetFlowHash(p, header) : 0);
   Socket::SocketErrno error;
   Ptr<Ipv4Route> route = 0;
   NS_LOG_LOGIC ("Received for vnode = " << (uint32_t)vnode);
-  if (m_vnodeState[vnode].m_directions[destination][iif] == In) {
+  InterfaceRecord &iface = m_destinations[dest].m_interfaces[iif];
+  if (iface.m_direction[vnode] == In) {
     // This assertion is now approved
-    NS_ASSERT(m_vnodeState[vnode].m_remoteSeq[destination][iif] == header.GetSeq());
+    NS_ASSERT(iface.m_remoteSeq[vnode] == header.GetSeq());
     NS_LOG_LOGIC ("Received along an input port");
-    StandardReceive(destination, header, route, error, iif);
+    StandardReceive(dest, header, route, error, iif, flowHash);
     if (route != 0) {
       ucb(route, p, header);
       return true;
@@ -487,28 +548,28 @@ Ipv4GlobalRouting::RouteInput  (Ptr<const Packet> p, Ipv4Header &header, Ptr<con
     }
   }
   else {
-    if (m_vnodeState[vnode].m_directions[destination][iif] == Out) {
+    if (iface.m_direction[vnode] == Out) {
       NS_LOG_LOGIC ("Received on output port");
-      if (header.GetSeq() == m_vnodeState[vnode].m_remoteSeq[destination][iif]) {
+      if (header.GetSeq() == iface.m_remoteSeq[vnode]) {
         // Send packet back (maybe)
-        NS_LOG_LOGIC ("Bouncing back, header seq = "<<header.GetSeq() << " Remote = " << (uint32_t)(m_vnodeState[vnode].m_remoteSeq[destination][iif])
-                      << " local = " << (uint32_t)(m_vnodeState[vnode].m_localSeq[destination][iif]));
-        CreateRoutingEntry(vnode, iif, destination, header, route);
+        NS_LOG_LOGIC ("Bouncing back, header seq = "<<header.GetSeq() << " Remote = " << (uint32_t)(iface.m_remoteSeq[vnode])
+                      << " local = " << (uint32_t)(iface.m_localSeq[vnode]));
+        CreateRoutingEntry(vnode, iif, dest, header, route);
         ucb(route, p, header);
         return true;
       }
       else {
         NS_LOG_LOGIC("Reversing output to input");
         // TODO Add delay here, it is pretty easy in this case
-        // ReverseOutputToInput(vnode, destination, iif);
+        // ReverseOutputToInput(vnode, dest, iif);
         NS_LOG_LOGIC("Reversing output to input eventually");
         if (!m_reverseOutputToInputDelay.IsZero()) {
-          Simulator::Schedule(m_reverseOutputToInputDelay, &Ipv4GlobalRouting::ReverseOutputToInput, this, vnode, destination, iif);
+          QueueReversal(vnode, dest, iif, false);
         }
         else {
-          ReverseOutputToInput(vnode, destination, iif);
+          ReverseOutputToInput(vnode, dest, iif);
         }
-        StandardReceive(destination, header, route, error, iif);
+        StandardReceive(dest, header, route, error, iif, flowHash);
         if (route != 0) {
           ucb(route, p, header);
           return true;
@@ -521,10 +582,10 @@ Ipv4GlobalRouting::RouteInput  (Ptr<const Packet> p, Ipv4Header &header, Ptr<con
 
     }
     else {
-      m_vnodeState[vnode].m_directions[destination][iif] = In;
-      m_vnodeState[vnode].m_remoteSeq[destination][iif] = header.GetSeq();
+      SetDirection(m_destinations[dest], vnode, iif, In);
+      iface.m_remoteSeq[vnode] = header.GetSeq();
       NS_LOG_LOGIC ("Received on an uncategorized port");
-      StandardReceive(destination, header, route, error, iif);
+      StandardReceive(dest, header, route, error, iif, flowHash);
       if (route != 0) {
         ucb(route, p, header);
         return true;
@@ -541,6 +602,7 @@ void
 Ipv4GlobalRouting::NotifyInterfaceUp (uint32_t i)
 {
   //NS_LOG_FUNCTION (this << i);
+  RebuildLocalAddresses ();
   if (m_respondToInterfaceEvents && Simulator::Now ().GetSeconds () > 0)  // avoid startup events
     {
       GlobalRouteManager::DeleteGlobalRoutes ();
@@ -548,17 +610,17 @@ Ipv4GlobalRouting::NotifyInterfaceUp (uint32_t i)
       GlobalRouteManager::InitializeRoutes ();
     }
   if (Simulator::Now ().GetSeconds() > 0) {
-    for (InterfacePriorities::iterator it = m_priorities.begin();
-         it != m_priorities.end();
+    for (DestinationTable::iterator it = m_destinations.begin();
+         it != m_destinations.end();
          it++) {
-        Ipv4Address dest = (*it).first;
-        uint32_t vnode = m_localVnode[dest];
-        m_vnodeState[vnode].m_directions[dest][i] = Unknown;
-        m_vnodeState[vnode].m_localSeq[dest][i] = 0;
-        m_vnodeState[vnode].m_remoteSeq[dest][i] = 0;
-        m_ttl[dest][i] = 0;
-        m_vnodeState[vnode].m_inputs[dest].push_back(i);
-        m_vnodeState[vnode].m_to_reverse[dest].push_back(i);
+        uint32_t vnode = it->m_localVnode;
+        InterfaceRecord &iface = it->m_interfaces[i];
+        SetDirection(*it, vnode, i, Unknown);
+        iface.m_localSeq[vnode] = 0;
+        iface.m_remoteSeq[vnode] = 0;
+        iface.m_ttl = 0;
+        it->m_vnodes[vnode].m_inputs.push_back(i);
+        GetToReverse(vnode, *it).push_back(i);
     }
   }
 }
@@ -567,6 +629,7 @@ void
 Ipv4GlobalRouting::NotifyInterfaceDown (uint32_t i)
 {
   NS_LOG_FUNCTION (this << i);
+  RebuildLocalAddresses ();
   if (m_respondToInterfaceEvents && Simulator::Now ().GetSeconds () > 0)  // avoid startup events
     {
       GlobalRouteManager::DeleteGlobalRoutes ();
@@ -579,6 +642,7 @@ void
 Ipv4GlobalRouting::NotifyAddAddress (uint32_t interface, Ipv4InterfaceAddress address)
 {
   //NS_LOG_FUNCTION (this << interface << address);
+  RebuildLocalAddresses ();
   if (m_respondToInterfaceEvents && Simulator::Now ().GetSeconds () > 0)  // avoid startup events
     {
       GlobalRouteManager::DeleteGlobalRoutes ();
@@ -591,6 +655,7 @@ void
 Ipv4GlobalRouting::NotifyRemoveAddress (uint32_t interface, Ipv4InterfaceAddress address)
 {
   //NS_LOG_FUNCTION (this << interface << address);
+  RebuildLocalAddresses ();
   if (m_respondToInterfaceEvents && Simulator::Now ().GetSeconds () > 0)  // avoid startup events
     {
       GlobalRouteManager::DeleteGlobalRoutes ();
@@ -605,43 +670,250 @@ Ipv4GlobalRouting::SetIpv4 (Ptr<Ipv4> ipv4)
   //NS_LOG_FUNCTION (this << ipv4);
   NS_ASSERT (m_ipv4 == 0 && ipv4 != 0);
   m_ipv4 = ipv4;
+  RebuildLocalAddresses ();
+  if (m_controlPlane == CONTROL_MESSAGES)
+    {
+      m_controlProtocol = CreateObject<DdcControlProtocol> ();
+      m_controlProtocol->SetReceiveCallback (MakeCallback (&Ipv4GlobalRouting::ReceiveControl, this));
+      m_ipv4->Insert (m_controlProtocol);
+    }
+}
+
+// @apanda
+void
+Ipv4GlobalRouting::RebuildLocalAddresses (void)
+{
+  m_localAddresses.clear ();
+  m_broadcastAddresses.clear ();
+  m_interfaceRoutes.clear ();
+  if (m_ipv4 == 0)
+    {
+      return;
+    }
+  // Addresses on interfaces that are down are still ours, DDC routes packets
+  // for them around the failure
+  for (uint32_t j = 0; j < m_ipv4->GetNInterfaces (); j++)
+    {
+      for (uint32_t i = 0; i < m_ipv4->GetNAddresses (j); i++)
+        {
+          Ipv4InterfaceAddress iaddr = m_ipv4->GetAddress (j, i);
+          m_localAddresses[iaddr.GetLocal ()].push_back (j);
+          m_broadcastAddresses[iaddr.GetBroadcast ()].push_back (j);
+        }
+    }
 }
 
 // @apanda
 bool
-Ipv4GlobalRouting::PrimitiveAEO (Ipv4Address dest)
+Ipv4GlobalRouting::IsLocalAddress (Ipv4Address address, uint32_t iif, bool broadcast) const
 {
-  //NS_LOG_FUNCTION (this << dest);
-  m_aeoRequested[dest] = true;
-  bool success = LocalLock(dest);
+  AddressInterfaceMap::const_iterator it = m_localAddresses.find (address);
+  if (it == m_localAddresses.end ())
+    {
+      if (!broadcast)
+        {
+          return false;
+        }
+      it = m_broadcastAddresses.find (address);
+      if (it == m_broadcastAddresses.end ())
+        {
+          return false;
+        }
+    }
+  if (m_weakEsModel)
+    {
+      return true;
+    }
+  return std::find (it->second.begin (), it->second.end (), iif) != it->second.end ();
+}
+
+// @apanda
+Ptr<Ipv4Route>
+Ipv4GlobalRouting::GetInterfaceRoute (uint32_t interface)
+{
+  if (m_interfaceRoutes.empty ())
+    {
+      // Built lazily so that the neighbours have their addresses by now
+      m_interfaceRoutes.resize (m_ipv4->GetNInterfaces ());
+      for (uint32_t i = 0; i < m_ipv4->GetNInterfaces (); i++)
+        {
+          Ptr<NetDevice> netdev = m_ipv4->GetNetDevice (i);
+          Ipv4Address gateway;
+          if (i == 0)
+            {
+              // Loopback, the gateway is never looked at
+              gateway = Ipv4Address::GetLoopback ();
+            }
+          else
+            {
+              Ptr<Channel> channel = netdev->GetChannel ();
+              if (channel == 0 || channel->GetNDevices () != 2)
+                {
+                  continue;
+                }
+              Ptr<NetDevice> peer = channel->GetDevice (0);
+              if (peer == netdev)
+                {
+                  peer = channel->GetDevice (1);
+                }
+              Ptr<Ipv4> peerIpv4 = peer->GetNode ()->GetObject<Ipv4> ();
+              int32_t peerInterface = (peerIpv4 == 0) ? -1 : peerIpv4->GetInterfaceForDevice (peer);
+              if (peerInterface < 0 || peerIpv4->GetNAddresses (peerInterface) == 0)
+                {
+                  continue;
+                }
+              gateway = peerIpv4->GetAddress (peerInterface, 0).GetLocal ();
+            }
+          if (m_ipv4->GetNAddresses (i) == 0)
+            {
+              continue;
+            }
+          Ptr<Ipv4Route> route = Create<Ipv4Route> ();
+          route->SetDestination (gateway);
+          route->SetGateway (gateway);
+          route->SetOutputDevice (netdev);
+          route->SetSource (m_ipv4->GetAddress (i, 0).GetLocal ());
+          m_interfaceRoutes[i] = route;
+        }
+    }
+  return m_interfaceRoutes[interface];
+}
+
+// @apanda
+bool
+Ipv4GlobalRouting::PrimitiveAEO (Ipv4Address addr)
+{
+  //NS_LOG_FUNCTION (this << addr);
+  uint32_t dest = GetDestinationIndex(addr);
+  m_destinations[dest].m_aeoRequested = true;
+  if (m_collectAEO) {
+    m_collectedAEO.push_back(addr);
+    return false;
+  }
+  if (m_controlPlane == CONTROL_MESSAGES) {
+    // Completes once the neighbours have answered
+    RequestLocks(dest);
+    return false;
+  }
+  bool success = LocalLock(addr);
   //NS_LOG_LOGIC("Acquiring lock " << success);
   // NS_ASSERT_MSG(success, "Could not acquire lock");
   if (success) {
-    m_aeoRequested[dest] = false;
-    uint8_t newVnode = (m_localVnode[dest] + 1) % 2;
-    ClearVnode(newVnode, dest);
-    for (uint32_t i = 1; i < m_ipv4->GetNInterfaces(); i++) {
-      if (m_vnodeState[newVnode].m_directions[dest][i] != Out) { 
-        if (m_vnodeState[newVnode].m_directions[dest][i] != Dead) {  
-          m_vnodeState[newVnode].m_outputs[dest].push(PriorityInterface(m_priorities[dest][i], i));
-          m_vnodeState[newVnode].m_directions[dest][i] = Out;
-          m_vnodeState[newVnode].m_localSeq[dest][i] = 0;
-          m_vnodeState[newVnode].m_remoteSeq[dest][i] = 0;
-          // Reset TTL during AEO operation, this makes sense since AEO is
-          // primarily a control plane primitive, and is called in order, and
-          // sets true directions
-          m_ttl[dest][i] = 0;
-          LocalSetRemoteVnode(dest,  i, newVnode);
-        }
-      }
-    }
-    m_localVnode[dest] = newVnode;
-    LocalUnlock(dest);
+    ExecuteAEO(dest);
     return true;
   }
   return false;
 }
 
+// @apanda
+uint32_t
+Ipv4GlobalRouting::PrimitiveAEO (const std::vector<Ipv4Address> &addrs)
+{
+  if (m_controlPlane == CONTROL_MESSAGES) {
+    // Lock requests for the whole set already share packets
+    for (std::vector<Ipv4Address>::const_iterator it = addrs.begin(); it != addrs.end(); it++) {
+      PrimitiveAEO(*it);
+    }
+    return 0;
+  }
+  uint32_t nInterfaces = m_ipv4->GetNInterfaces();
+  std::vector<Ptr<Ipv4GlobalRouting> > routers (nInterfaces);
+  std::vector<Ptr<NetDevice> > others (nInterfaces);
+  std::vector<uint32_t> otherInterfaces (nInterfaces);
+  for (uint32_t i = 1; i < nInterfaces; i++) {
+    Ptr<NetDevice> device = m_ipv4->GetNetDevice(i);
+    Ptr<Channel> channel = device->GetChannel();
+    others[i] = (channel->GetDevice(0) == device ? channel->GetDevice(1) : channel->GetDevice(0));
+    NS_ASSERT(others[i] != device);
+    routers[i] = others[i]->GetNode()->GetObject<GlobalRouter>()->GetRoutingProtocol();
+    otherInterfaces[i] = routers[i]->m_ipv4->GetInterfaceForDevice(others[i]);
+  }
+  for (std::vector<Ipv4Address>::const_iterator it = addrs.begin(); it != addrs.end(); it++) {
+    m_destinations[GetDestinationIndex(*it)].m_aeoRequested = true;
+  }
+  std::vector<uint32_t> reversed;
+  for (std::vector<Ipv4Address>::const_iterator it = addrs.begin(); it != addrs.end(); it++) {
+    uint32_t dest = GetDestinationIndex(*it);
+    DestinationState &state = m_destinations[dest];
+    NS_ASSERT_MSG(!state.m_held, "No recursive locks");
+    // Listed twice and already done, or waiting on a neighbour's lock
+    if (!state.m_aeoRequested || state.m_lockCount != 0) {
+      continue;
+    }
+    uint32_t locked = 1;
+    while (locked < nInterfaces && routers[locked]->SimpleLock(state.m_address, otherInterfaces[locked])) {
+      locked++;
+    }
+    if (locked < nInterfaces) {
+      for (uint32_t j = 1; j < locked; j++) {
+        routers[j]->SimpleUnlock(state.m_address, otherInterfaces[j]);
+      }
+      continue;
+    }
+    state.m_held = true;
+    ExecuteAEO(dest, false);
+    reversed.push_back(dest);
+  }
+  if (reversed.empty()) {
+    return 0;
+  }
+  // One unlock event per neighbour, then the heartbeats grouped by the link
+  // they leave on
+  std::vector<Ipv4Address> reversedAddrs;
+  std::vector<std::vector<uint32_t> > seqs (nInterfaces);
+  std::vector<std::vector<Ipv4Address> > heartbeats (nInterfaces);
+  for (std::vector<uint32_t>::const_iterator it = reversed.begin(); it != reversed.end(); it++) {
+    const DestinationState &state = m_destinations[*it];
+    reversedAddrs.push_back(state.m_address);
+    for (std::vector<uint32_t>::const_iterator after = state.m_order->m_reverseAfter.begin(); after != state.m_order->m_reverseAfter.end(); after++) {
+      seqs[*after].push_back(state.m_heartbeatSequence);
+      heartbeats[*after].push_back(state.m_address);
+    }
+  }
+  for (uint32_t i = 1; i < nInterfaces; i++) {
+    Simulator::ScheduleNow(&Ipv4GlobalRouting::UnlockBatch, routers[i], reversedAddrs, others[i]);
+  }
+  for (uint32_t i = 1; i < nInterfaces; i++) {
+    if (!heartbeats[i].empty()) {
+      Simulator::ScheduleNow(&Ipv4GlobalRouting::ReceiveHeartbeatBatch, routers[i], seqs[i], heartbeats[i], others[i]);
+    }
+  }
+  return reversed.size();
+}
+
+// @apanda
+void
+Ipv4GlobalRouting::ExecuteAEO (uint32_t dest, bool notify)
+{
+  DestinationState &state = m_destinations[dest];
+  Ipv4Address addr = state.m_address;
+  state.m_aeoRequested = false;
+  uint8_t newVnode = (state.m_localVnode + 1) % 2;
+  ClearVnode(newVnode, dest);
+  for (uint32_t i = 1; i < m_ipv4->GetNInterfaces(); i++) {
+    InterfaceRecord &iface = state.m_interfaces[i];
+    if (iface.m_direction[newVnode] != Out) {
+      if (iface.m_direction[newVnode] != Dead) {
+        SetDirection(state, newVnode, i, Out);
+        iface.m_localSeq[newVnode] = 0;
+        iface.m_remoteSeq[newVnode] = 0;
+        // Reset TTL during AEO operation, this makes sense since AEO is
+        // primarily a control plane primitive, and is called in order, and
+        // sets true directions
+        iface.m_ttl = 0;
+        LocalSetRemoteVnode(addr,  i, newVnode);
+      }
+    }
+  }
+  state.m_localVnode = newVnode;
+  if (notify) {
+    LocalUnlock(addr);
+  }
+  else {
+    state.m_held = false;
+  }
+}
+
 // @apanda
 void
 Ipv4GlobalRouting::SetInterfacePriority (
@@ -649,289 +921,842 @@ Ipv4GlobalRouting::SetInterfacePriority (
     uint32_t interface,
     uint32_t priority) {
   //NS_LOG_LOGIC (this << "setting interface " << interface << " priority to " << priority);
-  m_priorities[dest][interface] = priority;
-  m_vnodeState[0].m_prioritized_links[dest].push(PriorityInterface(priority, interface));
+  DestinationState &state = m_destinations[GetDestinationIndex(dest)];
+  OwnOrder(state).m_priority[interface] = priority;
+  state.m_orderValid = false;
 }
 
 // @apanda
 bool
-Ipv4GlobalRouting::FindOutputPort (uint8_t vnode, Ipv4Address addr, uint32_t &link, uint32_t iif)
+Ipv4GlobalRouting::FindOutputPort (uint8_t vnode, uint32_t dest, uint32_t &link, uint32_t iif, uint32_t flowHash)
 {
-  //NS_LOG_FUNCTION (this << addr);
-  if (m_vnodeState[vnode].m_outputs[addr].empty()) {
-      NS_LOG_LOGIC("Outputs empty");
-      return false;
-  }
-  do {
-    PriorityInterface interface = m_vnodeState[vnode].m_outputs[addr].top();
-    link = interface.second;
-    if (link == iif && m_vnodeState[vnode].m_outputs[addr].size() > 1) {
-      m_vnodeState[vnode].m_outputs[addr].pop();
-      const PriorityInterface iface2 = m_vnodeState[vnode].m_outputs[addr].top();
-      m_vnodeState[vnode].m_outputs[addr].push(interface);
-      interface = iface2;
-    }
-    if (m_vnodeState[vnode].m_directions[addr][link] == Out && m_ipv4->GetNetDevice(link)->IsLinkUp()) {
-      NS_LOG_LOGIC("Returning output link " << link << "(priority = " << interface.first << ")");
-      return true;
-    }
-    else {
-      m_vnodeState[vnode].m_outputs[addr].pop();
+  //NS_LOG_FUNCTION (this << dest);
+  DestinationState &state = m_destinations[dest];
+  UpdateOrder(state);
+  const std::vector<uint64_t> &outputs = state.m_vnodes[vnode].m_outputs;
+  // Walk the Out interfaces in priority order, preferring anything over the
+  // interface the packet came in on
+  bool iifUsable = false;
+  // With flow hashing, the usable links tied for the best priority
+  uint32_t best = 0;
+  m_ties.clear();
+  bool tiesEnded = false;
+  for (uint32_t word = 0; word < outputs.size() && !tiesEnded; word++) {
+    uint64_t bits = outputs[word];
+    while (bits != 0) {
+      uint32_t rank = (word << 6) + __builtin_ctzll(bits);
+      bits &= bits - 1;
+      uint32_t candidate = state.m_order->m_order[rank];
+      if (!m_ties.empty() && state.m_order->m_priority[candidate] != best) {
+        // Ranks are sorted by priority, nothing later ties
+        tiesEnded = true;
+        break;
+      }
+      if (!m_ipv4->GetNetDevice(candidate)->IsLinkUp()) {
+        continue;
+      }
+      if (candidate == iif) {
+        iifUsable = true;
+        continue;
+      }
+      if (!m_flowHashing) {
+        link = candidate;
+        NS_LOG_LOGIC("Returning output link " << link << "(priority = " << state.m_order->m_priority[link] << ")");
+        return true;
+      }
+      best = state.m_order->m_priority[candidate];
+      m_ties.push_back(candidate);
     }
-  } while (!m_vnodeState[vnode].m_outputs[addr].empty());
+  }
+  if (!m_ties.empty()) {
+    link = m_ties[flowHash % m_ties.size()];
+    NS_LOG_LOGIC("Returning hashed output link " << link << " of " << m_ties.size() << " (priority = " << best << ")");
+    return true;
+  }
+  if (iifUsable) {
+    link = iif;
+    NS_LOG_LOGIC("Returning input link as output " << link);
+    return true;
+  }
   NS_LOG_LOGIC("Found no output");
-  return false; 
+  return false;
 }
 
 // @apanda
-bool
-Ipv4GlobalRouting::FindHighPriorityLink(uint8_t vnode, Ipv4Address addr, uint32_t &link)
+uint32_t
+Ipv4GlobalRouting::GetFlowHash (Ptr<const Packet> p, const Ipv4Header &header) const
 {
-  //NS_LOG_FUNCTION (this << addr);
-  if (m_vnodeState[vnode].m_prioritized_links[addr].empty()) {
-      NS_LOG_LOGIC("No links of any sort");
-      return false;
+  // FNV-1a, seeded with the node so that neighbouring switches don't all
+  // make the same choice for a flow
+  uint8_t key[13];
+  uint32_t length = 9;
+  header.GetSource().Serialize(key);
+  header.GetDestination().Serialize(key + 4);
+  key[8] = header.GetProtocol();
+  if ((header.GetProtocol() == 6 || header.GetProtocol() == 17) &&
+      header.GetFragmentOffset() == 0 && p != 0 && p->GetSize() >= 4) {
+    // Source and destination port lead both the TCP and the UDP header
+    p->CopyData(key + 9, 4);
+    length += 4;
   }
-  do {
-    const PriorityInterface interface = m_vnodeState[vnode].m_prioritized_links[addr].top();
-    link = interface.second;
-    if (m_ipv4->GetNetDevice(link)->IsLinkUp()) {
-      NS_LOG_LOGIC("Returning output link " << link << "(priority = " << interface.first << ")");
+  uint32_t hash = 2166136261U ^ m_nodeId;
+  for (uint32_t i = 0; i < length; i++) {
+    hash = (hash ^ key[i]) * 16777619U;
+  }
+  return hash;
+}
+
+// @apanda
+bool
+Ipv4GlobalRouting::FindHighPriorityLink(uint8_t vnode, uint32_t dest, uint32_t &link)
+{
+  //NS_LOG_FUNCTION (this << dest);
+  DestinationState &state = m_destinations[dest];
+  UpdateOrder(state);
+  for (std::vector<uint32_t>::const_iterator it = state.m_order->m_order.begin();
+       it != state.m_order->m_order.end(); it++) {
+    if (m_ipv4->GetNetDevice(*it)->IsLinkUp()) {
+      link = *it;
+      NS_LOG_LOGIC("Returning output link " << link << "(priority = " << state.m_order->m_priority[link] << ")");
       return true;
     }
-    else {
-      m_vnodeState[vnode].m_prioritized_links[addr].pop();
-    }
-  } while (!m_vnodeState[vnode].m_prioritized_links[addr].empty());
+  }
   NS_LOG_LOGIC("Found no output");
-  return false; 
+  return false;
 }
 
 // @apanda
-void
-Ipv4GlobalRouting::InitializeDestination (Ipv4Address dest)
+uint32_t
+Ipv4GlobalRouting::InitializeDestination (Ipv4Address addr)
 {
-  //NS_LOG_FUNCTION (this << dest);
-  //NS_LOG_LOGIC("Initializing stuff for dest = " << dest << " at node " << m_ipv4->GetNetDevice(0)->GetNode()->GetId());
+  //NS_LOG_FUNCTION (this << addr);
+  //NS_LOG_LOGIC("Initializing stuff for dest = " << addr << " at node " << m_ipv4->GetNetDevice(0)->GetNode()->GetId());
   //NS_LOG_LOGIC("Number of interfaces = " << m_ipv4->GetNInterfaces());
-  if (m_vnodeState[0].m_directions.find(dest) != m_vnodeState[0].m_directions.end()) {
+  DestinationIndex::iterator it = m_destinationIndex.find(addr);
+  if (it != m_destinationIndex.end()) {
+    return it->second;
   }
-  else {
-    m_aeoRequested.insert(AeoRequests::value_type(dest, false));
-    m_locks.insert(LockStatus::value_type(dest, std::vector<bool>(m_ipv4->GetNInterfaces(), false)));
-    m_held.insert(LockHeld::value_type(dest, false));
-    m_lockCounts.insert(LockCounts::value_type(dest, 0));
-    m_localVnode.insert(VnodeNumbers::value_type(dest, 0));
-    m_remoteVnode.insert(RemoteVnodeNumbers::value_type(dest, std::vector<uint8_t>(m_ipv4->GetNInterfaces(), 0)));
-    m_priorities.insert(InterfacePriorities::value_type(dest, std::vector<uint32_t>(m_ipv4->GetNInterfaces(), 0)));  
-    m_ttl.insert(InterfacePriorities::value_type(dest, std::vector<uint32_t>(m_ipv4->GetNInterfaces(), 0)));  
-    m_heartbeatSequence.insert(CurrentSequence::value_type(dest, 0));
-    m_heartbeatState.insert(HeartbeatState::value_type(dest, std::vector<bool>(m_ipv4->GetNInterfaces(), false)));
-    for (int i = 0; i < 2; i++) {
-      m_vnodeState[i].m_directions.insert(InterfaceDirection::value_type(dest, std::vector<LinkDirection>(m_ipv4->GetNInterfaces(), Unknown)));
-      m_vnodeState[i].m_inputs.insert(DestinationListInterfaceQueues::value_type(dest, std::list<uint32_t>()));
-      m_vnodeState[i].m_outputs.insert(DestinationPriorityInterfaceQueues::value_type(dest, InterfaceQueue())); 
-      m_vnodeState[i].m_localSeq.insert(SequenceNumbers::value_type(dest, std::vector<uint8_t>(m_ipv4->GetNInterfaces(), 0)));
-      m_vnodeState[i].m_remoteSeq.insert(SequenceNumbers::value_type(dest, std::vector<uint8_t>(m_ipv4->GetNInterfaces(), 0)));
-      m_vnodeState[i].m_to_reverse.insert(DestinationListInterfaceQueues::value_type(dest, std::list<uint32_t>()));
-      m_vnodeState[i].m_prioritized_links.insert(DestinationPriorityInterfaceQueues::value_type(dest, InterfaceQueue())); 
+  uint32_t dest = m_destinations.size();
+  m_destinationIndex.insert(DestinationIndex::value_type(addr, dest));
+  m_destinations.push_back(DestinationState());
+  DestinationState &state = m_destinations.back();
+  InterfaceRecord iface;
+  iface.m_ttl = 0;
+  iface.m_remoteVnode = 0;
+  iface.m_lock = false;
+  iface.m_heartbeat = false;
+  iface.m_remoteLock = REMOTE_UNLOCKED;
+  for (int i = 0; i < 2; i++) {
+    iface.m_direction[i] = Unknown;
+    iface.m_localSeq[i] = 0;
+    iface.m_remoteSeq[i] = 0;
+    state.m_vnodes[i].m_toReverseEpoch = m_toReverseEpoch[i];
+  }
+  state.m_address = addr;
+  state.m_interfaces.assign(m_ipv4->GetNInterfaces(), iface);
+  state.m_order = GetDefaultOrder();
+  state.m_ownOrder = 0;
+  state.m_orderValid = false;
+  for (int i = 0; i < 2; i++) {
+    state.m_vnodes[i].m_outputs.assign((m_ipv4->GetNInterfaces() + 63) / 64, 0);
+  }
+  state.m_localVnode = 0;
+  state.m_held = false;
+  state.m_lockFailed = false;
+  state.m_aeoRequested = false;
+  state.m_hasReversalOrder = false;
+  state.m_lockCount = 0;
+  state.m_lockWaiting = 0;
+  state.m_heartbeatSequence = 0;
+  ApplyDistances(state);
+  AddressInterfaceMap::iterator routes = m_routeInterfaces.find(addr);
+  if (routes != m_routeInterfaces.end()) {
+    for (std::vector<uint32_t>::const_iterator it = routes->second.begin();
+         it != routes->second.end(); it++) {
+      SetDirection(state, 0, *it, Out);
     }
+    m_routeInterfaces.erase(routes);
   }
+  return dest;
 }
 
 // @apanda
-void 
-Ipv4GlobalRouting::ReverseInputToOutput (uint8_t vnode, Ipv4Address addr, uint32_t link) 
+void
+Ipv4GlobalRouting::AddRouteInterface (Ipv4Address addr, uint32_t interface)
 {
-  if (m_vnodeState[vnode].m_directions[addr][link] != In) {
+  // State lives under the destination key, and an alias of an existing
+  // destination need not have been looked up yet
+  Ipv4Address key = GetDestinationKey(addr);
+  DestinationIndex::const_iterator it = m_destinationIndex.find(key);
+  if (it != m_destinationIndex.end()) {
+    SetDirection(m_destinations[it->second], 0, interface, Out);
     return;
   }
-  //NS_LOG_FUNCTION (this << vnode << addr << link);
-  m_reversalCallback(link, addr);
-  m_ttl[addr][link]++;
-  m_vnodeState[vnode].m_directions[addr][link] = Out;
-  m_vnodeState[vnode].m_inputs[addr].remove(link);
-  m_vnodeState[vnode].m_outputs[addr].push(PriorityInterface(m_priorities[addr][link], link));
-  m_vnodeState[vnode].m_localSeq[addr][link] = ((m_vnodeState[vnode].m_localSeq[addr][link] + 1) & 0x1);
+  // Don't create DDC state just for a route, wait for a packet or AEO
+  std::vector<uint32_t> &interfaces = m_routeInterfaces[key];
+  if (std::find(interfaces.begin(), interfaces.end(), interface) == interfaces.end()) {
+    interfaces.push_back(interface);
+  }
 }
 
 // @apanda
-void 
-Ipv4GlobalRouting::ReverseOutputToInput (uint8_t vnode, Ipv4Address addr, uint32_t link) 
+void
+Ipv4GlobalRouting::ApplyDistances (DestinationState &state)
 {
-  if (m_vnodeState[vnode].m_directions[addr][link] != Out) {
+  if (m_distanceTable == 0) {
+    return;
+  }
+  uint32_t destNode = m_distanceTable->GetNode(state.m_address);
+  if (destNode == DdcDistanceTable::NO_NODE) {
+    // Don't keep pointing into the order of a previous table, which goes
+    // away once SetDistanceTable is done. A reversal order that was set is
+    // kept in our own copy.
+    if (state.m_hasReversalOrder) {
+      OwnOrder(state);
+    }
+    else if (state.m_order != state.m_ownOrder) {
+      state.m_order = GetDefaultOrder();
+    }
+    state.m_orderValid = false;
     return;
   }
-  NS_ASSERT(m_vnodeState[vnode].m_directions[addr][link] == Out);
-  NS_LOG_FUNCTION (this << vnode << addr << link);
-  m_reversalCallback(link, addr);
-  m_ttl[addr][link]++;
-  m_vnodeState[vnode].m_directions[addr][link] = In;
-  m_vnodeState[vnode].m_inputs[addr].push_front(link);
-  m_vnodeState[vnode].m_remoteSeq[addr][link] = ((m_vnodeState[vnode].m_remoteSeq[addr][link] + 1) & 0x1);
+  // The table works the order out once for every address of destNode and
+  // for every other router with the same destination state
+  const DdcPriorityOrder *order = m_distanceTable->GetPriorityOrder(m_nodeId, destNode);
+  if (order->m_priority.size() != state.m_interfaces.size()) {
+    // Interfaces were added since the distances were computed, the extra
+    // ones get priority 0
+    DdcPriorityOrder &own = OwnOrder(state);
+    own.m_priority.assign(order->m_priority.begin(), order->m_priority.end());
+    own.m_priority.resize(state.m_interfaces.size(), 0);
+    own.m_rank.resize(state.m_interfaces.size());
+    if (!state.m_hasReversalOrder) {
+      own.m_reverseBefore = order->m_reverseBefore;
+      own.m_reverseAfter = order->m_reverseAfter;
+    }
+  }
+  else if (state.m_hasReversalOrder &&
+           (state.m_order->m_reverseBefore != order->m_reverseBefore ||
+            state.m_order->m_reverseAfter != order->m_reverseAfter)) {
+    // Keep the reversal order we already have, only the priorities change
+    DdcPriorityOrder &own = OwnOrder(state);
+    own.m_priority = order->m_priority;
+    own.m_order = order->m_order;
+    own.m_rank = order->m_rank;
+  }
+  else {
+    state.m_order = order;
+  }
+  state.m_orderValid = false;
 }
 
 // @apanda
 void
-Ipv4GlobalRouting::SendOnOutlink (uint8_t vnode, Ipv4Address addr, Ipv4Header& header, uint32_t link)
+Ipv4GlobalRouting::SetDistanceTable (Ptr<DdcDistanceTable> table, uint32_t nodeId, const std::vector<uint32_t> &neighbours)
 {
-  NS_LOG_FUNCTION (this << addr);
-  //NS_LOG_LOGIC("Setting sequence number to " << (uint32_t)m_vnodeState[vnode].m_localSeq[addr][link]);
-  header.SetSeq(m_vnodeState[vnode].m_localSeq[addr][link]);
-  //NS_LOG_LOGIC("Sequence number is " << header.GetSeq());
-  //NS_LOG_LOGIC("Setting vnode number to " << (uint32_t)m_remoteVnode[addr][link]);
-  header.SetVnode(m_remoteVnode[addr][link]);
+  // Destinations point into the old table's priority orders until they are
+  // refreshed below, keep it around until then
+  Ptr<DdcDistanceTable> previous = m_distanceTable;
+  m_distanceTable = table;
+  m_nodeId = nodeId;
+  m_distanceTable->SetNeighbours(nodeId, neighbours);
+  if (m_stateKey == KEY_NODE) {
+    // Routes were installed before we knew which node each address is on,
+    // merge them under the node's key
+    AddressInterfaceMap routes;
+    routes.swap(m_routeInterfaces);
+    for (AddressInterfaceMap::const_iterator it = routes.begin(); it != routes.end(); it++) {
+      for (std::vector<uint32_t>::const_iterator iface = it->second.begin(); iface != it->second.end(); iface++) {
+        AddRouteInterface(it->first, *iface);
+      }
+    }
+  }
+  // Routes are being recomputed, refresh priorities for what already exists
+  RefreshDistances();
+  m_distanceTable->ReleasePriorityOrders();
+  if (m_controlPlane == CONTROL_MESSAGES) {
+    WatchControlLinks();
+  }
+  if (m_recomputeOnLinkChange) {
+    for (uint32_t i = m_routingLinksWatched; i < m_ipv4->GetNInterfaces(); i++) {
+      m_ipv4->GetNetDevice(i)->AddLinkChangeCallback(MakeCallback(&Ipv4GlobalRouting::RoutingLinkChange, this).Bind(i));
+    }
+    m_routingLinksWatched = std::max(m_routingLinksWatched, m_ipv4->GetNInterfaces());
+  }
 }
 
 // @apanda
 void
-Ipv4GlobalRouting::CreateRoutingEntry (uint8_t vnode, uint32_t link, Ipv4Address addr, Ipv4Header& header, Ptr<Ipv4Route> &route)
+Ipv4GlobalRouting::RefreshDistances (void)
 {
-  SendOnOutlink(vnode, addr, header, link);
-  route = Create<Ipv4Route>();
-  route->SetDestination(header.GetDestination());
-  route->SetGateway(header.GetDestination());
-  Ptr<NetDevice> netdev = m_ipv4->GetNetDevice(link);
-  route->SetOutputDevice(netdev);
-  route->SetSource (m_ipv4->GetAddress (link, 0).GetLocal ());
+  for (DestinationTable::iterator it = m_destinations.begin(); it != m_destinations.end(); it++) {
+    ApplyDistances(*it);
+  }
 }
 
 // @apanda
 void
-Ipv4GlobalRouting::StandardReceive (Ipv4Address addr, Ipv4Header& header, 
-                                Ptr<Ipv4Route> &route, Socket::SocketErrno &error, uint32_t iif)
+Ipv4GlobalRouting::RefreshDestination (uint32_t node)
 {
-  NS_LOG_FUNCTION (this << addr);
-  route = 0;
-  uint32_t link;
-  uint8_t vnode = header.GetVnode();
-  do {
-    if (FindOutputPort(vnode, addr, link, iif)) {
-      NS_LOG_LOGIC ("Choosing to use output port " << link);
-      CreateRoutingEntry(vnode, link, addr, header, route);
-      return;
-    }
-    if (m_allowReversal) {
-      NS_LOG_LOGIC ("Reversing " << addr);
-      ScheduleReversals(vnode, addr);
-      
-      if (m_vnodeState[vnode].m_outputs[addr].empty()) {
-        NS_LOG_LOGIC ("Failed to find a link, so just using first high priority link " << addr);
-        if (FindHighPriorityLink(vnode, addr, link)) {
-          CreateRoutingEntry(vnode, link, addr, header, route);
-          return;
-        }
-        else {
-          error = Socket::ERROR_NOROUTETOHOST;
-          NS_LOG_LOGIC("No path to " << addr);
-          return;
-        }
-      }
-    }
-    else {
-      error = Socket::ERROR_NOROUTETOHOST;
-      return;
+  if (m_distanceTable == 0) {
+    return;
+  }
+  for (DestinationTable::iterator it = m_destinations.begin(); it != m_destinations.end(); it++) {
+    if (m_distanceTable->GetNode(it->m_address) == node) {
+      ApplyDistances(*it);
     }
-  } while (!m_vnodeState[vnode].m_inputs[addr].empty() || !m_vnodeState[vnode].m_outputs[addr].empty());
+  }
 }
 
 // @apanda
 void
-Ipv4GlobalRouting::ScheduleReversals (uint8_t vnode, Ipv4Address addr)
+Ipv4GlobalRouting::GetConvergenceModel (Time &lsaHopDelay, Time &spfDelay, Time &spfHoldTime, bool &reset) const
 {
-  //NS_LOG_FUNCTION (this << addr);
-  if (m_vnodeState[vnode].m_to_reverse[addr].empty()) {
-    m_vnodeState[vnode].m_to_reverse[addr].insert(m_vnodeState[vnode].m_to_reverse[addr].begin(), 
-                        m_vnodeState[vnode].m_inputs[addr].begin(), 
-                        m_vnodeState[vnode].m_inputs[addr].end()); 
-  }
-  
-  for (std::list<uint32_t>::iterator it = m_vnodeState[vnode].m_to_reverse[addr].begin();
-      it != m_vnodeState[vnode].m_to_reverse[addr].end();
-      it++) {
-    // ReverseInputToOutput(vnode, addr, *it)
-    NS_LOG_LOGIC("Scheduling reversal from input to output");
-    if (!m_reverseInputToOutputDelay.IsZero()) {
-      Simulator::Schedule(m_reverseInputToOutputDelay, &Ipv4GlobalRouting::ReverseInputToOutput, this, vnode, addr, *it);
-    }
-    else {
-      ReverseInputToOutput(vnode, addr, *it);
-    }
-  }
-  m_vnodeState[vnode].m_to_reverse.clear();
-  m_vnodeState[vnode].m_to_reverse[addr].insert(m_vnodeState[vnode].m_to_reverse[addr].begin(), m_vnodeState[vnode].m_inputs[addr].begin(), m_vnodeState[vnode].m_inputs[addr].end()); 
+  lsaHopDelay = m_lsaHopDelay;
+  spfDelay = m_spfDelay;
+  spfHoldTime = m_spfHoldTime;
+  reset = m_resetOnConvergence;
 }
 
 // @apanda
 void
-Ipv4GlobalRouting::ClearVnode(uint8_t vnode, Ipv4Address dest)
-{
-  m_vnodeState[vnode].m_directions.erase(dest);
-  m_vnodeState[vnode].m_directions.insert(InterfaceDirection::value_type(dest, std::vector<LinkDirection>(m_ipv4->GetNInterfaces(), Unknown)));
-  m_vnodeState[vnode].m_inputs.erase(dest);
-  m_vnodeState[vnode].m_inputs.insert(DestinationListInterfaceQueues::value_type(dest, std::list<uint32_t>()));
-  m_vnodeState[vnode].m_outputs.erase(dest);
-  m_vnodeState[vnode].m_outputs.insert(DestinationPriorityInterfaceQueues::value_type(dest, InterfaceQueue())); 
-  m_vnodeState[vnode].m_localSeq.erase(dest);
-  m_vnodeState[vnode].m_localSeq.insert(SequenceNumbers::value_type(dest, std::vector<uint8_t>(m_ipv4->GetNInterfaces(), 0)));
-  m_vnodeState[vnode].m_remoteSeq.erase(dest);
-  m_vnodeState[vnode].m_remoteSeq.insert(SequenceNumbers::value_type(dest, std::vector<uint8_t>(m_ipv4->GetNInterfaces(), 0)));
-  m_vnodeState[vnode].m_to_reverse.erase(dest);
-  m_vnodeState[vnode].m_to_reverse.insert(DestinationListInterfaceQueues::value_type(dest, std::list<uint32_t>()));
-  m_vnodeState[vnode].m_prioritized_links.erase(dest);
-  m_vnodeState[vnode].m_prioritized_links.insert(DestinationPriorityInterfaceQueues::value_type(dest, InterfaceQueue())); 
-  for (uint32_t i = 1; i < m_ipv4->GetNInterfaces(); i++) {
-    m_vnodeState[vnode].m_prioritized_links[dest].push(PriorityInterface(m_priorities[dest][i], i));  
+Ipv4GlobalRouting::SaveDdcState (void)
+{
+  std::map<const DdcPriorityOrder *, uint32_t> ownIndex;
+  for (uint32_t i = 0; i < m_ownOrders.size(); i++) {
+    ownIndex[&m_ownOrders[i]] = i;
   }
+  m_saved.m_destinationIndex = m_destinationIndex;
+  m_saved.m_destinations = m_destinations;
+  m_saved.m_ownOrders = m_ownOrders;
+  m_saved.m_defaultOrderIndex = m_defaultOrder == 0 ? DdcDistanceTable::NO_NODE : ownIndex[m_defaultOrder];
+  m_saved.m_ownOrderIndex.resize(m_destinations.size());
+  m_saved.m_orderIndex.resize(m_destinations.size());
+  for (uint32_t dest = 0; dest < m_destinations.size(); dest++) {
+    const DestinationState &state = m_destinations[dest];
+    m_saved.m_ownOrderIndex[dest] = state.m_ownOrder == 0 ? DdcDistanceTable::NO_NODE : ownIndex[state.m_ownOrder];
+    std::map<const DdcPriorityOrder *, uint32_t>::const_iterator order = ownIndex.find(state.m_order);
+    m_saved.m_orderIndex[dest] = order == ownIndex.end() ? DdcDistanceTable::NO_NODE : order->second;
+  }
+  m_saved.m_routeInterfaces = m_routeInterfaces;
+  m_saved.m_toReverseEpoch[0] = m_toReverseEpoch[0];
+  m_saved.m_toReverseEpoch[1] = m_toReverseEpoch[1];
+  m_hasSaved = true;
 }
 
 // @apanda
-bool
-Ipv4GlobalRouting::SimpleLock (Ipv4Address addr, uint32_t link)
+void
+Ipv4GlobalRouting::RestoreDdcState (void)
 {
-  if (!m_held[addr]) {
-    NS_ASSERT_MSG(!m_locks[addr][link], "Should not reaquire a lock");
-    m_locks[addr][link] = true;
-    m_lockCounts[addr] += 1;
-    return true;
+  NS_ASSERT_MSG(m_hasSaved, "RestoreDdcState without SaveDdcState");
+  for (PendingReversalMap::iterator it = m_pendingReversals.begin(); it != m_pendingReversals.end(); it++) {
+    it->second.m_timer.Cancel();
+  }
+  m_pendingReversals.clear();
+  for (uint32_t i = 0; i < m_controlQueues.size(); i++) {
+    m_controlFlush[i].Cancel();
+    m_controlQueues[i].Clear();
+  }
+  m_collectAEO = false;
+  m_collectedAEO.clear();
+
+  m_destinationIndex = m_saved.m_destinationIndex;
+  m_destinations = m_saved.m_destinations;
+  m_ownOrders = m_saved.m_ownOrders;
+  m_defaultOrder = m_saved.m_defaultOrderIndex == DdcDistanceTable::NO_NODE ? 0 : &m_ownOrders[m_saved.m_defaultOrderIndex];
+  m_routeInterfaces = m_saved.m_routeInterfaces;
+  m_toReverseEpoch[0] = m_saved.m_toReverseEpoch[0];
+  m_toReverseEpoch[1] = m_saved.m_toReverseEpoch[1];
+  // Shared orders may have been rebuilt since, look them up again
+  for (uint32_t dest = 0; dest < m_destinations.size(); dest++) {
+    DestinationState &state = m_destinations[dest];
+    uint32_t own = m_saved.m_ownOrderIndex[dest];
+    state.m_ownOrder = own == DdcDistanceTable::NO_NODE ? 0 : &m_ownOrders[own];
+    uint32_t order = m_saved.m_orderIndex[dest];
+    if (order != DdcDistanceTable::NO_NODE) {
+      state.m_order = &m_ownOrders[order];
+    }
+    else {
+      uint32_t node = m_distanceTable == 0 ? DdcDistanceTable::NO_NODE : m_distanceTable->GetNode(state.m_address);
+      if (node == DdcDistanceTable::NO_NODE) {
+        state.m_order = GetDefaultOrder();
+      }
+      else {
+        state.m_order = m_distanceTable->GetPriorityOrder(m_nodeId, node);
+      }
+    }
+    state.m_orderValid = false;
   }
-  return false;
 }
 
 // @apanda
 void
-Ipv4GlobalRouting::SimpleUnlock (Ipv4Address addr, uint32_t link)
+Ipv4GlobalRouting::RoutingLinkChange (uint32_t iface)
 {
-  NS_ASSERT_MSG(!m_held[addr], "If someone else thinks they have it, I better not hold it");
-  NS_ASSERT_MSG(m_locks[addr][link], "Don't free something you don't hold");
-  m_locks[addr][link] = false;
-  m_lockCounts[addr] -= 1;
-  if (m_aeoRequested[addr] && m_lockCounts[addr] == 0) {
-    PrimitiveAEO(addr);
-  }
+  GlobalRouteManager::NotifyLinkChange(m_nodeId, iface, m_ipv4->GetNetDevice(iface)->IsLinkUp());
 }
 
 // @apanda
-bool 
-Ipv4GlobalRouting::Lock (Ipv4Address addr, Ptr<NetDevice> link)
+const DdcPriorityOrder*
+Ipv4GlobalRouting::GetPriorityOrder (Ipv4Address dest) const
 {
-  return SimpleLock(addr, m_ipv4->GetInterfaceForDevice(link));
+  DestinationIndex::const_iterator it = m_destinationIndex.find(GetDestinationKey(dest));
+  if (it == m_destinationIndex.end()) {
+    return 0;
+  }
+  return m_destinations[it->second].m_order;
 }
 
 // @apanda
-void 
+uint32_t
+Ipv4GlobalRouting::GetNDestinations (void) const
+{
+  return m_destinations.size();
+}
+
+// @apanda
+uint64_t
+Ipv4GlobalRouting::GetMemoryUsage (void) const
+{
+  // std::list nodes carry two pointers, hash map nodes a next pointer and
+  // every bucket is a pointer
+  const uint64_t listNode = sizeof(uint32_t) + 2 * sizeof(void *);
+  uint64_t bytes = m_destinations.size() * sizeof(DestinationState);
+  bytes += m_destinationIndex.size() * (sizeof(DestinationIndex::value_type) + sizeof(void *));
+  bytes += m_destinationIndex.bucket_count() * sizeof(void *);
+  for (DestinationTable::const_iterator it = m_destinations.begin(); it != m_destinations.end(); it++) {
+    bytes += it->m_interfaces.capacity() * sizeof(InterfaceRecord);
+    for (int vnode = 0; vnode < 2; vnode++) {
+      const VnodeState &vstate = it->m_vnodes[vnode];
+      bytes += (vstate.m_inputs.size() + vstate.m_toReverse.size()) * listNode;
+      bytes += vstate.m_outputs.capacity() * sizeof(uint64_t);
+    }
+  }
+  // Shared priority orders are counted by the distance table
+  for (std::deque<DdcPriorityOrder>::const_iterator it = m_ownOrders.begin(); it != m_ownOrders.end(); it++) {
+    bytes += sizeof(DdcPriorityOrder);
+    bytes += (it->m_priority.capacity() + it->m_order.capacity()) * sizeof(uint32_t);
+    bytes += it->m_rank.capacity() * sizeof(uint16_t);
+    bytes += (it->m_reverseBefore.capacity() + it->m_reverseAfter.capacity()) * sizeof(uint32_t);
+  }
+  for (AddressInterfaceMap::const_iterator it = m_routeInterfaces.begin(); it != m_routeInterfaces.end(); it++) {
+    bytes += sizeof(AddressInterfaceMap::value_type) + sizeof(void *) + it->second.capacity() * sizeof(uint32_t);
+  }
+  bytes += m_routeInterfaces.bucket_count() * sizeof(void *);
+  for (PendingReversalMap::const_iterator it = m_pendingReversals.begin(); it != m_pendingReversals.end(); it++) {
+    bytes += sizeof(PendingReversalMap::value_type) + 3 * sizeof(void *) + it->second.m_links.capacity() * sizeof(uint32_t)
+      + it->second.m_pending.capacity() / 8;
+  }
+  return bytes;
+}
+
+// @apanda
+uint32_t
+Ipv4GlobalRouting::GetDestinationIndex (Ipv4Address addr)
+{
+  DestinationIndex::const_iterator it = m_destinationIndex.find(addr);
+  if (it != m_destinationIndex.end()) {
+    return it->second;
+  }
+  Ipv4Address key = GetDestinationKey(addr);
+  uint32_t dest = InitializeDestination(key);
+  if (key != addr) {
+    // Remember the mapping so that the next lookup is a single probe
+    m_destinationIndex.insert(DestinationIndex::value_type(addr, dest));
+  }
+  return dest;
+}
+
+// @apanda
+Ipv4Address
+Ipv4GlobalRouting::GetDestinationKey (Ipv4Address addr) const
+{
+  if (m_stateKey != KEY_NODE || m_distanceTable == 0) {
+    return addr;
+  }
+  uint32_t node = m_distanceTable->GetNode(addr);
+  if (node == DdcDistanceTable::NO_NODE) {
+    return addr;
+  }
+  return m_distanceTable->GetNodeAddress(node);
+}
+
+// @apanda
+std::list<uint32_t>&
+Ipv4GlobalRouting::GetToReverse (uint8_t vnode, DestinationState &state)
+{
+  VnodeState &vstate = state.m_vnodes[vnode];
+  if (vstate.m_toReverseEpoch != m_toReverseEpoch[vnode]) {
+    vstate.m_toReverse.clear();
+    vstate.m_toReverseEpoch = m_toReverseEpoch[vnode];
+  }
+  return vstate.m_toReverse;
+}
+
+// @apanda
+void
+Ipv4GlobalRouting::SetDirection (DestinationState &state, uint8_t vnode, uint32_t iface, LinkDirection direction)
+{
+  InterfaceRecord &record = state.m_interfaces[iface];
+  record.m_direction[vnode] = direction;
+  if (!state.m_orderValid || iface == 0) {
+    // The masks get rebuilt from the directions once the order is known
+    return;
+  }
+  uint32_t rank = state.m_order->m_rank[iface];
+  uint64_t bit = ((uint64_t)1) << (rank & 63);
+  if (direction == Out) {
+    state.m_vnodes[vnode].m_outputs[rank >> 6] |= bit;
+  }
+  else {
+    state.m_vnodes[vnode].m_outputs[rank >> 6] &= ~bit;
+  }
+}
+
+// @apanda
+void
+Ipv4GlobalRouting::UpdateOrder (DestinationState &state)
+{
+  if (state.m_orderValid) {
+    return;
+  }
+  if (state.m_order == state.m_ownOrder) {
+    // Shared orders are sorted already, ours may have changed priorities
+    std::vector<PriorityInterface> order;
+    for (uint32_t i = 1; i < state.m_interfaces.size(); i++) {
+      order.push_back(PriorityInterface(state.m_ownOrder->m_priority[i], i));
+    }
+    std::sort(order.begin(), order.end());
+    state.m_ownOrder->m_order.resize(order.size());
+    for (uint32_t rank = 0; rank < order.size(); rank++) {
+      state.m_ownOrder->m_order[rank] = order[rank].second;
+      state.m_ownOrder->m_rank[order[rank].second] = rank;
+    }
+  }
+  for (int vnode = 0; vnode < 2; vnode++) {
+    std::fill(state.m_vnodes[vnode].m_outputs.begin(), state.m_vnodes[vnode].m_outputs.end(), 0);
+  }
+  const std::vector<uint32_t> &order = state.m_order->m_order;
+  for (uint32_t rank = 0; rank < order.size(); rank++) {
+    for (int vnode = 0; vnode < 2; vnode++) {
+      if (state.m_interfaces[order[rank]].m_direction[vnode] == Out) {
+        state.m_vnodes[vnode].m_outputs[rank >> 6] |= ((uint64_t)1) << (rank & 63);
+      }
+    }
+  }
+  state.m_orderValid = true;
+}
+
+// @apanda
+DdcPriorityOrder&
+Ipv4GlobalRouting::OwnOrder (DestinationState &state)
+{
+  if (state.m_order != state.m_ownOrder) {
+    if (state.m_ownOrder == 0) {
+      m_ownOrders.push_back(DdcPriorityOrder());
+      state.m_ownOrder = &m_ownOrders.back();
+    }
+    *state.m_ownOrder = *state.m_order;
+    state.m_order = state.m_ownOrder;
+  }
+  return *state.m_ownOrder;
+}
+
+// @apanda
+const DdcPriorityOrder*
+Ipv4GlobalRouting::GetDefaultOrder (void)
+{
+  uint32_t nInterfaces = m_ipv4->GetNInterfaces();
+  if (m_defaultOrder == 0 || m_defaultOrder->m_priority.size() != nInterfaces) {
+    m_ownOrders.push_back(DdcPriorityOrder());
+    m_defaultOrder = &m_ownOrders.back();
+    m_defaultOrder->m_priority.assign(nInterfaces, 0);
+    m_defaultOrder->m_rank.assign(nInterfaces, 0);
+    for (uint32_t i = 1; i < nInterfaces; i++) {
+      m_defaultOrder->m_order.push_back(i);
+      m_defaultOrder->m_rank[i] = i - 1;
+    }
+  }
+  return m_defaultOrder;
+}
+
+// @apanda
+void
+Ipv4GlobalRouting::ReverseInputToOutput (uint8_t vnode, uint32_t dest, uint32_t link)
+{
+  DestinationState &state = m_destinations[dest];
+  InterfaceRecord &iface = state.m_interfaces[link];
+  if (iface.m_direction[vnode] != In) {
+    return;
+  }
+  //NS_LOG_FUNCTION (this << vnode << state.m_address << link);
+  m_reversalCallback(link, state.m_address);
+  iface.m_ttl++;
+  SetDirection(state, vnode, link, Out);
+  state.m_vnodes[vnode].m_inputs.remove(link);
+  iface.m_localSeq[vnode] = ((iface.m_localSeq[vnode] + 1) & 0x1);
+}
+
+// @apanda
+void
+Ipv4GlobalRouting::ReverseOutputToInput (uint8_t vnode, uint32_t dest, uint32_t link)
+{
+  DestinationState &state = m_destinations[dest];
+  InterfaceRecord &iface = state.m_interfaces[link];
+  if (iface.m_direction[vnode] != Out) {
+    return;
+  }
+  NS_ASSERT(iface.m_direction[vnode] == Out);
+  NS_LOG_FUNCTION (this << vnode << state.m_address << link);
+  m_reversalCallback(link, state.m_address);
+  iface.m_ttl++;
+  SetDirection(state, vnode, link, In);
+  state.m_vnodes[vnode].m_inputs.push_front(link);
+  iface.m_remoteSeq[vnode] = ((iface.m_remoteSeq[vnode] + 1) & 0x1);
+}
+
+// @apanda
+void
+Ipv4GlobalRouting::SendOnOutlink (uint8_t vnode, uint32_t dest, Ipv4Header& header, uint32_t link)
+{
+  NS_LOG_FUNCTION (this << dest);
+  const InterfaceRecord &iface = m_destinations[dest].m_interfaces[link];
+  //NS_LOG_LOGIC("Setting sequence number to " << (uint32_t)iface.m_localSeq[vnode]);
+  header.SetSeq(iface.m_localSeq[vnode]);
+  //NS_LOG_LOGIC("Sequence number is " << header.GetSeq());
+  //NS_LOG_LOGIC("Setting vnode number to " << (uint32_t)iface.m_remoteVnode);
+  header.SetVnode(iface.m_remoteVnode);
+}
+
+// @apanda
+void
+Ipv4GlobalRouting::CreateRoutingEntry (uint8_t vnode, uint32_t link, uint32_t dest, Ipv4Header& header, Ptr<Ipv4Route> &route)
+{
+  SendOnOutlink(vnode, dest, header, link);
+  route = GetInterfaceRoute(link);
+  if (route != 0) {
+    return;
+  }
+  route = Create<Ipv4Route>();
+  route->SetDestination(header.GetDestination());
+  route->SetGateway(header.GetDestination());
+  Ptr<NetDevice> netdev = m_ipv4->GetNetDevice(link);
+  route->SetOutputDevice(netdev);
+  route->SetSource (m_ipv4->GetAddress (link, 0).GetLocal ());
+}
+
+// @apanda
+void
+Ipv4GlobalRouting::StandardReceive (uint32_t dest, Ipv4Header& header,
+                                Ptr<Ipv4Route> &route, Socket::SocketErrno &error, uint32_t iif,
+                                uint32_t flowHash)
+{
+  NS_LOG_FUNCTION (this << dest);
+  route = 0;
+  uint32_t link;
+  uint8_t vnode = header.GetVnode();
+  if (FindOutputPort(vnode, dest, link, iif, flowHash)) {
+    NS_LOG_LOGIC ("Choosing to use output port " << link);
+    CreateRoutingEntry(vnode, link, dest, header, route);
+    return;
+  }
+  if (!m_allowReversal) {
+    error = Socket::ERROR_NOROUTETOHOST;
+    return;
+  }
+  NS_LOG_LOGIC ("Reversing " << m_destinations[dest].m_address);
+  ScheduleReversals(vnode, dest);
+  // Reversals that happen right away give us new outputs
+  if (FindOutputPort(vnode, dest, link, iif, flowHash)) {
+    NS_LOG_LOGIC ("Choosing to use reversed output port " << link);
+    CreateRoutingEntry(vnode, link, dest, header, route);
+    return;
+  }
+  NS_LOG_LOGIC ("Failed to find a link, so just using first high priority link " << m_destinations[dest].m_address);
+  if (FindHighPriorityLink(vnode, dest, link)) {
+    CreateRoutingEntry(vnode, link, dest, header, route);
+    return;
+  }
+  error = Socket::ERROR_NOROUTETOHOST;
+  NS_LOG_LOGIC("No path to " << m_destinations[dest].m_address);
+}
+
+// @apanda
+void
+Ipv4GlobalRouting::ScheduleReversals (uint8_t vnode, uint32_t dest)
+{
+  //NS_LOG_FUNCTION (this << dest);
+  DestinationState &state = m_destinations[dest];
+  const std::list<uint32_t> &inputs = state.m_vnodes[vnode].m_inputs;
+  std::list<uint32_t> &toReverse = GetToReverse(vnode, state);
+  if (toReverse.empty()) {
+    toReverse.insert(toReverse.begin(), inputs.begin(), inputs.end());
+  }
+
+  for (std::list<uint32_t>::iterator it = toReverse.begin();
+      it != toReverse.end();
+      it++) {
+    // ReverseInputToOutput(vnode, dest, *it)
+    NS_LOG_LOGIC("Scheduling reversal from input to output");
+    if (!m_reverseInputToOutputDelay.IsZero()) {
+      QueueReversal(vnode, dest, *it, true);
+    }
+    else {
+      ReverseInputToOutput(vnode, dest, *it);
+    }
+  }
+  // Scheduling reversals for one destination drops the pending reversals of
+  // every destination on this vnode, bumping the epoch does that in O(1)
+  m_toReverseEpoch[vnode]++;
+  std::list<uint32_t> &nextReverse = GetToReverse(vnode, state);
+  nextReverse.insert(nextReverse.begin(), inputs.begin(), inputs.end());
+}
+
+// @apanda
+void
+Ipv4GlobalRouting::ClearVnode(uint8_t vnode, uint32_t dest)
+{
+  DestinationState &state = m_destinations[dest];
+  VnodeState &vstate = state.m_vnodes[vnode];
+  for (std::vector<InterfaceRecord>::iterator it = state.m_interfaces.begin();
+       it != state.m_interfaces.end(); it++) {
+    it->m_direction[vnode] = Unknown;
+    it->m_localSeq[vnode] = 0;
+    it->m_remoteSeq[vnode] = 0;
+  }
+  vstate.m_inputs.clear();
+  std::fill(vstate.m_outputs.begin(), vstate.m_outputs.end(), 0);
+  vstate.m_toReverse.clear();
+  vstate.m_toReverseEpoch = m_toReverseEpoch[vnode];
+  // Reversals queued for the old incarnation of this vnode must not leak
+  // into the new one
+  CancelReversals(vnode, dest);
+}
+
+// @apanda
+uint32_t
+Ipv4GlobalRouting::PendingKey (uint8_t vnode, uint32_t dest, bool toOutput)
+{
+  return (dest << 2) | (vnode << 1) | (toOutput ? 1 : 0);
+}
+
+// @apanda
+void
+Ipv4GlobalRouting::QueueReversal (uint8_t vnode, uint32_t dest, uint32_t link, bool toOutput)
+{
+  PendingReversals &pending = m_pendingReversals[PendingKey(vnode, dest, toOutput)];
+  if (link >= pending.m_pending.size()) {
+    pending.m_pending.resize(link + 1, false);
+  }
+  if (pending.m_pending[link]) {
+    m_coalescedReversals++;
+    return;
+  }
+  m_scheduledReversals++;
+  pending.m_pending[link] = true;
+  pending.m_links.push_back(link);
+  if (!pending.m_timer.IsRunning()) {
+    pending.m_timer = Simulator::Schedule(toOutput ? m_reverseInputToOutputDelay : m_reverseOutputToInputDelay,
+                                          &Ipv4GlobalRouting::ApplyReversals, this, vnode, dest, toOutput);
+  }
+}
+
+// @apanda
+void
+Ipv4GlobalRouting::ApplyReversals (uint8_t vnode, uint32_t dest, bool toOutput)
+{
+  PendingReversalMap::iterator it = m_pendingReversals.find(PendingKey(vnode, dest, toOutput));
+  if (it == m_pendingReversals.end()) {
+    return;
+  }
+  std::vector<uint32_t> links;
+  links.swap(it->second.m_links);
+  m_pendingReversals.erase(it);
+  for (std::vector<uint32_t>::const_iterator link = links.begin(); link != links.end(); link++) {
+    if (toOutput) {
+      ReverseInputToOutput(vnode, dest, *link);
+    }
+    else {
+      ReverseOutputToInput(vnode, dest, *link);
+    }
+  }
+}
+
+// @apanda
+void
+Ipv4GlobalRouting::CancelReversals (uint8_t vnode, uint32_t dest)
+{
+  for (int toOutput = 0; toOutput < 2; toOutput++) {
+    PendingReversalMap::iterator it = m_pendingReversals.find(PendingKey(vnode, dest, toOutput));
+    if (it != m_pendingReversals.end()) {
+      it->second.m_timer.Cancel();
+      m_pendingReversals.erase(it);
+    }
+  }
+}
+
+// @apanda
+bool
+Ipv4GlobalRouting::SimpleLock (Ipv4Address addr, uint32_t link)
+{
+  DestinationState &state = m_destinations[GetDestinationIndex(addr)];
+  if (!state.m_held) {
+    NS_ASSERT_MSG(!state.m_interfaces[link].m_lock, "Should not reaquire a lock");
+    state.m_interfaces[link].m_lock = true;
+    state.m_lockCount += 1;
+    return true;
+  }
+  return false;
+}
+
+// @apanda
+void
+Ipv4GlobalRouting::SimpleUnlock (Ipv4Address addr, uint32_t link)
+{
+  DestinationState &state = m_destinations[GetDestinationIndex(addr)];
+  NS_ASSERT_MSG(!state.m_held, "If someone else thinks they have it, I better not hold it");
+  NS_ASSERT_MSG(state.m_interfaces[link].m_lock, "Don't free something you don't hold");
+  state.m_interfaces[link].m_lock = false;
+  state.m_lockCount -= 1;
+  if (state.m_aeoRequested && state.m_lockCount == 0) {
+    PrimitiveAEO(addr);
+  }
+}
+
+// @apanda
+bool
+Ipv4GlobalRouting::Lock (Ipv4Address addr, Ptr<NetDevice> link)
+{
+  return SimpleLock(addr, m_ipv4->GetInterfaceForDevice(link));
+}
+
+// @apanda
+void
 Ipv4GlobalRouting::Unlock (Ipv4Address addr, Ptr<NetDevice> link)
 {
   return SimpleUnlock(addr, m_ipv4->GetInterfaceForDevice(link));
 }
 
+// @apanda
+void
+Ipv4GlobalRouting::UnlockBatch (const std::vector<Ipv4Address> &addrs, Ptr<NetDevice> link)
+{
+  uint32_t iface = m_ipv4->GetInterfaceForDevice(link);
+  m_collectAEO = (m_controlPlane == CONTROL_DIRECT);
+  for (std::vector<Ipv4Address>::const_iterator it = addrs.begin(); it != addrs.end(); it++) {
+    SimpleUnlock(*it, iface);
+  }
+  RunCollectedAEO();
+}
+
 //@apanda
 void
 Ipv4GlobalRouting::UpdateHeartbeat (uint32_t seq, Ipv4Address addr)
 {
-  m_heartbeatSequence[addr] = seq;
+  DestinationState &state = m_destinations[GetDestinationIndex(addr)];
+  state.m_heartbeatSequence = seq;
   for (uint32_t i = 0; i < m_ipv4->GetNInterfaces(); i++) {
-    m_heartbeatState[addr][i] = false; 
+    state.m_interfaces[i].m_heartbeat = false;
   }
 }
 
@@ -940,7 +1765,8 @@ void
 Ipv4GlobalRouting::CheckAndAEO (Ipv4Address addr, uint32_t iface)
 {
   //NS_LOG_FUNCTION (this << addr << iface);
-  if (m_heartbeatState[addr][0]) {
+  DestinationState &state = m_destinations[GetDestinationIndex(addr)];
+  if (state.m_interfaces[0].m_heartbeat) {
     NS_LOG_LOGIC("Already AEOd for this");
     // We have already AEOed, let's just get on with our life
     return;
@@ -948,14 +1774,16 @@ Ipv4GlobalRouting::CheckAndAEO (Ipv4Address addr, uint32_t iface)
 
   bool seenPrevious = true;
   bool ifaceBefore = false;
-  for (std::vector<uint32_t>::iterator it = m_reverseBefore[addr].begin();
-       it != m_reverseBefore[addr].end(); it++) {
+  for (std::vector<uint32_t>::const_iterator it = state.m_order->m_reverseBefore.begin();
+       it != state.m_order->m_reverseBefore.end(); it++) {
     ifaceBefore |= (*it == iface);
-    seenPrevious &= (m_heartbeatState[addr][*it]);
+    // With real messages nothing arrives over a failed link, don't wait for it
+    seenPrevious &= (state.m_interfaces[*it].m_heartbeat ||
+                     (m_controlPlane == CONTROL_MESSAGES && !m_ipv4->GetNetDevice(*it)->IsLinkUp()));
   }
  NS_ASSERT_MSG(seenPrevious || ifaceBefore, "Cannot have someone later than us in the order hearbeating before us");
  if (seenPrevious) {
-   m_heartbeatState[addr][0] = true;
+   state.m_interfaces[0].m_heartbeat = true;
    //NS_LOG_LOGIC("Actually reversing");
    PrimitiveAEO(addr);
  }
@@ -966,16 +1794,47 @@ Ipv4GlobalRouting::CheckAndAEO (Ipv4Address addr, uint32_t iface)
 void
 Ipv4GlobalRouting::ReceiveHeartbeat (uint32_t seq, Ipv4Address addr, Ptr<NetDevice> link)
 {
-  Ptr<Channel> channel = link->GetChannel();
-  Ptr<NetDevice> other = (channel->GetDevice(0) == link ? channel->GetDevice(1) : channel->GetDevice(0));
-  NS_ASSERT(other != link);
-  Ptr<Node> otherNode = other->GetNode();
-  //NS_LOG_LOGIC("Receiving a heartbeat at " <<  m_ipv4->GetNetDevice(0)->GetNode()->GetId() << " from " << otherNode->GetId() << " for " << addr);
-  //NS_LOG_FUNCTION (this << seq << addr << link);
-  if (seq != m_heartbeatSequence[addr]) {
+  HandleHeartbeat(seq, addr, m_ipv4->GetInterfaceForDevice(link));
+}
+
+// @apanda
+void
+Ipv4GlobalRouting::ReceiveHeartbeatBatch (const std::vector<uint32_t> &seqs, const std::vector<Ipv4Address> &addrs, Ptr<NetDevice> link)
+{
+  NS_ASSERT(seqs.size() == addrs.size());
+  uint32_t iface = m_ipv4->GetInterfaceForDevice(link);
+  m_collectAEO = (m_controlPlane == CONTROL_DIRECT);
+  for (uint32_t i = 0; i < addrs.size(); i++) {
+    HandleHeartbeat(seqs[i], addrs[i], iface);
+  }
+  RunCollectedAEO();
+}
+
+// @apanda
+void
+Ipv4GlobalRouting::RunCollectedAEO (void)
+{
+  m_collectAEO = false;
+  if (!m_collectedAEO.empty()) {
+    std::vector<Ipv4Address> addrs;
+    addrs.swap(m_collectedAEO);
+    PrimitiveAEO(addrs);
+  }
+}
+
+// @apanda
+void
+Ipv4GlobalRouting::HandleHeartbeat (uint32_t seq, Ipv4Address addr, uint32_t iface)
+{
+  //NS_LOG_FUNCTION (this << seq << addr << iface);
+  uint32_t dest = GetDestinationIndex(addr);
+  if (seq != m_destinations[dest].m_heartbeatSequence) {
     //NS_LOG_LOGIC("New heartbeat, maybe?");
-    if (seq > m_heartbeatSequence[addr]) {
+    if (seq > m_destinations[dest].m_heartbeatSequence) {
       UpdateHeartbeat(seq, addr);
+      if (m_controlPlane == CONTROL_MESSAGES) {
+        AnnounceRound(dest, iface);
+      }
     }
     else {
       // Spurious
@@ -983,16 +1842,52 @@ Ipv4GlobalRouting::ReceiveHeartbeat (uint32_t seq, Ipv4Address addr, Ptr<NetDevi
       return;
     }
   }
-  m_heartbeatState[addr][m_ipv4->GetInterfaceForDevice(link)] = true;
-  CheckAndAEO(addr, m_ipv4->GetInterfaceForDevice(link));
+  m_destinations[dest].m_interfaces[iface].m_heartbeat = true;
+  CheckAndAEO(addr, iface);
 }
 
 // @apanda
-bool 
+void
+Ipv4GlobalRouting::HandleRound (uint32_t seq, Ipv4Address addr, uint32_t iface)
+{
+  uint32_t dest = GetDestinationIndex(addr);
+  DestinationState &state = m_destinations[dest];
+  if (seq <= state.m_heartbeatSequence) {
+    return;
+  }
+  UpdateHeartbeat(seq, addr);
+  AnnounceRound(dest, iface);
+  // If every link to a node before us in the order has failed no heartbeat
+  // will ever come, go ahead now
+  bool reachable = false;
+  for (std::vector<uint32_t>::const_iterator it = state.m_order->m_reverseBefore.begin();
+       it != state.m_order->m_reverseBefore.end(); it++) {
+    reachable |= m_ipv4->GetNetDevice(*it)->IsLinkUp();
+  }
+  if (!reachable && !state.m_order->m_reverseBefore.empty()) {
+    CheckAndAEO(state.m_address, state.m_order->m_reverseBefore.front());
+  }
+}
+
+// @apanda
+void
+Ipv4GlobalRouting::AnnounceRound (uint32_t dest, uint32_t except)
+{
+  DestinationState &state = m_destinations[dest];
+  for (uint32_t i = 1; i < m_ipv4->GetNInterfaces(); i++) {
+    if (i != except && m_ipv4->GetNetDevice(i)->IsLinkUp()) {
+      SendControl(i, DdcControlHeader::ROUND, state.m_address, state.m_heartbeatSequence);
+    }
+  }
+}
+
+// @apanda
+bool
 Ipv4GlobalRouting::LocalLock (Ipv4Address addr)
 {
-  NS_ASSERT_MSG(!m_held[addr], "No recursive locks");
-  if (m_lockCounts[addr] == 0) {
+  uint32_t dest = GetDestinationIndex(addr);
+  NS_ASSERT_MSG(!m_destinations[dest].m_held, "No recursive locks");
+  if (m_destinations[dest].m_lockCount == 0) {
     // The locking loop, we need to do this by sending data eventually
     for (uint32_t i = 1; i < m_ipv4->GetNInterfaces(); i++) {
       Ptr<NetDevice> device = m_ipv4->GetNetDevice(i);
@@ -1015,7 +1910,7 @@ Ipv4GlobalRouting::LocalLock (Ipv4Address addr)
         return false;
       }
     }
-    m_held[addr] = true;
+    m_destinations[dest].m_held = true;
     return true;
   }
   return false;
@@ -1025,7 +1920,22 @@ Ipv4GlobalRouting::LocalLock (Ipv4Address addr)
 void
 Ipv4GlobalRouting::LocalUnlock (Ipv4Address addr)
 {
-  NS_ASSERT_MSG(m_held[addr], "Don't release unheld locks");
+  uint32_t dest = GetDestinationIndex(addr);
+  NS_ASSERT_MSG(m_destinations[dest].m_held, "Don't release unheld locks");
+  if (m_controlPlane == CONTROL_MESSAGES) {
+    DestinationState &state = m_destinations[dest];
+    for (uint32_t i = 1; i < m_ipv4->GetNInterfaces(); i++) {
+      if (state.m_interfaces[i].m_remoteLock == REMOTE_GRANTED) {
+        state.m_interfaces[i].m_remoteLock = REMOTE_UNLOCKED;
+        SendControl(i, DdcControlHeader::UNLOCK, state.m_address, 0);
+      }
+    }
+    state.m_held = false;
+    for (std::vector<uint32_t>::const_iterator it = state.m_order->m_reverseAfter.begin(); it != state.m_order->m_reverseAfter.end(); it++) {
+      SendControl(*it, DdcControlHeader::HEARTBEAT, state.m_address, state.m_heartbeatSequence);
+    }
+    return;
+  }
   for (uint32_t i = 1; i < m_ipv4->GetNInterfaces(); i++) {
     Ptr<NetDevice> device = m_ipv4->GetNetDevice(i);
     Ptr<Channel> channel = device->GetChannel();
@@ -1035,8 +1945,9 @@ Ipv4GlobalRouting::LocalUnlock (Ipv4Address addr)
     Ptr<Ipv4GlobalRouting> rtr = otherNode->GetObject<GlobalRouter>()->GetRoutingProtocol();
     Simulator::ScheduleNow(&Ipv4GlobalRouting::Unlock, rtr, addr, other); //rtr->Unlock(addr, other);
   }
-  m_held[addr] = false;
-  for (std::vector<uint32_t>::iterator it = m_reverseAfter[addr].begin(); it != m_reverseAfter[addr].end(); it++) {
+  m_destinations[dest].m_held = false;
+  const std::vector<uint32_t> &reverseAfter = m_destinations[dest].m_order->m_reverseAfter;
+  for (std::vector<uint32_t>::const_iterator it = reverseAfter.begin(); it != reverseAfter.end(); it++) {
     Ptr<NetDevice> device = m_ipv4->GetNetDevice(*it);
     Ptr<Channel> channel = device->GetChannel();
     Ptr<NetDevice> other = (channel->GetDevice(0) == device ? channel->GetDevice(1) : channel->GetDevice(0));
@@ -1044,35 +1955,47 @@ Ipv4GlobalRouting::LocalUnlock (Ipv4Address addr)
     Ptr<Node> otherNode = other->GetNode();
     Ptr<Ipv4GlobalRouting> rtr = otherNode->GetObject<GlobalRouter>()->GetRoutingProtocol();
     //NS_LOG_LOGIC("Sending heartbeat for " << addr << " to " << otherNode->GetId() << " from " <<  m_ipv4->GetNetDevice(0)->GetNode()->GetId());
-    Simulator::ScheduleNow(&Ipv4GlobalRouting::ReceiveHeartbeat, rtr, m_heartbeatSequence[addr], addr, other); //rtr->ReceiveHeartbeat(addr, other);
+    Simulator::ScheduleNow(&Ipv4GlobalRouting::ReceiveHeartbeat, rtr, m_destinations[dest].m_heartbeatSequence, addr, other); //rtr->ReceiveHeartbeat(addr, other);
   }
 }
 
 // @apanda
-void 
+void
 Ipv4GlobalRouting::SetRemoteVnode (Ipv4Address addr, uint32_t interface, uint8_t vnode)
 {
-  NS_ASSERT_MSG(m_locks[addr][interface], "Don't set remote vnode without holding lock");
-  m_remoteVnode[addr][interface] = vnode;
-  if (m_vnodeState[m_localVnode[addr]].m_directions[addr][interface] != In) {
-    m_vnodeState[m_localVnode[addr]].m_inputs[addr].push_front(interface);
+  DestinationState &state = m_destinations[GetDestinationIndex(addr)];
+  InterfaceRecord &iface = state.m_interfaces[interface];
+  NS_ASSERT_MSG(iface.m_lock, "Don't set remote vnode without holding lock");
+  iface.m_remoteVnode = vnode;
+  uint8_t localVnode = state.m_localVnode;
+  if (iface.m_direction[localVnode] != In) {
+    state.m_vnodes[localVnode].m_inputs.push_front(interface);
   }
-  m_vnodeState[m_localVnode[addr]].m_directions[addr][interface] = In;
-  m_vnodeState[m_localVnode[addr]].m_localSeq[addr][interface] = 0;
-  m_vnodeState[m_localVnode[addr]].m_remoteSeq[addr][interface] = 0;
+  SetDirection(state, localVnode, interface, In);
+  iface.m_localSeq[localVnode] = 0;
+  iface.m_remoteSeq[localVnode] = 0;
 }
 
 // @apanda
-void 
+void
 Ipv4GlobalRouting::SetRemoteVnode (Ipv4Address addr, Ptr<NetDevice> interface, uint8_t vnode)
 {
   SetRemoteVnode(addr, m_ipv4->GetInterfaceForDevice(interface), vnode);
 }
 
 // @apanda
-void 
+void
 Ipv4GlobalRouting::LocalSetRemoteVnode (Ipv4Address addr, uint32_t link, uint8_t vnode)
 {
+  if (m_controlPlane == CONTROL_MESSAGES) {
+    // Only neighbours whose lock we hold hear about it, the rest were
+    // unreachable when the locks were collected
+    DestinationState &state = m_destinations[GetDestinationIndex(addr)];
+    if (state.m_interfaces[link].m_remoteLock == REMOTE_GRANTED) {
+      SendControl(link, DdcControlHeader::SET_VNODE, state.m_address, vnode);
+    }
+    return;
+  }
   Ptr<NetDevice> device = m_ipv4->GetNetDevice(link);
   Ptr<Channel> channel = device->GetChannel();
   Ptr<NetDevice> other = (channel->GetDevice(0) == device ? channel->GetDevice(1) : channel->GetDevice(0));
@@ -1083,33 +2006,272 @@ Ipv4GlobalRouting::LocalSetRemoteVnode (Ipv4Address addr, uint32_t link, uint8_t
 }
 
 // @apanda
-void 
-Ipv4GlobalRouting::SetReversalOrder (Ipv4Address addr, const std::list<uint32_t>& interfaces) 
+void
+Ipv4GlobalRouting::RequestLocks (uint32_t dest)
+{
+  DestinationState &state = m_destinations[dest];
+  if (state.m_held || state.m_lockWaiting > 0 || state.m_lockCount > 0) {
+    return;
+  }
+  for (uint32_t i = 1; i < m_ipv4->GetNInterfaces(); i++) {
+    if (!m_ipv4->GetNetDevice(i)->IsLinkUp() || GetInterfaceRoute(i) == 0) {
+      continue;
+    }
+    state.m_interfaces[i].m_remoteLock = REMOTE_REQUESTED;
+    state.m_lockWaiting++;
+    SendControl(i, DdcControlHeader::LOCK, state.m_address, 0);
+  }
+  if (state.m_lockWaiting == 0) {
+    FinishLock(dest);
+  }
+}
+
+// @apanda
+void
+Ipv4GlobalRouting::ReceiveLockRequest (uint32_t dest, uint32_t iface)
+{
+  DestinationState &state = m_destinations[dest];
+  if (state.m_interfaces[iface].m_lock) {
+    // The neighbour already holds our lock, so its UNLOCK was lost (e.g. to
+    // a full device queue). It is asking again, so it still has it.
+    SendControl(iface, DdcControlHeader::LOCK_GRANTED, state.m_address, 0);
+    return;
+  }
+  bool grant = !state.m_held;
+  if (grant && state.m_lockWaiting > 0) {
+    // Both ends of the link are collecting locks, the lower address wins.
+    // Granting means we now can't hold all of our neighbours at once.
+    // Without a route there is no neighbour address to compare, and no way
+    // to answer either, so keep our own lock.
+    Ptr<Ipv4Route> route = GetInterfaceRoute(iface);
+    grant = route != 0 && route->GetGateway() < route->GetSource();
+    state.m_lockFailed |= grant;
+  }
+  if (grant) {
+    SimpleLock(state.m_address, iface);
+  }
+  SendControl(iface, grant ? DdcControlHeader::LOCK_GRANTED : DdcControlHeader::LOCK_DENIED, state.m_address, 0);
+}
+
+// @apanda
+void
+Ipv4GlobalRouting::ReceiveLockReply (uint32_t dest, uint32_t iface, bool granted)
+{
+  DestinationState &state = m_destinations[dest];
+  InterfaceRecord &record = state.m_interfaces[iface];
+  if (record.m_remoteLock != REMOTE_REQUESTED) {
+    // Given up on when the link failed
+    return;
+  }
+  record.m_remoteLock = (granted ? REMOTE_GRANTED : REMOTE_UNLOCKED);
+  state.m_lockFailed |= !granted;
+  state.m_lockWaiting--;
+  if (state.m_lockWaiting == 0) {
+    FinishLock(dest);
+  }
+}
+
+// @apanda
+void
+Ipv4GlobalRouting::FinishLock (uint32_t dest)
+{
+  DestinationState &state = m_destinations[dest];
+  if (state.m_lockFailed) {
+    state.m_lockFailed = false;
+    for (uint32_t i = 1; i < m_ipv4->GetNInterfaces(); i++) {
+      if (state.m_interfaces[i].m_remoteLock == REMOTE_GRANTED) {
+        state.m_interfaces[i].m_remoteLock = REMOTE_UNLOCKED;
+        SendControl(i, DdcControlHeader::UNLOCK, state.m_address, 0);
+      }
+    }
+    // Whoever beat us normally holds our lock, and releasing it retries
+    // the AEO. If nobody does, retry now.
+    if (state.m_aeoRequested && state.m_lockCount == 0) {
+      RequestLocks(dest);
+    }
+    return;
+  }
+  state.m_held = true;
+  ExecuteAEO(dest);
+}
+
+// @apanda
+void
+Ipv4GlobalRouting::SendControl (uint32_t iface, DdcControlHeader::MessageType type, Ipv4Address addr, uint32_t value)
+{
+  if (m_controlQueues.size() < m_ipv4->GetNInterfaces()) {
+    m_controlQueues.resize(m_ipv4->GetNInterfaces());
+    m_controlFlush.resize(m_ipv4->GetNInterfaces());
+  }
+  DdcControlHeader &queue = m_controlQueues[iface];
+  queue.AddMessage(type, addr, value);
+  // Control packets must not be fragmented, so a batch ends at the MTU
+  uint32_t batchSize = std::min(m_controlBatchSize, DdcControlHeader::GetMaxMessages(m_ipv4->GetMtu(iface) - 20));
+  if (queue.GetNMessages() >= batchSize) {
+    FlushControl(iface);
+  }
+  else if (!m_controlFlush[iface].IsRunning()) {
+    m_controlFlush[iface] = Simulator::Schedule(m_controlBatchDelay, &Ipv4GlobalRouting::FlushControl, this, iface);
+  }
+}
+
+// @apanda
+void
+Ipv4GlobalRouting::FlushControl (uint32_t iface)
+{
+  m_controlFlush[iface].Cancel();
+  DdcControlHeader &queue = m_controlQueues[iface];
+  Ptr<Ipv4Route> route = GetInterfaceRoute(iface);
+  if (queue.GetNMessages() == 0 || route == 0) {
+    queue.Clear();
+    return;
+  }
+  Ptr<Packet> packet = Create<Packet> ();
+  packet->AddHeader(queue);
+  queue.Clear();
+  // Control packets only ever travel one hop, so they are addressed to the
+  // neighbour directly instead of being routed
+  Ipv4Header header;
+  header.SetSource(route->GetSource());
+  header.SetDestination(route->GetGateway());
+  header.SetProtocol(DdcControlProtocol::PROT_NUMBER);
+  header.SetPayloadSize(packet->GetSize());
+  header.SetTtl(1);
+  if (Node::ChecksumEnabled()) {
+    header.EnableChecksum();
+  }
+  m_controlTxTrace(packet, iface);
+  m_ipv4->GetObject<Ipv4L3Protocol> ()->SendWithHeader(packet, header, route);
+}
+
+// @apanda
+void
+Ipv4GlobalRouting::ReceiveControl (Ptr<Packet> packet, const Ipv4Header &header, Ptr<Ipv4Interface> incomingInterface)
+{
+  uint32_t iface = m_ipv4->GetInterfaceForDevice(incomingInterface->GetDevice());
+  m_controlRxTrace(packet, iface);
+  DdcControlHeader control;
+  packet->RemoveHeader(control);
+  if (m_controlProcessingDelay.IsZero()) {
+    ProcessControl(iface, control);
+  }
+  else {
+    Simulator::Schedule(m_controlProcessingDelay, &Ipv4GlobalRouting::ProcessControl, this, iface, control);
+  }
+}
+
+// @apanda
+void
+Ipv4GlobalRouting::ProcessControl (uint32_t iface, DdcControlHeader control)
+{
+  for (uint32_t i = 0; i < control.GetNMessages(); i++) {
+    const DdcControlHeader::Message &message = control.GetMessage(i);
+    uint32_t dest = GetDestinationIndex(message.m_address);
+    bool locked = m_destinations[dest].m_interfaces[iface].m_lock;
+    switch (message.m_type) {
+      case DdcControlHeader::LOCK:
+        ReceiveLockRequest(dest, iface);
+        break;
+      case DdcControlHeader::LOCK_GRANTED:
+        ReceiveLockReply(dest, iface, true);
+        break;
+      case DdcControlHeader::LOCK_DENIED:
+        ReceiveLockReply(dest, iface, false);
+        break;
+      // Unlocks and vnode updates are dropped if the lock was already
+      // released because the link failed while they were in flight
+      case DdcControlHeader::UNLOCK:
+        if (locked) {
+          SimpleUnlock(message.m_address, iface);
+        }
+        break;
+      case DdcControlHeader::SET_VNODE:
+        if (locked) {
+          SetRemoteVnode(message.m_address, iface, message.m_value);
+        }
+        break;
+      case DdcControlHeader::HEARTBEAT:
+        HandleHeartbeat(message.m_value, message.m_address, iface);
+        break;
+      case DdcControlHeader::ROUND:
+        HandleRound(message.m_value, message.m_address, iface);
+        break;
+      default:
+        NS_LOG_WARN("Unknown DDC control message " << (uint32_t)message.m_type);
+        break;
+    }
+  }
+}
+
+// @apanda
+void
+Ipv4GlobalRouting::WatchControlLinks (void)
+{
+  for (uint32_t i = m_controlLinksWatched; i < m_ipv4->GetNInterfaces(); i++) {
+    m_ipv4->GetNetDevice(i)->AddLinkChangeCallback(MakeCallback(&Ipv4GlobalRouting::ControlLinkChange, this).Bind(i));
+  }
+  m_controlLinksWatched = std::max(m_controlLinksWatched, m_ipv4->GetNInterfaces());
+}
+
+// @apanda
+void
+Ipv4GlobalRouting::ControlLinkChange (uint32_t iface)
+{
+  if (m_ipv4->GetNetDevice(iface)->IsLinkUp()) {
+    return;
+  }
+  if (iface < m_controlQueues.size()) {
+    m_controlFlush[iface].Cancel();
+    m_controlQueues[iface].Clear();
+  }
+  // Nothing more will be heard from this neighbour: go on without its lock,
+  // drop the lock it holds on us, and stop waiting for its heartbeats
+  for (uint32_t dest = 0; dest < m_destinations.size(); dest++) {
+    DestinationState &state = m_destinations[dest];
+    InterfaceRecord &record = state.m_interfaces[iface];
+    if (record.m_remoteLock == REMOTE_REQUESTED) {
+      record.m_remoteLock = REMOTE_UNLOCKED;
+      state.m_lockWaiting--;
+      if (state.m_lockWaiting == 0) {
+        FinishLock(dest);
+      }
+    }
+    else if (record.m_remoteLock == REMOTE_GRANTED) {
+      record.m_remoteLock = REMOTE_UNLOCKED;
+    }
+    if (record.m_lock) {
+      SimpleUnlock(state.m_address, iface);
+    }
+    if (state.m_heartbeatSequence > 0 && !state.m_interfaces[0].m_heartbeat &&
+        std::find(state.m_order->m_reverseBefore.begin(), state.m_order->m_reverseBefore.end(), iface) != state.m_order->m_reverseBefore.end()) {
+      CheckAndAEO(state.m_address, iface);
+    }
+  }
+}
+
+// @apanda
+void
+Ipv4GlobalRouting::SetReversalOrder (Ipv4Address addr, const std::list<uint32_t>& interfaces)
 {
   //NS_LOG_FUNCTION(this << addr);
   //NS_LOG_LOGIC("SetReversalOrder " << addr << " node = " << m_ipv4->GetNetDevice(0)->GetNode()->GetId());
   std::list<uint32_t>::const_iterator it;
-  for (it = interfaces.begin(); 
-       it != interfaces.end(); it++) {
-    //NS_LOG_LOGIC("Vector " << *it);
-  }
-
-  for (it = interfaces.begin(); 
+  for (it = interfaces.begin();
        it != interfaces.end() && (*it) != 0; it++) {
     //NS_LOG_LOGIC("Considering " << *it);
   }
   NS_ASSERT(it !=  interfaces.end());
-  m_reverseBefore.insert(LinkOrder::value_type(addr, std::vector<uint32_t>(interfaces.begin(), it)));
+  DestinationState &state = m_destinations[GetDestinationIndex(addr)];
+  // Only the first reversal order set for an address is used
+  if (state.m_hasReversalOrder) {
+    return;
+  }
+  state.m_hasReversalOrder = true;
+  DdcPriorityOrder &own = OwnOrder(state);
+  own.m_reverseBefore.assign(interfaces.begin(), it);
   NS_ASSERT(*it == 0);
   it++;
-  //NS_LOG_LOGIC("Now at iface = " << *it);
-  if (it != interfaces.end()) {
-    //NS_LOG_LOGIC("Interface = " << *it);
-  }
-  else {
-    //NS_LOG_LOGIC("Inteface end of the line");
-  }
-  m_reverseAfter.insert(LinkOrder::value_type(addr, std::vector<uint32_t>(it, interfaces.end())));
+  own.m_reverseAfter.assign(it, interfaces.end());
 }
 
 // @apanda
@@ -1118,18 +2280,35 @@ Ipv4GlobalRouting::SendInitialHeartbeat (Ipv4Address addr)
 {
   //NS_LOG_FUNCTION(this << addr);
   //NS_LOG_LOGIC("Initial heartbeat for address = " << addr << " from node = " << m_ipv4->GetNetDevice(0)->GetNode()->GetId());
-  for (std::vector<uint32_t>::iterator it = m_reverseBefore[addr].begin();
-       it != m_reverseBefore[addr].end(); it++) {
-    //NS_LOG_LOGIC("REVERSE BEFORE NOT EMPTY: " << *it);
+  DestinationState &state = m_destinations[GetDestinationIndex(addr)];
+  NS_ASSERT(state.m_order->m_reverseBefore.empty());
+  state.m_heartbeatSequence++;
+  state.m_interfaces[0].m_heartbeat = true;
+  if (m_controlPlane == CONTROL_MESSAGES) {
+    AnnounceRound(GetDestinationIndex(addr), 0);
   }
-  NS_ASSERT(m_reverseBefore[addr].empty());
-  m_heartbeatSequence[addr]++;
-  m_heartbeatState[addr][0] = true;
   PrimitiveAEO(addr);
 }
 
 // @apanda
-void 
+void
+Ipv4GlobalRouting::SendInitialHeartbeats (const std::vector<Ipv4Address> &addrs)
+{
+  for (std::vector<Ipv4Address>::const_iterator it = addrs.begin(); it != addrs.end(); it++) {
+    uint32_t dest = GetDestinationIndex(*it);
+    DestinationState &state = m_destinations[dest];
+    NS_ASSERT(state.m_order->m_reverseBefore.empty());
+    state.m_heartbeatSequence++;
+    state.m_interfaces[0].m_heartbeat = true;
+    if (m_controlPlane == CONTROL_MESSAGES) {
+      AnnounceRound(dest, 0);
+    }
+  }
+  PrimitiveAEO(addrs);
+}
+
+// @apanda
+void
 Ipv4GlobalRouting::AddReversalCallback (Callback<void, uint32_t, Ipv4Address> callback)
 {
   m_reversalCallback.ConnectWithoutContext(callback);
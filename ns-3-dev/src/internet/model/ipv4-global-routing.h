@@ -21,6 +21,7 @@
 #define IPV4_GLOBAL_ROUTING_H
 
 #include <list>
+#include <deque>
 #include <map>
 #include <vector>
 #include <utility>
@@ -38,6 +39,11 @@
 #include "ns3/node.h"
 #include "ns3/global-router-interface.h"
 #include "ns3/traced-callback.h"
+#include "ns3/traced-value.h"
+#include "ns3/event-id.h"
+#include "ns3/sgi-hashmap.h"
+#include "ns3/ddc-distance-table.h"
+#include "ns3/ddc-control-protocol.h"
 
 namespace ns3 {
 
@@ -226,6 +232,16 @@ public:
  */
   bool PrimitiveAEO(Ipv4Address dest);
 
+/**
+ * @apanda
+ * Primitive AEO for a set of destinations. The neighbours are looked up
+ * once, and each neighbour gets one unlock and at most one heartbeat event
+ * for the whole set instead of one per destination.
+ * \returns the number of destinations reversed at once, the others are
+ * reversed when the locks they wait on are released
+ */
+  uint32_t PrimitiveAEO (const std::vector<Ipv4Address> &dests);
+
 /**
  * @apanda
  * Set link priority, higher is better
@@ -238,12 +254,115 @@ public:
  */
   void SetReversalOrder (Ipv4Address, const std::list<uint32_t>&);
 
+/**
+ * @apanda
+ * Install the shared distance table. Link priorities and the reversal
+ * order for a destination are derived from it when the destination's DDC
+ * state is first created. neighbours[i] is the node at the other end of
+ * interface i, or DdcDistanceTable::NO_NODE.
+ */
+  void SetDistanceTable (Ptr<DdcDistanceTable> table, uint32_t nodeId, const std::vector<uint32_t> &neighbours);
+
+/**
+ * @apanda
+ * Distances in the table changed, re-derive link priorities for every
+ * destination with DDC state
+ */
+  void RefreshDistances (void);
+
+/**
+ * @apanda
+ * Same, but only for the addresses of node (e.g. after its reversal orders
+ * moved)
+ */
+  void RefreshDestination (uint32_t node);
+
+/**
+ * @apanda
+ * How this node's control plane reacts to a link change: the time it takes
+ * to pass a link state update on, the delay before and minimum gap between
+ * the SPF runs it triggers, and whether DDC state for its addresses is
+ * reset once the SPF has run
+ */
+  void GetConvergenceModel (Time &lsaHopDelay, Time &spfDelay, Time &spfHoldTime, bool &reset) const;
+
+/**
+ * @apanda
+ * Remember all DDC state (link directions, sequence numbers, vnodes,
+ * priorities, locks and heartbeats) to go back to with RestoreDdcState.
+ * Call it while nothing is scheduled that changes DDC state, e.g. between
+ * two runs.
+ */
+  void SaveDdcState (void);
+
+/**
+ * @apanda
+ * Go back to what SaveDdcState saw. Pending reversals, queued control
+ * messages and collected AEOs are dropped.
+ */
+  void RestoreDdcState (void);
+
+/**
+ * @apanda
+ * How DDC state is keyed: one state per destination address, or one per
+ * destination node shared by all of its addresses
+ */
+  enum StateKey {
+    KEY_ADDRESS,
+    KEY_NODE
+  };
+
+/**
+ * @apanda
+ * How lock, unlock, vnode and heartbeat updates reach neighbours: by calling
+ * into the neighbour's routing object at once, or as DdcControlProtocol
+ * packets sent over the link
+ */
+  enum ControlPlane {
+    CONTROL_DIRECT,
+    CONTROL_MESSAGES
+  };
+
+/**
+ * @apanda
+ * The address DDC state for addr is kept under. With per node keying this
+ * is the canonical address of addr's node, once the distance table is
+ * known; otherwise addr itself.
+ */
+  Ipv4Address GetDestinationKey (Ipv4Address addr) const;
+
+/**
+ * @apanda
+ * The link priorities and reversal order used towards dest, 0 when there
+ * is no DDC state for it yet
+ */
+  const DdcPriorityOrder* GetPriorityOrder (Ipv4Address dest) const;
+
+/**
+ * @apanda
+ * Number of destinations for which DDC state has been created
+ */
+  uint32_t GetNDestinations (void) const;
+
+/**
+ * @apanda
+ * Approximate number of bytes of DDC state held by this node, not counting
+ * the shared distance table
+ */
+  uint64_t GetMemoryUsage (void) const;
+
 /**
  * @apanda
  * Send a heartbeat
  */
   void SendInitialHeartbeat (Ipv4Address);
 
+/**
+ * @apanda
+ * Send heartbeats for several addresses, with one batched AEO
+ */
+  void SendInitialHeartbeats (const std::vector<Ipv4Address> &addrs);
+
 /**
  * @apanda
  * Set reversal callback
@@ -254,58 +373,76 @@ protected:
 
 /**
  * @apanda
- * Find highest priority output port to send messages out of
+ * Find highest priority output port to send messages out of. With flow
+ * hashing, flowHash picks among the live Out links that share the best
+ * priority.
  */
- bool FindOutputPort (uint8_t, Ipv4Address addr, uint32_t &link, uint32_t iif);  
+ bool FindOutputPort (uint8_t, uint32_t dest, uint32_t &link, uint32_t iif, uint32_t flowHash);  
+
+/**
+ * @apanda
+ * Hash of the packet's addresses, protocol and, for TCP and UDP, ports.
+ * Packets of one flow always hash the same, so they keep their order.
+ */
+ uint32_t GetFlowHash (Ptr<const Packet> p, const Ipv4Header &header) const;
 
 /**
  * @apanda
  * Find highest priority live link
  */
- bool FindHighPriorityLink (uint8_t, Ipv4Address address, uint32_t &link);
+ bool FindHighPriorityLink (uint8_t, uint32_t dest, uint32_t &link);
+
+/**
+ * @apanda
+ * Inititalize a bunch of data structures for a specific address, returns
+ * the index of the destination in the forwarding table
+ */
+ uint32_t InitializeDestination (Ipv4Address addr);
 
 /**
  * @apanda
- * Inititalize a bunch of data structures for a specific address
+ * Look up the forwarding table index for an address, initializing the
+ * destination if we have not seen it before
  */
- void InitializeDestination (Ipv4Address addr);
+ uint32_t GetDestinationIndex (Ipv4Address addr);
 
 /**
  * @apanda
  * Reverse input to output
  */
-  void ReverseInputToOutput (uint8_t, Ipv4Address addr, uint32_t link); 
+  void ReverseInputToOutput (uint8_t, uint32_t dest, uint32_t link); 
 
 /**
  * @apanda
  * Reverse output to input
  */
-  void ReverseOutputToInput (uint8_t, Ipv4Address addr, uint32_t link); 
+  void ReverseOutputToInput (uint8_t, uint32_t dest, uint32_t link); 
 
 /**
  * @apanda
  * Send on outlink
  */
-  void SendOnOutlink (uint8_t, Ipv4Address addr, Ipv4Header& header, uint32_t link);
+  void SendOnOutlink (uint8_t, uint32_t dest, Ipv4Header& header, uint32_t link);
 
 /**
  * @apanda
  * Standard receive
  */
-  void StandardReceive (Ipv4Address addr, Ipv4Header& header,
-                       Ptr<Ipv4Route>& route, Socket::SocketErrno& error, uint32_t iif);
+  void StandardReceive (uint32_t dest, Ipv4Header& header,
+                       Ptr<Ipv4Route>& route, Socket::SocketErrno& error, uint32_t iif,
+                       uint32_t flowHash);
 
 /**
  * @apanda
  * Create a generic routing entry, and prepare the header
  */
-  void CreateRoutingEntry (uint8_t, uint32_t link, Ipv4Address addr, Ipv4Header& header, Ptr<Ipv4Route> &route);
+  void CreateRoutingEntry (uint8_t, uint32_t link, uint32_t dest, Ipv4Header& header, Ptr<Ipv4Route> &route);
 
 /**
  * @apanda
  * Schedule reversals
  */
-  void ScheduleReversals(uint8_t, Ipv4Address addr);
+  void ScheduleReversals(uint8_t, uint32_t dest);
 
 /**
  * @apanda
@@ -337,6 +474,25 @@ protected:
  */
   void ReceiveHeartbeat (uint32_t, Ipv4Address, Ptr<NetDevice>);
 
+/**
+ * @apanda
+ * Release the locks a neighbour held on several destinations
+ */
+  void UnlockBatch (const std::vector<Ipv4Address> &addrs, Ptr<NetDevice> link);
+
+/**
+ * @apanda
+ * Receive heartbeats for several destinations, seqs[i] is the sequence
+ * number for addrs[i]
+ */
+  void ReceiveHeartbeatBatch (const std::vector<uint32_t> &seqs, const std::vector<Ipv4Address> &addrs, Ptr<NetDevice> link);
+
+/**
+ * @apanda
+ * Stop collecting AEOs and run the ones collected as one batch
+ */
+  void RunCollectedAEO (void);
+
 /**
  * @apanda
  * Update remote vnode
@@ -380,7 +536,7 @@ private:
 /**
  * @apanda
  */
-  void ClearVnode(uint8_t vnode, Ipv4Address addr);
+  void ClearVnode(uint8_t vnode, uint32_t dest);
 
 /**
  * @apanda
@@ -388,6 +544,111 @@ private:
  */
   void UpdateHeartbeat(uint32_t, Ipv4Address);
 
+/**
+ * @apanda
+ * Handle a heartbeat for addr that arrived on iface
+ */
+  void HandleHeartbeat (uint32_t seq, Ipv4Address addr, uint32_t iface);
+
+/**
+ * @apanda
+ * Message control plane: a neighbour learnt that heartbeat round seq for
+ * addr has started. Rounds are flooded so that nodes cut off from everything
+ * before them in the reversal order still take part.
+ */
+  void HandleRound (uint32_t seq, Ipv4Address addr, uint32_t iface);
+
+/**
+ * @apanda
+ * Message control plane: tell every neighbour except the one on except about
+ * the current heartbeat round for dest
+ */
+  void AnnounceRound (uint32_t dest, uint32_t except);
+
+/**
+ * @apanda
+ * Run the part of PrimitiveAEO that needs the neighbours' locks, once they
+ * are held, and release them. Without notify the lock is dropped locally
+ * and the caller tells the neighbours.
+ */
+  void ExecuteAEO (uint32_t dest, bool notify = true);
+
+/**
+ * @apanda
+ * Message control plane: ask every neighbour reachable over a live link for
+ * its lock on dest. Does nothing if an attempt is already running or a
+ * neighbour holds our lock, the attempt is retried once that lock is
+ * released.
+ */
+  void RequestLocks (uint32_t dest);
+
+/**
+ * @apanda
+ * Message control plane: a neighbour asks for our lock on dest. When both
+ * ends of a link are collecting locks at once, the end with the lower
+ * address gets the lock.
+ */
+  void ReceiveLockRequest (uint32_t dest, uint32_t iface);
+
+/**
+ * @apanda
+ * Message control plane: a neighbour answered our lock request for dest
+ */
+  void ReceiveLockReply (uint32_t dest, uint32_t iface, bool granted);
+
+/**
+ * @apanda
+ * Message control plane: every lock request for dest has been answered, run
+ * the AEO or give back the locks we got
+ */
+  void FinishLock (uint32_t dest);
+
+/**
+ * @apanda
+ * Queue a control message to the neighbour on iface. Messages are sent in
+ * the order they are queued, up to ControlBatchSize per packet and no more
+ * than fit in the MTU of iface.
+ */
+  void SendControl (uint32_t iface, DdcControlHeader::MessageType type, Ipv4Address addr, uint32_t value);
+
+/**
+ * @apanda
+ * Send everything queued for iface
+ */
+  void FlushControl (uint32_t iface);
+
+/**
+ * @apanda
+ * Receive callback of the DdcControlProtocol
+ */
+  void ReceiveControl (Ptr<Packet> packet, const Ipv4Header &header, Ptr<Ipv4Interface> incomingInterface);
+
+/**
+ * @apanda
+ * Act on the messages of a control packet that arrived on iface
+ */
+  void ProcessControl (uint32_t iface, DdcControlHeader control);
+
+/**
+ * @apanda
+ * Watch for failures of links added since the last call, so that lock
+ * requests, held locks and heartbeats that can no longer arrive over them
+ * are given up
+ */
+  void WatchControlLinks (void);
+
+/**
+ * @apanda
+ * Link change callback for iface
+ */
+  void ControlLinkChange (uint32_t iface);
+
+/**
+ * @apanda
+ * Link change callback for iface, with RecomputeOnLinkChange set
+ */
+  void RoutingLinkChange (uint32_t iface);
+
   /// @apanda Link direction for DDC
   enum LinkDirection {
     In = 1,
@@ -412,52 +673,220 @@ private:
   typedef std::list<Ipv4RoutingTableEntry *>::iterator ASExternalRoutesI;
 
   // @apanda Types
-  typedef std::map<Ipv4Address, std::vector<LinkDirection> > InterfaceDirection;
-  typedef std::map<Ipv4Address, std::vector<uint32_t> > InterfacePriorities;
   typedef std::pair<uint32_t, uint32_t> PriorityInterface;
-  typedef std::priority_queue<PriorityInterface, std::vector<PriorityInterface>, 
-            std::greater< std::vector<PriorityInterface>::value_type> > InterfaceQueue;
-  typedef std::map<Ipv4Address, InterfaceQueue> DestinationPriorityInterfaceQueues;
-  typedef std::map<Ipv4Address, std::list<uint32_t> > DestinationListInterfaceQueues;
-  typedef std::map<Ipv4Address, std::vector<uint32_t> > InterfaceReversalTTL;
-  typedef std::map<Ipv4Address, std::vector<uint8_t> > SequenceNumbers;
-  typedef std::map<Ipv4Address, uint8_t> VnodeNumbers;
-  typedef std::map<Ipv4Address, std::vector<uint8_t> > RemoteVnodeNumbers;
-  typedef std::map<Ipv4Address, std::vector<bool> > LockStatus;
-  typedef std::map<Ipv4Address, bool> LockHeld;
-  typedef std::map<Ipv4Address, uint32_t> LockCounts; 
-  typedef std::map<Ipv4Address, bool> AeoRequests;
-  typedef std::map<Ipv4Address, std::vector<uint32_t> > LinkOrder;
-  typedef std::map<Ipv4Address, std::vector<bool> > HeartbeatState;
-  typedef std::map<Ipv4Address, uint32_t> CurrentSequence;
-
-  LockStatus m_locks;
-  LockCounts m_lockCounts;
-  LockHeld m_held;
-  VnodeNumbers m_localVnode;
-  RemoteVnodeNumbers m_remoteVnode;
-  InterfaceReversalTTL m_ttl;
-  InterfacePriorities m_priorities;
-  AeoRequests m_aeoRequested;
-  LinkOrder m_reverseBefore;
-  LinkOrder m_reverseAfter;
-  CurrentSequence m_heartbeatSequence;
-  HeartbeatState m_heartbeatState;
-  bool m_allowReversal;
-  struct ForwardingState {
-    /// @apanda Direction vectors
-    InterfaceDirection m_directions;
-    /// @apanda Book keeping for the various interfaces
-    DestinationListInterfaceQueues m_inputs;
-    DestinationListInterfaceQueues m_to_reverse;
-    DestinationPriorityInterfaceQueues m_outputs;
-    SequenceNumbers m_localSeq;
-    SequenceNumbers m_remoteSeq;
-    DestinationPriorityInterfaceQueues m_prioritized_links;
-    /// end @apanda
+
+  /// @apanda Per interface DDC state for a destination, for both vnodes
+  struct InterfaceRecord {
+    uint32_t m_ttl;
+    uint8_t m_direction[2];
+    uint8_t m_localSeq[2];
+    uint8_t m_remoteSeq[2];
+    uint8_t m_remoteVnode;
+    bool m_lock;
+    bool m_heartbeat;
+    /// Message control plane: state of our request for the neighbour's lock
+    uint8_t m_remoteLock;
   };
 
-  ForwardingState m_vnodeState[2];
+  /// @apanda Progress of a request for a neighbour's lock
+  enum RemoteLock {
+    REMOTE_UNLOCKED,
+    REMOTE_REQUESTED,
+    REMOTE_GRANTED
+  };
+
+  /// @apanda Delayed reversals of one kind waiting for a shared timer
+  struct PendingReversals {
+    /// Links in the order their reversal was first requested
+    std::vector<uint32_t> m_links;
+    /// Whether each link, by interface index, is in m_links
+    std::vector<bool> m_pending;
+    EventId m_timer;
+  };
+
+  /// @apanda Book keeping for one vnode of a destination
+  struct VnodeState {
+    std::list<uint32_t> m_inputs;
+    std::list<uint32_t> m_toReverse;
+    /// m_toReverse is only valid if this matches m_toReverseEpoch for the vnode
+    uint32_t m_toReverseEpoch;
+    /// Bitmask of Out interfaces, bit i is the interface with rank i
+    std::vector<uint64_t> m_outputs;
+  };
+
+  /// @apanda All DDC state for one destination address
+  struct DestinationState {
+    Ipv4Address m_address;
+    std::vector<InterfaceRecord> m_interfaces;
+    /// Interface priorities, their order and the reversal order. Usually
+    /// shared through the distance table, m_ownOrder once changed locally
+    const DdcPriorityOrder *m_order;
+    DdcPriorityOrder *m_ownOrder;
+    /// The output bitmasks match m_order
+    bool m_orderValid;
+    VnodeState m_vnodes[2];
+    uint8_t m_localVnode;
+    bool m_held;
+    /// Message control plane: a lock request was denied, or we had to give
+    /// our own lock away while collecting
+    bool m_lockFailed;
+    bool m_aeoRequested;
+    /// The reversal order was set by SetReversalOrder rather than taken from
+    /// the distance table
+    bool m_hasReversalOrder;
+    uint32_t m_lockCount;
+    /// Message control plane: lock requests still waiting for an answer
+    uint32_t m_lockWaiting;
+    uint32_t m_heartbeatSequence;
+  };
+
+  typedef sgi::hash_map<Ipv4Address, uint32_t, Ipv4AddressHash> DestinationIndex;
+  /// @apanda A deque, so growing it neither moves existing state nor
+  /// leaves half the allocation unused
+  typedef std::deque<DestinationState> DestinationTable;
+  /// @apanda Keyed by PendingKey(vnode, dest, toOutput), only holds entries
+  /// while something is pending
+  typedef std::map<uint32_t, PendingReversals> PendingReversalMap;
+  /// @apanda Address to a list of interfaces
+  typedef sgi::hash_map<Ipv4Address, std::vector<uint32_t>, Ipv4AddressHash> AddressInterfaceMap;
+
+  /// @apanda What SaveDdcState saw. Orders in m_ownOrders, including the
+  /// default order, are saved by their position since states point into it;
+  /// NO_NODE stands for none, or for an order shared with the distance table
+  struct SavedDdcState {
+    DestinationIndex m_destinationIndex;
+    DestinationTable m_destinations;
+    std::vector<uint32_t> m_ownOrderIndex;
+    std::vector<uint32_t> m_orderIndex;
+    uint32_t m_defaultOrderIndex;
+    std::deque<DdcPriorityOrder> m_ownOrders;
+    AddressInterfaceMap m_routeInterfaces;
+    uint32_t m_toReverseEpoch[2];
+  };
+
+/**
+ * @apanda
+ * Get the list of interfaces waiting to be reversed, dropping it if it has
+ * been invalidated by a reversal for some other destination
+ */
+  std::list<uint32_t>& GetToReverse (uint8_t vnode, DestinationState &state);
+
+/**
+ * @apanda
+ * Change the direction of a link, keeping the output bitmask in sync
+ */
+  void SetDirection (DestinationState &state, uint8_t vnode, uint32_t iface, LinkDirection direction);
+
+/**
+ * @apanda
+ * Recompute the priority order of a destination's interfaces and rebuild the
+ * output bitmasks to match, if priorities have changed since the last time
+ */
+  void UpdateOrder (DestinationState &state);
+
+/**
+ * @apanda
+ * Give state a priority order of its own to change, copied from the one it
+ * uses now
+ */
+  DdcPriorityOrder& OwnOrder (DestinationState &state);
+
+/**
+ * @apanda
+ * The order used for destinations without distances: every interface has
+ * priority 0 and there is no reversal order
+ */
+  const DdcPriorityOrder* GetDefaultOrder (void);
+
+/**
+ * @apanda
+ * Record that an SPF route for addr leaves through interface, without
+ * creating DDC state for addr if there is none yet
+ */
+  void AddRouteInterface (Ipv4Address addr, uint32_t interface);
+
+/**
+ * @apanda
+ * Set link priorities (and the reversal order, unless one has been set
+ * already) for a destination from the distance table
+ */
+  void ApplyDistances (DestinationState &state);
+
+/**
+ * @apanda
+ * Reverse link for dest after the configured delay. Requests for a link
+ * that is already waiting to be reversed are dropped, and all pending
+ * reversals of one kind for (vnode, dest) share a single timer.
+ */
+  void QueueReversal (uint8_t vnode, uint32_t dest, uint32_t link, bool toOutput);
+
+/**
+ * @apanda
+ * Timer callback, apply every pending reversal of one kind for (vnode, dest)
+ */
+  void ApplyReversals (uint8_t vnode, uint32_t dest, bool toOutput);
+
+/**
+ * @apanda
+ * Drop (and stop the timers of) all pending reversals for (vnode, dest)
+ */
+  void CancelReversals (uint8_t vnode, uint32_t dest);
+
+  static uint32_t PendingKey (uint8_t vnode, uint32_t dest, bool toOutput);
+
+/**
+ * @apanda
+ * Recompute the local and broadcast address sets from the interfaces
+ * currently configured on m_ipv4, and drop the cached interface routes
+ */
+  void RebuildLocalAddresses (void);
+
+/**
+ * @apanda
+ * Is address one of ours, as seen from interface iif? With the weak end
+ * system model any interface will do, otherwise the address has to be
+ * configured on iif. Broadcast addresses are only accepted when broadcast
+ * is true.
+ */
+  bool IsLocalAddress (Ipv4Address address, uint32_t iif, bool broadcast) const;
+
+/**
+ * @apanda
+ * Get the shared route used for every packet leaving through interface.
+ * Routes on point-to-point links name the neighbour as the gateway and so do
+ * not depend on the packet; they are built once and handed out until an
+ * interface or address changes. Returns 0 for interfaces on shared media,
+ * where the caller has to build a route per packet.
+ */
+  Ptr<Ipv4Route> GetInterfaceRoute (uint32_t interface);
+
+  bool m_allowReversal;
+  /// @apanda Spread flows over equal priority Out links
+  bool m_flowHashing;
+  /// @apanda Scratch space for FindOutputPort: the usable links tied for the
+  /// best priority, kept to avoid allocating per packet
+  std::vector<uint32_t> m_ties;
+  StateKey m_stateKey;
+  /// RFC 1222 weak end system model (accept local addresses on any interface)
+  bool m_weakEsModel;
+  AddressInterfaceMap m_localAddresses;
+  AddressInterfaceMap m_broadcastAddresses;
+  /// @apanda Cached routes by outgoing interface, empty when invalidated
+  std::vector<Ptr<Ipv4Route> > m_interfaceRoutes;
+  /// @apanda Address to dense index into m_destinations
+  DestinationIndex m_destinationIndex;
+  DestinationTable m_destinations;
+  uint32_t m_toReverseEpoch[2];
+  /// @apanda Shared distances, and where this node sits in them
+  Ptr<DdcDistanceTable> m_distanceTable;
+  uint32_t m_nodeId;
+  /// @apanda Priority orders changed by this node, a deque so that states
+  /// can point into it
+  std::deque<DdcPriorityOrder> m_ownOrders;
+  DdcPriorityOrder *m_defaultOrder;
+  /// @apanda Output interfaces from SPF routes to destinations without DDC
+  /// state yet, applied when the state is created
+  AddressInterfaceMap m_routeInterfaces;
 
   Time m_reverseInputToOutputDelay;
   Time m_reverseOutputToInputDelay;
@@ -469,6 +898,40 @@ private:
   Ptr<Ipv4> m_ipv4;
 
   TracedCallback<uint32_t, Ipv4Address> m_reversalCallback;
+  PendingReversalMap m_pendingReversals;
+  /// @apanda Message control plane
+  ControlPlane m_controlPlane;
+  Time m_controlProcessingDelay;
+  Time m_controlBatchDelay;
+  uint32_t m_controlBatchSize;
+  Ptr<DdcControlProtocol> m_controlProtocol;
+  /// Messages waiting to be sent, and the pending flush, by interface
+  std::vector<DdcControlHeader> m_controlQueues;
+  std::vector<EventId> m_controlFlush;
+  /// Interfaces below this already have a link change callback
+  uint32_t m_controlLinksWatched;
+  /// @apanda Tell the route manager about link changes, and the interfaces
+  /// below m_routingLinksWatched that already do
+  bool m_recomputeOnLinkChange;
+  uint32_t m_routingLinksWatched;
+  /// @apanda Control plane convergence model
+  Time m_lsaHopDelay;
+  Time m_spfDelay;
+  Time m_spfHoldTime;
+  bool m_resetOnConvergence;
+  TracedCallback<Ptr<const Packet>, uint32_t> m_controlTxTrace;
+  TracedCallback<Ptr<const Packet>, uint32_t> m_controlRxTrace;
+  /// @apanda While a batch of unlocks or heartbeats is handled, AEOs it
+  /// triggers are collected here and run as one batch at the end
+  bool m_collectAEO;
+  std::vector<Ipv4Address> m_collectedAEO;
+  /// @apanda Delayed reversals that were queued
+  TracedValue<uint32_t> m_scheduledReversals;
+  /// @apanda Delayed reversal requests absorbed by one already queued
+  TracedValue<uint32_t> m_coalescedReversals;
+  /// @apanda Set by SaveDdcState
+  SavedDdcState m_saved;
+  bool m_hasSaved;
 };
 
 } // Namespace ns3
@@ -22,12 +22,29 @@
 #include "ns3/abort.h"
 #include "ns3/log.h"
 #include "ns3/header.h"
+#include "ns3/global-value.h"
+#include "ns3/enum.h"
 #include "ipv4-header.h"
 
 NS_LOG_COMPONENT_DEFINE ("Ipv4Header");
 
 namespace ns3 {
 
+// @apanda
+static GlobalValue g_ddcHeaderEncoding = GlobalValue ("DdcHeaderEncoding",
+                                                      "Where Ipv4Header carries the DDC sequence and vnode bits. "
+                                                      "Checksum puts them in the header checksum field, which is "
+                                                      "overwritten when checksums are enabled; Flags puts the sequence "
+                                                      "bit in the reserved flag bit and the vnode bit in the top bit "
+                                                      "of the identification field, leaving the checksum intact.",
+                                                      EnumValue (Ipv4Header::DDC_CHECKSUM_FIELD),
+                                                      MakeEnumChecker (Ipv4Header::DDC_CHECKSUM_FIELD, "Checksum",
+                                                                       Ipv4Header::DDC_FLAGS, "Flags"));
+
+// @apanda Cached g_ddcHeaderEncoding, read on first use
+static bool g_ddcEncodingCached = false;
+static Ipv4Header::DdcEncoding g_ddcEncoding = Ipv4Header::DDC_CHECKSUM_FIELD;
+
 NS_OBJECT_ENSURE_REGISTERED (Ipv4Header);
 
 Ipv4Header::Ipv4Header ()
@@ -41,7 +58,9 @@ Ipv4Header::Ipv4Header ()
     m_fragmentOffset (0),
     m_checksum (0),
     m_goodChecksum (true),
-    m_headerSize(5*4)
+    m_headerSize(5*4),
+    m_seq (0),
+    m_vnode (0)
 {
 }
 
@@ -355,7 +374,15 @@ Ipv4Header::Serialize (Buffer::Iterator start) const
   i.WriteU8 (verIhl);
   i.WriteU8 (m_tos);
   i.WriteHtonU16 (m_payloadSize + 5*4);
-  i.WriteHtonU16 (m_identification);
+  DdcEncoding encoding = GetDdcEncoding ();
+  if (encoding == DDC_FLAGS)
+    {
+      i.WriteHtonU16 ((m_identification & 0x7fff) | (m_vnode << 15));
+    }
+  else
+    {
+      i.WriteHtonU16 (m_identification);
+    }
   uint32_t fragmentOffset = m_fragmentOffset / 8;
   uint8_t flagsFrag = (fragmentOffset >> 8) & 0x1f;
   if (m_flags & DONT_FRAGMENT) 
@@ -366,13 +393,24 @@ Ipv4Header::Serialize (Buffer::Iterator start) const
     {
       flagsFrag |= (1<<5);
     }
+  if (encoding == DDC_FLAGS && m_seq)
+    {
+      flagsFrag |= (1<<7);
+    }
   i.WriteU8 (flagsFrag);
   uint8_t frag = fragmentOffset & 0xff;
   i.WriteU8 (frag);
   i.WriteU8 (m_ttl);
   i.WriteU8 (m_protocol);
-  i.WriteU8 ((uint8_t)m_seq); 
-  i.WriteU8 ((uint8_t)m_vnode);
+  if (encoding == DDC_FLAGS)
+    {
+      i.WriteU16 (0);
+    }
+  else
+    {
+      i.WriteU8 ((uint8_t)m_seq); 
+      i.WriteU8 ((uint8_t)m_vnode);
+    }
   i.WriteHtonU32 (m_source.Get ());
   i.WriteHtonU32 (m_destination.Get ());
 
@@ -415,8 +453,18 @@ Ipv4Header::Deserialize (Buffer::Iterator start)
   m_fragmentOffset <<= 3;
   m_ttl = i.ReadU8 ();
   m_protocol = i.ReadU8 ();
-  m_seq = i.ReadU8() & 0x1;
-  m_vnode = i.ReadU8() & 0x1;
+  if (GetDdcEncoding () == DDC_FLAGS)
+    {
+      m_seq = (flags >> 7) & 0x1;
+      m_vnode = (m_identification >> 15) & 0x1;
+      m_identification &= 0x7fff;
+      i.Next (2); // checksum
+    }
+  else
+    {
+      m_seq = i.ReadU8() & 0x1;
+      m_vnode = i.ReadU8() & 0x1;
+    }
   m_checksum = 0;
   /* i.Next (2); // checksum */
   m_source.Set (i.ReadNtohU32 ());
@@ -461,4 +509,34 @@ Ipv4Header::GetVnode () const
 {
   return (m_vnode & 0x1);
 }
+
+// @apanda
+Ipv4Header::DdcEncoding
+Ipv4Header::GetDdcEncoding (void)
+{
+  if (!g_ddcEncodingCached)
+    {
+      RefreshDdcEncoding ();
+    }
+  return g_ddcEncoding;
+}
+
+// @apanda
+void
+Ipv4Header::SetDdcEncoding (DdcEncoding encoding)
+{
+  g_ddcHeaderEncoding.SetValue (EnumValue (encoding));
+  g_ddcEncoding = encoding;
+  g_ddcEncodingCached = true;
+}
+
+// @apanda
+void
+Ipv4Header::RefreshDdcEncoding (void)
+{
+  EnumValue val;
+  g_ddcHeaderEncoding.GetValue (val);
+  g_ddcEncoding = (DdcEncoding)val.Get ();
+  g_ddcEncodingCached = true;
+}
 } // namespace ns3
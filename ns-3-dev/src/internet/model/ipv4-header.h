@@ -242,6 +242,45 @@ public:
    */
   uint32_t GetVnode (void) const;
 
+  /**
+   * @apanda
+   * \brief Where the DDC sequence and vnode bits travel in the 20 byte
+   * header, selected by the "DdcHeaderEncoding" GlobalValue.
+   *
+   * DDC_CHECKSUM_FIELD keeps them in the two checksum bytes, so they are
+   * lost when checksums are enabled. DDC_FLAGS uses the reserved flag bit
+   * for the sequence bit and the top bit of the identification field for
+   * the vnode bit, which limits identification to 15 bits but lets the
+   * checksum be computed normally.
+   */
+  enum DdcEncoding
+  {
+    DDC_CHECKSUM_FIELD,
+    DDC_FLAGS
+  };
+
+  /**
+   * @apanda
+   * \returns the encoding every header is serialized with. It is read from
+   * the "DdcHeaderEncoding" GlobalValue once and cached, since headers are
+   * serialized at every hop; the cache is refreshed when the nodes start and
+   * by the functions below.
+   */
+  static DdcEncoding GetDdcEncoding (void);
+
+  /**
+   * @apanda
+   * \brief Set the "DdcHeaderEncoding" GlobalValue and the cached encoding
+   */
+  static void SetDdcEncoding (DdcEncoding encoding);
+
+  /**
+   * @apanda
+   * \brief Read the "DdcHeaderEncoding" GlobalValue again, after it was
+   * changed with Config::SetGlobal
+   */
+  static void RefreshDdcEncoding (void);
+
   static TypeId GetTypeId (void);
   virtual TypeId GetInstanceTypeId (void) const;
   virtual void Print (std::ostream &os) const;
@@ -185,6 +185,15 @@ Ipv4L3Protocol::GetRoutingProtocol (void) const
   return m_routingProtocol;
 }
 
+// @apanda
+void
+Ipv4L3Protocol::DoStart (void)
+{
+  NS_LOG_FUNCTION (this);
+  Ipv4Header::RefreshDdcEncoding ();
+  Ipv4::DoStart ();
+}
+
 void 
 Ipv4L3Protocol::DoDispose (void)
 {
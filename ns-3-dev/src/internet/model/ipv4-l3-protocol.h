@@ -213,6 +213,12 @@ public:
 protected:
 
   virtual void DoDispose (void);
+  /**
+   * @apanda
+   * Picks up the "DdcHeaderEncoding" GlobalValue for the run, see
+   * Ipv4Header::RefreshDdcEncoding
+   */
+  virtual void DoStart (void);
   /**
    * This function will notify other components connected to the node that a new stack member is now connected
    * This will be used to notify Layer 3 protocol of layer 4 protocol stack to connect them together.
@@ -49,16 +49,29 @@ GlobalRouteManagerImplTestCase::DoRun (void)
   for (int i = 0; i < 100; ++i)
     {
       SPFVertex *v = new SPFVertex;
-      v->SetDistanceFromRoot (rand () % 100);
+      v->SetVertexId (Ipv4Address (i + 1));
+      v->SetDistanceFromRoot (rand () % 100 + 10);
       candidate.Push (v);
     }
 
+  // Lower one distance below every other; Update must move it to the top
+  SPFVertex *cw = candidate.Find (Ipv4Address (50));
+  NS_TEST_ASSERT_MSG_NE (cw, 0, "Find did not return a pushed vertex");
+  cw->SetDistanceFromRoot (0);
+  candidate.Update (cw);
+  NS_TEST_ASSERT_MSG_EQ (candidate.Top (), cw, "Update did not reorder the queue");
+
+  uint32_t lastDistance = 0;
   for (int i = 0; i < 100; ++i)
     {
       SPFVertex *v = candidate.Pop ();
+      NS_TEST_ASSERT_MSG_EQ ((v->GetDistanceFromRoot () < lastDistance), false,
+                             "Candidates popped out of order");
+      lastDistance = v->GetDistanceFromRoot ();
       delete v;
       v = 0;
     }
+  NS_TEST_ASSERT_MSG_EQ (candidate.Find (Ipv4Address (50)), 0, "Popped vertex is still found");
 
   // Build fake link state database; four routers (0-3), 3 point-to-point
   // links
@@ -0,0 +1,242 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <list>
+#include <vector>
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/node-container.h"
+#include "ns3/net-device-container.h"
+#include "ns3/simple-channel.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/mac48-address.h"
+#include "ns3/packet.h"
+#include "ns3/socket.h"
+#include "ns3/node.h"
+#include "ns3/ipv4.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-address-helper.h"
+#include "ns3/ipv4-address-generator.h"
+#include "ns3/global-router-interface.h"
+#include "ns3/ipv4-global-routing.h"
+#include "ns3/ddc-distance-table.h"
+
+namespace ns3 {
+
+namespace {
+
+const Ipv4Address g_source ("10.1.1.1");
+const Ipv4Address g_dest ("10.1.1.2");
+// Not in any distance table
+const Ipv4Address g_unknown ("10.1.2.1");
+const Ipv4Address g_unknown2 ("10.1.3.1");
+
+// Two nodes on one link, returns the global routing of the first one
+Ptr<Ipv4GlobalRouting>
+CreateRouter (Ptr<Node> *first = 0)
+{
+  NodeContainer nodes;
+  nodes.Create (2);
+  Ptr<SimpleChannel> channel = CreateObject<SimpleChannel> ();
+  NetDeviceContainer devices;
+  for (uint32_t i = 0; i < 2; i++)
+    {
+      Ptr<SimpleNetDevice> device = CreateObject<SimpleNetDevice> ();
+      device->SetAddress (Mac48Address::Allocate ());
+      device->SetChannel (channel);
+      nodes.Get (i)->AddDevice (device);
+      devices.Add (device);
+    }
+  InternetStackHelper internet;
+  internet.Install (nodes);
+  Ipv4AddressGenerator::Reset ();
+  Ipv4AddressHelper addresses;
+  addresses.SetBase ("10.1.1.0", "255.255.255.0");
+  addresses.Assign (devices);
+  if (first)
+    {
+      *first = nodes.Get (0);
+    }
+  return nodes.Get (0)->GetObject<GlobalRouter> ()->GetRoutingProtocol ();
+}
+
+// Distances between the two nodes, knowing the address of the second one
+// only if withDest
+Ptr<DdcDistanceTable>
+CreateTable (bool withDest)
+{
+  Ptr<DdcDistanceTable> table = Create<DdcDistanceTable> (2);
+  for (uint32_t from = 0; from < 2; from++)
+    {
+      for (uint32_t to = 0; to < 2; to++)
+        {
+          table->SetDistance (from, to, from == to ? 0 : 1);
+        }
+    }
+  table->AddAddress (g_source, 0);
+  if (withDest)
+    {
+      table->AddAddress (g_dest, 1);
+    }
+  return table;
+}
+
+void
+Install (Ptr<Ipv4GlobalRouting> routing, Ptr<DdcDistanceTable> table)
+{
+  std::vector<uint32_t> neighbours;
+  neighbours.push_back (DdcDistanceTable::NO_NODE);
+  neighbours.push_back (1);
+  routing->SetDistanceTable (table, 0, neighbours);
+}
+
+void
+Route (Ptr<Ipv4GlobalRouting> routing, Ipv4Address dest = g_dest)
+{
+  Ipv4Header header;
+  header.SetSource (g_source);
+  header.SetDestination (dest);
+  Socket::SocketErrno error;
+  routing->RouteOutput (Create<Packet> (), header, 0, error);
+}
+
+} // anonymous namespace
+
+class DdcDistanceTableSwapTestCase : public TestCase
+{
+public:
+  DdcDistanceTableSwapTestCase ();
+private:
+  virtual void DoRun (void);
+};
+
+DdcDistanceTableSwapTestCase::DdcDistanceTableSwapTestCase ()
+  : TestCase ("Destinations leave the order of a replaced distance table")
+{
+}
+
+void
+DdcDistanceTableSwapTestCase::DoRun (void)
+{
+  Ptr<Ipv4GlobalRouting> routing = CreateRouter ();
+  Ptr<DdcDistanceTable> first = CreateTable (true);
+  Install (routing, first);
+  Route (routing);
+  const DdcPriorityOrder *shared = first->GetPriorityOrder (0, 1);
+  NS_TEST_ASSERT_MSG_EQ (routing->GetPriorityOrder (g_dest), shared, "order not shared with the table");
+  NS_TEST_ASSERT_MSG_EQ (shared->m_reverseBefore.size (), 1, "the neighbour reverses first");
+
+  // The new table doesn't know the destination
+  Install (routing, CreateTable (false));
+  const DdcPriorityOrder *order = routing->GetPriorityOrder (g_dest);
+  NS_TEST_ASSERT_MSG_NE (order, shared, "still pointing into the replaced table");
+  NS_TEST_EXPECT_MSG_EQ (order->m_reverseBefore.size (), 0, "not the default order");
+  NS_TEST_EXPECT_MSG_EQ (order->m_priority.size (), 2, "not the default order");
+  first = 0;
+  Route (routing);
+
+  // A reversal order that was set survives
+  routing = CreateRouter ();
+  first = CreateTable (true);
+  Install (routing, first);
+  std::list<uint32_t> reversal;
+  reversal.push_back (1);
+  reversal.push_back (0);
+  routing->SetReversalOrder (g_dest, reversal);
+  // The reversal order matches the table's, so the table's order is shared
+  routing->RefreshDistances ();
+  shared = first->GetPriorityOrder (0, 1);
+  NS_TEST_ASSERT_MSG_EQ (routing->GetPriorityOrder (g_dest), shared, "order not shared with the table");
+  Install (routing, CreateTable (false));
+  order = routing->GetPriorityOrder (g_dest);
+  NS_TEST_ASSERT_MSG_NE (order, shared, "still pointing into the replaced table");
+  NS_TEST_ASSERT_MSG_EQ (order->m_reverseBefore.size (), 1, "reversal order lost");
+  NS_TEST_EXPECT_MSG_EQ (order->m_reverseBefore[0], 1, "reversal order lost");
+  Simulator::Destroy ();
+}
+
+class DdcStateRestoreTestCase : public TestCase
+{
+public:
+  DdcStateRestoreTestCase ();
+private:
+  virtual void DoRun (void);
+};
+
+DdcStateRestoreTestCase::DdcStateRestoreTestCase ()
+  : TestCase ("Restored DDC state uses the orders it was saved with")
+{
+}
+
+void
+DdcStateRestoreTestCase::DoRun (void)
+{
+  Ptr<Node> node;
+  Ptr<Ipv4GlobalRouting> routing = CreateRouter (&node);
+  Ptr<DdcDistanceTable> table = CreateTable (true);
+  Install (routing, table);
+  Route (routing);
+  Route (routing, g_unknown);
+  const DdcPriorityOrder *shared = table->GetPriorityOrder (0, 1);
+  NS_TEST_ASSERT_MSG_EQ (routing->GetPriorityOrder (g_dest), shared, "order not shared with the table");
+  NS_TEST_ASSERT_MSG_EQ (routing->GetPriorityOrder (g_unknown)->m_priority.size (), 2, "no default order");
+  routing->SaveDdcState ();
+
+  // Give the destination its own priorities, and add an interface so that
+  // the next destination gets a new default order
+  routing->SetInterfacePriority (g_dest, 1, 5);
+  NS_TEST_ASSERT_MSG_NE (routing->GetPriorityOrder (g_dest), shared, "own priorities not used");
+  Ptr<SimpleNetDevice> device = CreateObject<SimpleNetDevice> ();
+  device->SetAddress (Mac48Address::Allocate ());
+  device->SetChannel (CreateObject<SimpleChannel> ());
+  node->AddDevice (device);
+  node->GetObject<Ipv4> ()->AddInterface (device);
+  Route (routing, g_unknown2);
+  NS_TEST_ASSERT_MSG_EQ (routing->GetPriorityOrder (g_unknown2)->m_priority.size (), 3, "default order not rebuilt");
+
+  routing->RestoreDdcState ();
+  NS_TEST_EXPECT_MSG_EQ (routing->GetNDestinations (), 2, "destinations not restored");
+  NS_TEST_EXPECT_MSG_EQ (routing->GetPriorityOrder (g_dest), shared, "shared order not restored");
+  NS_TEST_EXPECT_MSG_EQ (routing->GetPriorityOrder (g_unknown2), 0, "state created after the save kept");
+  const DdcPriorityOrder *order = routing->GetPriorityOrder (g_unknown);
+  NS_TEST_ASSERT_MSG_NE (order, 0, "state lost");
+  NS_TEST_EXPECT_MSG_EQ (order->m_priority.size (), 2, "default order not restored");
+
+  // Restoring again gives the same state
+  Route (routing, g_unknown2);
+  routing->RestoreDdcState ();
+  NS_TEST_EXPECT_MSG_EQ (routing->GetPriorityOrder (g_dest), shared, "shared order not restored twice");
+  NS_TEST_EXPECT_MSG_EQ (routing->GetPriorityOrder (g_unknown)->m_priority.size (), 2, "default order not restored twice");
+  Route (routing);
+  Simulator::Destroy ();
+}
+
+class Ipv4GlobalRoutingDdcTestSuite : public TestSuite
+{
+public:
+  Ipv4GlobalRoutingDdcTestSuite ();
+};
+
+Ipv4GlobalRoutingDdcTestSuite::Ipv4GlobalRoutingDdcTestSuite ()
+  : TestSuite ("ipv4-global-routing-ddc", UNIT)
+{
+  AddTestCase (new DdcDistanceTableSwapTestCase ());
+  AddTestCase (new DdcStateRestoreTestCase ());
+}
+
+static Ipv4GlobalRoutingDdcTestSuite ipv4GlobalRoutingDdcTestSuite;
+
+} // namespace ns3
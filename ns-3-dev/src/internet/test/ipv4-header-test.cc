@@ -32,6 +32,12 @@
 #include "ns3/node.h"
 #include "ns3/inet-socket-address.h"
 #include "ns3/boolean.h"
+#include "ns3/string.h"
+#include "ns3/config.h"
+#include "ns3/enum.h"
+#include "ns3/global-value.h"
+#include "ns3/packet.h"
+#include "ns3/ipv4-header.h"
 
 #include "ns3/arp-l3-protocol.h"
 #include "ns3/ipv4-l3-protocol.h"
@@ -255,12 +261,84 @@ Ipv4HeaderTest::DoRun (void)
   Simulator::Destroy ();
 }
 //-----------------------------------------------------------------------------
+// @apanda
+// Round trip the DDC bits through a checksummed header in both encodings.
+class Ipv4HeaderDdcTest : public TestCase
+{
+public:
+  Ipv4HeaderDdcTest ();
+  virtual void DoRun (void);
+private:
+  void CheckRoundTrip (std::string encoding, bool expectDdcBits);
+};
+
+Ipv4HeaderDdcTest::Ipv4HeaderDdcTest ()
+  : TestCase ("DDC sequence and vnode bits survive header serialization")
+{
+}
+
+void
+Ipv4HeaderDdcTest::CheckRoundTrip (std::string encoding, bool expectDdcBits)
+{
+  Config::SetGlobal ("DdcHeaderEncoding", StringValue (encoding));
+  // Headers keep using the cached encoding until it is refreshed
+  Ipv4Header::RefreshDdcEncoding ();
+  for (uint32_t seq = 0; seq < 2; seq++)
+    {
+      for (uint32_t vnode = 0; vnode < 2; vnode++)
+        {
+          Ipv4Header sent;
+          sent.EnableChecksum ();
+          sent.SetSource (Ipv4Address ("10.0.0.1"));
+          sent.SetDestination (Ipv4Address ("10.0.0.2"));
+          sent.SetProtocol (17);
+          sent.SetTtl (64);
+          sent.SetPayloadSize (100);
+          sent.SetIdentification (0x1234);
+          sent.SetDontFragment ();
+          sent.SetSeq (seq);
+          sent.SetVnode (vnode);
+
+          Ptr<Packet> p = Create<Packet> (100);
+          p->AddHeader (sent);
+          NS_TEST_EXPECT_MSG_EQ (p->GetSize (), 120, "IPv4 header is not 20 bytes");
+
+          Ipv4Header received;
+          received.EnableChecksum ();
+          p->RemoveHeader (received);
+          NS_TEST_EXPECT_MSG_EQ (received.GetIdentification (), 0x1234, "Identification changed with " << encoding);
+          NS_TEST_EXPECT_MSG_EQ (received.IsDontFragment (), true, "Flags changed with " << encoding);
+          if (expectDdcBits)
+            {
+              NS_TEST_EXPECT_MSG_EQ (received.IsChecksumOk (), true, "Bad checksum with " << encoding);
+              NS_TEST_EXPECT_MSG_EQ (received.GetSeq (), seq, "Sequence bit lost with " << encoding);
+              NS_TEST_EXPECT_MSG_EQ (received.GetVnode (), vnode, "Vnode bit lost with " << encoding);
+            }
+        }
+    }
+}
+
+void
+Ipv4HeaderDdcTest::DoRun (void)
+{
+  // In the default encoding the DDC bits share the checksum field, so
+  // neither they nor the checksum survive; only check the other fields.
+  CheckRoundTrip ("Checksum", false);
+  CheckRoundTrip ("Flags", true);
+  Ipv4Header::SetDdcEncoding (Ipv4Header::DDC_CHECKSUM_FIELD);
+  NS_TEST_EXPECT_MSG_EQ (Ipv4Header::GetDdcEncoding (), Ipv4Header::DDC_CHECKSUM_FIELD, "Setter not cached");
+  EnumValue global;
+  GlobalValue::GetValueByName ("DdcHeaderEncoding", global);
+  NS_TEST_EXPECT_MSG_EQ (global.Get (), Ipv4Header::DDC_CHECKSUM_FIELD, "Setter did not set the GlobalValue");
+}
+
 class Ipv4HeaderTestSuite : public TestSuite
 {
 public:
   Ipv4HeaderTestSuite () : TestSuite ("ipv4-header", UNIT)
   {
     AddTestCase (new Ipv4HeaderTest);
+    AddTestCase (new Ipv4HeaderDdcTest);
   }
 } g_ipv4HeaderTestSuite;
 
@@ -24,6 +24,7 @@
 #include "ns3/error-model.h"
 #include "ns3/trace-source-accessor.h"
 #include "ns3/uinteger.h"
+#include "ns3/boolean.h"
 #include "ns3/pointer.h"
 #include "ns3/mpi-interface.h"
 #include "point-to-point-net-device.h"
@@ -72,6 +73,13 @@ PointToPointNetDevice::GetTypeId (void)
                    TimeValue (Seconds (0.0)),
                    MakeTimeAccessor (&PointToPointNetDevice::m_tInterframeGap),
                    MakeTimeChecker ())
+    // @apanda Lets saved link state be put back without a channel at hand
+    .AddAttribute ("LinkUp",
+                   "Whether the link is up. Setting it does not call the link change callbacks, "
+                   "use PointToPointChannel::SetLinkUp/SetLinkDown for that",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&PointToPointNetDevice::m_linkUp),
+                   MakeBooleanChecker ())
 
     //
     // Transmit queueing discipline for the device which includes its own set
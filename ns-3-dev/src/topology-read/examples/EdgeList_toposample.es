@@ -0,0 +1 @@
+[4, 5, 6, 7]
@@ -0,0 +1,212 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/log.h"
+#include "ns3/assert.h"
+#include "ns3/abort.h"
+#include "ns3/system-wall-clock-ms.h"
+#include "ns3/ipv4.h"
+#include "ns3/internet-stack-helper.h"
+#include "point-to-point-topology-helper.h"
+
+NS_LOG_COMPONENT_DEFINE ("PointToPointTopologyHelper");
+
+namespace ns3 {
+
+const uint32_t PointToPointTopologyHelper::NO_LINK;
+
+PointToPointTopologyHelper::PointToPointTopologyHelper ()
+  : m_merge (false),
+    m_installTime (0)
+{
+  SetBase (Ipv4Address ("10.1.1.0"), Ipv4Mask ("255.255.255.0"));
+}
+
+void
+PointToPointTopologyHelper::SetDeviceAttribute (std::string name, const AttributeValue &value)
+{
+  m_pointToPoint.SetDeviceAttribute (name, value);
+}
+
+void
+PointToPointTopologyHelper::SetChannelAttribute (std::string name, const AttributeValue &value)
+{
+  m_pointToPoint.SetChannelAttribute (name, value);
+}
+
+void
+PointToPointTopologyHelper::SetBase (Ipv4Address network, Ipv4Mask mask)
+{
+  m_hostBits = 32 - mask.GetPrefixLength ();
+  NS_ABORT_MSG_IF (m_hostBits < 2 || m_hostBits > 30,
+                   "PointToPointTopologyHelper::SetBase(): " << mask << " is not a mask for two hosts per link");
+  m_mask = mask;
+  m_base = network.CombineMask (mask).Get ();
+}
+
+void
+PointToPointTopologyHelper::SetMergeParallelEdges (bool merge)
+{
+  m_merge = merge;
+}
+
+NodeContainer
+PointToPointTopologyHelper::Install (const TopologyGraph &graph)
+{
+  NS_LOG_FUNCTION (this << graph.GetNNodes () << graph.GetNEdges ());
+  SystemWallClockMs clock;
+  clock.Start ();
+
+  NodeContainer nodes;
+  nodes.Create (graph.GetNNodes ());
+  m_offsets = graph.GetOffsets ();
+  m_neighbours = graph.GetNeighbours ();
+  m_slotLinks.assign (m_neighbours.size (), NO_LINK);
+  m_linkNodes.clear ();
+  m_linkDevices.clear ();
+  m_channels.clear ();
+  m_linkNodes.reserve (m_neighbours.size ());
+  m_linkDevices.reserve (m_neighbours.size ());
+  m_channels.reserve (m_neighbours.size () / 2);
+
+  for (uint32_t i = 0; i < graph.GetNNodes (); i++)
+    {
+      for (uint32_t slot = m_offsets[i]; slot < m_offsets[i + 1]; slot++)
+        {
+          uint32_t j = m_neighbours[slot];
+          if (j <= i)
+            {
+              continue;
+            }
+          if (m_merge)
+            {
+              uint32_t link = GetLink (i, j);
+              if (link != NO_LINK)
+                {
+                  m_slotLinks[slot] = link;
+                  continue;
+                }
+            }
+          NetDeviceContainer devices = m_pointToPoint.Install (nodes.Get (i), nodes.Get (j));
+          m_slotLinks[slot] = m_channels.size ();
+          m_linkNodes.push_back (i);
+          m_linkNodes.push_back (j);
+          m_linkDevices.push_back (devices.Get (0));
+          m_linkDevices.push_back (devices.Get (1));
+          m_channels.push_back (DynamicCast<PointToPointChannel> (devices.Get (0)->GetChannel ()));
+        }
+    }
+
+  InternetStackHelper stack;
+  stack.Install (nodes);
+
+  NS_ABORT_MSG_IF ((m_base >> m_hostBits) + m_channels.size () > (1u << (32 - m_hostBits)),
+                   "PointToPointTopologyHelper::Install(): " << m_channels.size () << " links overflow the address space");
+  for (uint32_t link = 0; link < m_channels.size (); link++)
+    {
+      for (uint32_t side = 0; side < 2; side++)
+        {
+          Ptr<NetDevice> device = m_linkDevices[2 * link + side];
+          Ptr<Ipv4> ipv4 = device->GetNode ()->GetObject<Ipv4> ();
+          int32_t interface = ipv4->AddInterface (device);
+          ipv4->AddAddress (interface, Ipv4InterfaceAddress (GetLinkAddress (link, side), m_mask));
+          ipv4->SetMetric (interface, 1);
+          ipv4->SetUp (interface);
+        }
+    }
+
+  m_installTime = clock.End ();
+  NS_LOG_INFO ("Installed " << nodes.GetN () << " nodes and " << m_channels.size ()
+               << " links in " << m_installTime << " ms");
+  return nodes;
+}
+
+int64_t
+PointToPointTopologyHelper::GetInstallTime (void) const
+{
+  return m_installTime;
+}
+
+uint32_t
+PointToPointTopologyHelper::GetNLinks (void) const
+{
+  return m_channels.size ();
+}
+
+uint32_t
+PointToPointTopologyHelper::GetLink (uint32_t from, uint32_t to) const
+{
+  if (from > to)
+    {
+      std::swap (from, to);
+    }
+  // to + 1 would wrap for NO_NODE
+  if (m_offsets.empty () || to >= m_offsets.size () - 1)
+    {
+      return NO_LINK;
+    }
+  for (uint32_t slot = m_offsets[from]; slot < m_offsets[from + 1]; slot++)
+    {
+      if (m_neighbours[slot] == to && m_slotLinks[slot] != NO_LINK)
+        {
+          return m_slotLinks[slot];
+        }
+    }
+  return NO_LINK;
+}
+
+uint32_t
+PointToPointTopologyHelper::GetLinkNode (uint32_t link, uint32_t side) const
+{
+  NS_ASSERT (link < m_channels.size () && side < 2);
+  return m_linkNodes[2 * link + side];
+}
+
+Ptr<NetDevice>
+PointToPointTopologyHelper::GetLinkDevice (uint32_t link, uint32_t side) const
+{
+  NS_ASSERT (link < m_channels.size () && side < 2);
+  return m_linkDevices[2 * link + side];
+}
+
+Ptr<PointToPointChannel>
+PointToPointTopologyHelper::GetLinkChannel (uint32_t link) const
+{
+  NS_ASSERT (link < m_channels.size ());
+  return m_channels[link];
+}
+
+Ipv4Address
+PointToPointTopologyHelper::GetLinkAddress (uint32_t link, uint32_t side) const
+{
+  NS_ASSERT (link < m_channels.size () && side < 2);
+  return Ipv4Address (m_base + (link << m_hostBits) + side + 1);
+}
+
+uint32_t
+PointToPointTopologyHelper::GetAddressNode (Ipv4Address address) const
+{
+  uint32_t offset = address.Get () - m_base;
+  uint32_t link = offset >> m_hostBits;
+  uint32_t host = offset & ((1u << m_hostBits) - 1);
+  if (address.Get () < m_base || link >= m_channels.size () || host < 1 || host > 2)
+    {
+      return TopologyGraph::NO_NODE;
+    }
+  return m_linkNodes[2 * link + host - 1];
+}
+
+} // namespace ns3
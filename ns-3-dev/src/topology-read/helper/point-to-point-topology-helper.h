@@ -0,0 +1,116 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef POINT_TO_POINT_TOPOLOGY_HELPER_H
+#define POINT_TO_POINT_TOPOLOGY_HELPER_H
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include "ns3/node-container.h"
+#include "ns3/net-device.h"
+#include "ns3/ipv4-address.h"
+#include "ns3/point-to-point-helper.h"
+#include "ns3/point-to-point-net-device.h"
+#include "ns3/point-to-point-channel.h"
+#include "ns3/topology-graph.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup topology
+ *
+ * \brief Build a whole TopologyGraph out of point to point links.
+ *
+ * Install () creates a node for every graph node and a link for every
+ * edge, in row order (the edges of node 0 to higher nodes, then those of
+ * node 1, ...), configuring the devices and channels once for all of them.
+ * It then installs the internet stack on the nodes and gives link k the
+ * k-th subnet after the base, with .1 on the lower node and .2 on the higher
+ * one: the same addresses Ipv4AddressHelper::Assign () and NewNetwork ()
+ * hand out link by link, but computed rather than recorded with the
+ * Ipv4AddressGenerator, whose bookkeeping grows with every subnet.
+ *
+ * Because the addresses are computed, the node behind an address and the
+ * link between two nodes are found from flat arrays indexed by link.
+ */
+class PointToPointTopologyHelper
+{
+public:
+  /// Returned by GetLink () for nodes that are not neighbours
+  static const uint32_t NO_LINK = 0xffffffff;
+
+  PointToPointTopologyHelper ();
+
+  /// Set an attribute on every PointToPointNetDevice
+  void SetDeviceAttribute (std::string name, const AttributeValue &value);
+  /// Set an attribute on every PointToPointChannel
+  void SetChannelAttribute (std::string name, const AttributeValue &value);
+
+  /**
+   * \brief Set the subnet of the first link and the mask of every link.
+   * The default is 10.1.1.0/24.
+   */
+  void SetBase (Ipv4Address network, Ipv4Mask mask);
+
+  /**
+   * \brief Install one link for each pair of neighbours instead of one per
+   * edge when the graph lists an edge more than once. Off by default.
+   */
+  void SetMergeParallelEdges (bool merge);
+
+  /**
+   * \brief Create the nodes and links of a graph, install the internet
+   * stack on the nodes and address the links. Self loops are ignored.
+   * \returns the nodes, node i of the graph being node i of the container
+   */
+  NodeContainer Install (const TopologyGraph &graph);
+
+  /// Wall clock milliseconds the last Install () took
+  int64_t GetInstallTime (void) const;
+
+  uint32_t GetNLinks (void) const;
+  /// The link between two graph nodes (the first one if there are several)
+  uint32_t GetLink (uint32_t from, uint32_t to) const;
+  /// The graph node at one side (0 or 1) of a link
+  uint32_t GetLinkNode (uint32_t link, uint32_t side) const;
+  Ptr<NetDevice> GetLinkDevice (uint32_t link, uint32_t side) const;
+  Ptr<PointToPointChannel> GetLinkChannel (uint32_t link) const;
+  Ipv4Address GetLinkAddress (uint32_t link, uint32_t side) const;
+  /// The graph node with an address, or TopologyGraph::NO_NODE
+  uint32_t GetAddressNode (Ipv4Address address) const;
+
+private:
+  PointToPointHelper m_pointToPoint;
+  uint32_t m_base;
+  Ipv4Mask m_mask;
+  uint32_t m_hostBits;
+  bool m_merge;
+  int64_t m_installTime;
+  /// Row offsets and neighbours of the installed graph
+  std::vector<uint32_t> m_offsets;
+  std::vector<uint32_t> m_neighbours;
+  /// The link for each neighbour slot, NO_LINK for slots of lower nodes
+  std::vector<uint32_t> m_slotLinks;
+  /// Two entries per link, one for each side
+  std::vector<uint32_t> m_linkNodes;
+  std::vector<Ptr<NetDevice> > m_linkDevices;
+  std::vector<Ptr<PointToPointChannel> > m_channels;
+};
+
+} // namespace ns3
+
+#endif /* POINT_TO_POINT_TOPOLOGY_HELPER_H */
@@ -24,6 +24,7 @@
 #include "ns3/inet-topology-reader.h"
 #include "ns3/orbis-topology-reader.h"
 #include "ns3/rocketfuel-topology-reader.h"
+#include "ns3/edge-list-topology-reader.h"
 #include "ns3/log.h"
 
 namespace ns3 {
@@ -71,6 +72,11 @@ TopologyReaderHelper::GetTopologyReader ()
           NS_LOG_INFO ("Creating Rocketfuel formatted data input.");
           m_inFile = CreateObject<RocketfuelTopologyReader> ();
         }
+      else if (m_fileType == "EdgeList")
+        {
+          NS_LOG_INFO ("Creating edge list formatted data input.");
+          m_inFile = CreateObject<EdgeListTopologyReader> ();
+        }
       else
         {
           NS_ASSERT_MSG (false, "Wrong (unknown) File Type");
@@ -0,0 +1,345 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <set>
+#include <sstream>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "ns3/log.h"
+#include "ns3/abort.h"
+#include "ns3/string.h"
+#include "ns3/system-wall-clock-ms.h"
+#include "edge-list-topology-reader.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("EdgeListTopologyReader");
+
+NS_OBJECT_ENSURE_REGISTERED (EdgeListTopologyReader);
+
+namespace {
+
+/// A whole file mapped read only, unmapped when it goes out of scope
+class MappedFile
+{
+public:
+  MappedFile (const std::string &fileName)
+    : m_data (0),
+      m_size (0),
+      m_ok (false)
+  {
+    int fd = open (fileName.c_str (), O_RDONLY);
+    if (fd < 0)
+      {
+        return;
+      }
+    struct stat st;
+    if (fstat (fd, &st) == 0)
+      {
+        m_size = st.st_size;
+        if (m_size == 0)
+          {
+            m_ok = true;
+          }
+        else
+          {
+            void *data = mmap (0, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (data != MAP_FAILED)
+              {
+                madvise (data, m_size, MADV_SEQUENTIAL);
+                m_data = static_cast<const char *> (data);
+                m_ok = true;
+              }
+          }
+      }
+    close (fd);
+  }
+
+  ~MappedFile ()
+  {
+    if (m_data)
+      {
+        munmap (const_cast<char *> (m_data), m_size);
+      }
+  }
+
+  bool IsOk (void) const
+  {
+    return m_ok;
+  }
+  const char *Begin (void) const
+  {
+    return m_data;
+  }
+  const char *End (void) const
+  {
+    return m_data + m_size;
+  }
+
+private:
+  const char *m_data;
+  size_t m_size;
+  bool m_ok;
+};
+
+inline bool
+IsBlank (char c)
+{
+  return c == ' ' || c == '\t' || c == '\r';
+}
+
+inline bool
+IsDigit (char c)
+{
+  return c >= '0' && c <= '9';
+}
+
+/// Parse an unsigned number after any blanks, leaving p after it. A number
+/// that doesn't fit in 32 bits aborts, naming the file and line it is on
+inline bool
+ParseId (const char *&p, const char *end, uint32_t &id, const std::string &file, uint32_t line)
+{
+  while (p < end && IsBlank (*p))
+    {
+      p++;
+    }
+  if (p == end || !IsDigit (*p))
+    {
+      return false;
+    }
+  id = 0;
+  while (p < end && IsDigit (*p))
+    {
+      uint32_t digit = *p - '0';
+      NS_ABORT_MSG_IF (id > (std::numeric_limits<uint32_t>::max () - digit) / 10,
+                       "Node ID out of range in " << file << " line " << line);
+      id = id * 10 + digit;
+      p++;
+    }
+  return true;
+}
+
+/// Lines in [begin, end), counting a last one without a newline
+inline uint32_t
+CountLines (const char *begin, const char *end)
+{
+  uint32_t lines = std::count (begin, end, '\n');
+  if (begin < end && end[-1] != '\n')
+    {
+      lines++;
+    }
+  return lines;
+}
+
+} // anonymous namespace
+
+TypeId EdgeListTopologyReader::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::EdgeListTopologyReader")
+    .SetParent<TopologyReader> ()
+    .AddConstructor<EdgeListTopologyReader> ()
+    .AddAttribute ("HostFileName",
+                   "File listing the end host IDs (an .es file), if any.",
+                   StringValue (""),
+                   MakeStringAccessor (&EdgeListTopologyReader::m_hostFileName),
+                   MakeStringChecker ())
+  ;
+  return tid;
+}
+
+EdgeListTopologyReader::EdgeListTopologyReader ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+EdgeListTopologyReader::~EdgeListTopologyReader ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+bool
+EdgeListTopologyReader::ReadGraph (void)
+{
+  NS_LOG_FUNCTION (this << GetFileName ());
+  SystemWallClockMs clock;
+  clock.Start ();
+  m_graph.Clear ();
+  m_hosts.clear ();
+
+  {
+    MappedFile file (GetFileName ());
+    if (!file.IsOk ())
+      {
+        NS_LOG_WARN ("Cannot read topology file " << GetFileName ());
+        return false;
+      }
+    // At most one edge per line
+    m_graph.Reserve (CountLines (file.Begin (), file.End ()));
+    ParseEdges (file.Begin (), file.End ());
+  }
+  if (!m_hostFileName.empty ())
+    {
+      MappedFile file (m_hostFileName);
+      if (!file.IsOk ())
+        {
+          NS_LOG_WARN ("Cannot read host file " << m_hostFileName);
+          return false;
+        }
+      ParseHosts (file.Begin (), file.End ());
+    }
+  m_graph.Build ();
+
+  NS_LOG_INFO ("Read " << m_graph.GetNNodes () << " nodes, " << m_graph.GetNEdges () << " links and "
+                       << m_hosts.size () << " hosts in " << clock.End () << " ms");
+  return true;
+}
+
+void
+EdgeListTopologyReader::ParseEdges (const char *begin, const char *end)
+{
+  const char *line = begin;
+  uint32_t lineNumber = 0;
+  while (line < end)
+    {
+      lineNumber++;
+      const char *eol = static_cast<const char *> (std::memchr (line, '\n', end - line));
+      if (eol == 0)
+        {
+          eol = end;
+        }
+      const char *p = line;
+      uint32_t from;
+      uint32_t to;
+      if (ParseId (p, eol, from, GetFileName (), lineNumber)
+          && ParseId (p, eol, to, GetFileName (), lineNumber))
+        {
+          while (p < eol && IsBlank (*p))
+            {
+              p++;
+            }
+          if (p < eol && *p == 'h' && (p + 1 == eol || IsBlank (p[1])))
+            {
+              m_hosts.push_back (to);
+              m_graph.AddEdge (from, to);
+            }
+          else if (p < eol && (IsDigit (*p) || *p == '.' || *p == '-' || *p == '+'))
+            {
+              // strtod needs a terminated string, and the mapping isn't one
+              char weight[64];
+              size_t length = 0;
+              while (p < eol && !IsBlank (*p) && length < sizeof (weight) - 1)
+                {
+                  weight[length++] = *p++;
+                }
+              weight[length] = '\0';
+              m_graph.AddEdge (from, to, std::strtod (weight, 0));
+            }
+          else
+            {
+              m_graph.AddEdge (from, to);
+            }
+        }
+      line = eol + 1;
+    }
+}
+
+void
+EdgeListTopologyReader::ParseHosts (const char *begin, const char *end)
+{
+  std::set<uint32_t> listed (m_hosts.begin (), m_hosts.end ());
+  const char *p = begin;
+  uint32_t lineNumber = 1;
+  while (p < end)
+    {
+      if (!IsDigit (*p))
+        {
+          if (*p == '\n')
+            {
+              lineNumber++;
+            }
+          p++;
+          continue;
+        }
+      uint32_t id;
+      ParseId (p, end, id, m_hostFileName, lineNumber);
+      if (listed.insert (id).second)
+        {
+          m_hosts.push_back (id);
+        }
+    }
+}
+
+const TopologyGraph &
+EdgeListTopologyReader::GetGraph (void) const
+{
+  return m_graph;
+}
+
+const std::vector<uint32_t> &
+EdgeListTopologyReader::GetHosts (void) const
+{
+  return m_hosts;
+}
+
+NodeContainer
+EdgeListTopologyReader::Read (void)
+{
+  NodeContainer nodes;
+  if (!ReadGraph ())
+    {
+      return nodes;
+    }
+  nodes.Create (m_graph.GetNNodes ());
+  std::vector<std::string> names (m_graph.GetNNodes ());
+  for (uint32_t node = 0; node < names.size (); node++)
+    {
+      std::ostringstream name;
+      name << m_graph.GetId (node);
+      names[node] = name.str ();
+    }
+
+  const std::vector<uint32_t> &offsets = m_graph.GetOffsets ();
+  const std::vector<uint32_t> &neighbours = m_graph.GetNeighbours ();
+  for (uint32_t from = 0; from < m_graph.GetNNodes (); from++)
+    {
+      for (uint32_t slot = offsets[from]; slot < offsets[from + 1]; slot++)
+        {
+          uint32_t to = neighbours[slot];
+          if (to <= from)
+            {
+              continue;
+            }
+          Link link (nodes.Get (from), names[from], nodes.Get (to), names[to]);
+          if (m_graph.HasWeights ())
+            {
+              std::ostringstream weight;
+              weight << m_graph.GetWeights ()[slot];
+              link.SetAttribute ("Weight", weight.str ());
+            }
+          AddLink (link);
+        }
+    }
+  return nodes;
+}
+
+} // namespace ns3
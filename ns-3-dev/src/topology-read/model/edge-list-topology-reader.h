@@ -0,0 +1,92 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef EDGE_LIST_TOPOLOGY_READER_H
+#define EDGE_LIST_TOPOLOGY_READER_H
+
+#include <string>
+#include <vector>
+#include "topology-reader.h"
+#include "topology-graph.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup topology
+ *
+ * \brief Topology file reader for plain edge lists.
+ *
+ * Every line holds the numeric IDs of the two ends of a link, optionally
+ * followed by either a weight, as in the Rocketfuel .we files, or an "h"
+ * marking the second node as an end host. Lines that don't start with two
+ * IDs, such as comments, are skipped, and so are any further fields. This
+ * covers the Rocketfuel .bb, .bb.new and .we files and the data center
+ * .topo files.
+ *
+ * The end hosts of a data center are listed separately, in an .es file
+ * holding the host IDs in any punctuation (e.g. "[49, 50, 51]"); give its
+ * name with the HostFileName attribute.
+ *
+ * The file is mapped into memory and parsed in place straight into a
+ * TopologyGraph, which ReadGraph () fills without creating any nodes.
+ */
+class EdgeListTopologyReader : public TopologyReader
+{
+public:
+  static TypeId GetTypeId (void);
+
+  EdgeListTopologyReader ();
+  virtual ~EdgeListTopologyReader ();
+
+  /**
+   * \brief Parse the file, and the host file if there is one, into the
+   * graph and host list.
+   * \return false if a file could not be read
+   */
+  bool ReadGraph (void);
+
+  /// The graph of the last ReadGraph () or Read ()
+  const TopologyGraph &GetGraph (void) const;
+
+  /// IDs of the end hosts, those marked in the file followed by those in the host file
+  const std::vector<uint32_t> &GetHosts (void) const;
+
+  /**
+   * \brief Main topology reading function.
+   *
+   * Reads the graph, then creates a node for every graph node, in graph
+   * order, and a link for every edge other than self loops, with any
+   * weight as its "Weight" attribute.
+   *
+   * \return the container of the nodes created (or empty container if there was an error)
+   */
+  virtual NodeContainer Read (void);
+
+private:
+  EdgeListTopologyReader (const EdgeListTopologyReader&);
+  EdgeListTopologyReader& operator= (const EdgeListTopologyReader&);
+
+  void ParseEdges (const char *begin, const char *end);
+  void ParseHosts (const char *begin, const char *end);
+
+  std::string m_hostFileName;
+  TopologyGraph m_graph;
+  std::vector<uint32_t> m_hosts;
+};
+
+} // namespace ns3
+
+#endif /* EDGE_LIST_TOPOLOGY_READER_H */
@@ -0,0 +1,194 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <algorithm>
+#include "ns3/log.h"
+#include "ns3/assert.h"
+#include "topology-graph.h"
+
+NS_LOG_COMPONENT_DEFINE ("TopologyGraph");
+
+namespace ns3 {
+
+const uint32_t TopologyGraph::NO_NODE;
+
+TopologyGraph::TopologyGraph ()
+{
+  m_offsets.push_back (0);
+}
+
+void
+TopologyGraph::Clear (void)
+{
+  m_edges.clear ();
+  m_edgeWeights.clear ();
+  m_ids.clear ();
+  m_index.clear ();
+  m_offsets.assign (1, 0);
+  m_neighbours.clear ();
+  m_weights.clear ();
+}
+
+void
+TopologyGraph::AddEdge (uint32_t from, uint32_t to)
+{
+  m_edges.push_back (std::make_pair (from, to));
+  if (!m_edgeWeights.empty ())
+    {
+      m_edgeWeights.push_back (1.0);
+    }
+}
+
+void
+TopologyGraph::AddEdge (uint32_t from, uint32_t to, double weight)
+{
+  if (m_edgeWeights.size () < m_edges.size ())
+    {
+      m_edgeWeights.reserve (m_edges.capacity ());
+      m_edgeWeights.resize (m_edges.size (), 1.0);
+    }
+  m_edges.push_back (std::make_pair (from, to));
+  m_edgeWeights.push_back (weight);
+}
+
+void
+TopologyGraph::Reserve (uint32_t edges)
+{
+  m_edges.reserve (edges);
+}
+
+void
+TopologyGraph::Build (void)
+{
+  NS_LOG_FUNCTION (this << m_edges.size ());
+  m_ids.clear ();
+  m_ids.reserve (2 * m_edges.size ());
+  for (std::vector<std::pair<uint32_t, uint32_t> >::const_iterator it = m_edges.begin ();
+       it != m_edges.end (); it++)
+    {
+      m_ids.push_back (it->first);
+      m_ids.push_back (it->second);
+    }
+  std::sort (m_ids.begin (), m_ids.end ());
+  m_ids.erase (std::unique (m_ids.begin (), m_ids.end ()), m_ids.end ());
+  m_index.clear ();
+  if (!m_ids.empty () && m_ids.back () / 4 < m_ids.size ())
+    {
+      m_index.assign (m_ids.back () + 1, NO_NODE);
+      for (uint32_t node = 0; node < m_ids.size (); node++)
+        {
+          m_index[m_ids[node]] = node;
+        }
+    }
+
+  // Count every node's degree, then place each edge at its ends' cursors so
+  // the rows keep the order the edges were added in
+  std::vector<std::pair<uint32_t, uint32_t> > edges (m_edges.size ());
+  m_offsets.assign (m_ids.size () + 1, 0);
+  for (uint32_t i = 0; i < m_edges.size (); i++)
+    {
+      edges[i].first = GetNode (m_edges[i].first);
+      edges[i].second = GetNode (m_edges[i].second);
+      m_offsets[edges[i].first + 1]++;
+      m_offsets[edges[i].second + 1]++;
+    }
+  for (uint32_t node = 0; node < m_ids.size (); node++)
+    {
+      m_offsets[node + 1] += m_offsets[node];
+    }
+  std::vector<uint32_t> cursor (m_offsets.begin (), m_offsets.end () - 1);
+  m_neighbours.resize (m_offsets.back ());
+  m_weights.resize (m_edgeWeights.empty () ? 0 : m_offsets.back ());
+  for (uint32_t i = 0; i < edges.size (); i++)
+    {
+      uint32_t first = cursor[edges[i].first]++;
+      uint32_t second = cursor[edges[i].second]++;
+      m_neighbours[first] = edges[i].second;
+      m_neighbours[second] = edges[i].first;
+      if (!m_weights.empty ())
+        {
+          m_weights[first] = m_edgeWeights[i];
+          m_weights[second] = m_edgeWeights[i];
+        }
+    }
+}
+
+uint32_t
+TopologyGraph::GetNNodes (void) const
+{
+  return m_ids.size ();
+}
+
+uint32_t
+TopologyGraph::GetNEdges (void) const
+{
+  return m_neighbours.size () / 2;
+}
+
+uint32_t
+TopologyGraph::GetDegree (uint32_t node) const
+{
+  NS_ASSERT (node < m_ids.size ());
+  return m_offsets[node + 1] - m_offsets[node];
+}
+
+const std::vector<uint32_t> &
+TopologyGraph::GetOffsets (void) const
+{
+  return m_offsets;
+}
+
+const std::vector<uint32_t> &
+TopologyGraph::GetNeighbours (void) const
+{
+  return m_neighbours;
+}
+
+bool
+TopologyGraph::HasWeights (void) const
+{
+  return !m_weights.empty ();
+}
+
+const std::vector<double> &
+TopologyGraph::GetWeights (void) const
+{
+  return m_weights;
+}
+
+uint32_t
+TopologyGraph::GetId (uint32_t node) const
+{
+  NS_ASSERT (node < m_ids.size ());
+  return m_ids[node];
+}
+
+uint32_t
+TopologyGraph::GetNode (uint32_t id) const
+{
+  if (!m_index.empty ())
+    {
+      return id < m_index.size () ? m_index[id] : NO_NODE;
+    }
+  std::vector<uint32_t>::const_iterator it = std::lower_bound (m_ids.begin (), m_ids.end (), id);
+  if (it == m_ids.end () || *it != id)
+    {
+      return NO_NODE;
+    }
+  return it - m_ids.begin ();
+}
+
+} // namespace ns3
@@ -0,0 +1,97 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef TOPOLOGY_GRAPH_H
+#define TOPOLOGY_GRAPH_H
+
+#include <vector>
+#include <utility>
+#include <stdint.h>
+
+namespace ns3 {
+
+/**
+ * \ingroup topology
+ *
+ * \brief An undirected graph in compressed sparse row form.
+ *
+ * Edges are added by the node IDs used in the topology file, and Build ()
+ * numbers the nodes 0..n-1 in increasing ID order and lays every node's
+ * neighbours out contiguously: the neighbours of node i are
+ * GetNeighbours ()[GetOffsets ()[i]] up to GetNeighbours ()[GetOffsets ()[i + 1]].
+ * Each edge appears in the rows of both its ends, and a row lists its
+ * neighbours in the order the edges were added. Edges may carry a weight,
+ * laid out alongside the neighbours; once any edge has one, edges added
+ * without a weight count as weight 1.
+ */
+class TopologyGraph
+{
+public:
+  /// Returned by GetNode () for IDs that are not in the graph
+  static const uint32_t NO_NODE = 0xffffffff;
+
+  TopologyGraph ();
+
+  /// Forget all nodes and edges
+  void Clear (void);
+
+  /**
+   * \brief Add an undirected edge, which takes effect at the next Build ().
+   * \param from the file ID of one end
+   * \param to the file ID of the other end
+   */
+  void AddEdge (uint32_t from, uint32_t to);
+  void AddEdge (uint32_t from, uint32_t to, double weight);
+
+  /// Make room for this many edges before adding them
+  void Reserve (uint32_t edges);
+
+  /// Number the nodes of every edge added since Clear () and lay out the rows
+  void Build (void);
+
+  uint32_t GetNNodes (void) const;
+  /// Number of undirected edges
+  uint32_t GetNEdges (void) const;
+  uint32_t GetDegree (uint32_t node) const;
+
+  /// GetNNodes () + 1 row offsets into GetNeighbours ()
+  const std::vector<uint32_t> &GetOffsets (void) const;
+  const std::vector<uint32_t> &GetNeighbours (void) const;
+  bool HasWeights (void) const;
+  /// The weight of the edge to each neighbour, empty unless HasWeights ()
+  const std::vector<double> &GetWeights (void) const;
+
+  /// The file ID of a node
+  uint32_t GetId (uint32_t node) const;
+  /// The node with a file ID, or NO_NODE
+  uint32_t GetNode (uint32_t id) const;
+
+private:
+  std::vector<std::pair<uint32_t, uint32_t> > m_edges;
+  std::vector<double> m_edgeWeights;
+  /// File IDs, sorted, so node i has ID m_ids[i]
+  std::vector<uint32_t> m_ids;
+  /// Node of every ID up to the largest, when the IDs are dense enough for
+  /// a table to beat searching m_ids
+  std::vector<uint32_t> m_index;
+  std::vector<uint32_t> m_offsets;
+  std::vector<uint32_t> m_neighbours;
+  std::vector<double> m_weights;
+};
+
+} // namespace ns3
+
+#endif /* TOPOLOGY_GRAPH_H */
@@ -0,0 +1,104 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/edge-list-topology-reader.h"
+#include "ns3/string.h"
+#include "ns3/simulator.h"
+
+namespace ns3 {
+
+class EdgeListTopologyReaderWeightsTest : public TestCase
+{
+public:
+  EdgeListTopologyReaderWeightsTest ();
+private:
+  virtual void DoRun (void);
+};
+
+EdgeListTopologyReaderWeightsTest::EdgeListTopologyReaderWeightsTest ()
+  : TestCase ("EdgeListTopologyReaderWeightsTest")
+{
+}
+
+void
+EdgeListTopologyReaderWeightsTest::DoRun (void)
+{
+  Ptr<EdgeListTopologyReader> inFile = CreateObject<EdgeListTopologyReader> ();
+  inFile->SetFileName ("./src/topology-read/examples/EdgeList_toposample_weights.we");
+
+  NodeContainer nodes = inFile->Read ();
+  NS_TEST_ASSERT_MSG_EQ (nodes.GetN (), 6, "nodes");
+  NS_TEST_EXPECT_MSG_EQ (inFile->LinksSize (), 5, "links");
+
+  const TopologyGraph &graph = inFile->GetGraph ();
+  NS_TEST_ASSERT_MSG_EQ (graph.HasWeights (), true, "weights");
+  // The first line is "1 2 1.048777"
+  uint32_t node = graph.GetNode (1);
+  NS_TEST_ASSERT_MSG_EQ (graph.GetNeighbours ()[graph.GetOffsets ()[node]], graph.GetNode (2), "first edge");
+  NS_TEST_EXPECT_MSG_EQ_TOL (graph.GetWeights ()[graph.GetOffsets ()[node]], 1.048777, 1e-9, "first weight");
+  NS_TEST_EXPECT_MSG_EQ (inFile->LinksBegin ()->GetAttribute ("Weight"), "1.04878", "link attribute");
+  Simulator::Destroy ();
+}
+
+class EdgeListTopologyReaderHostsTest : public TestCase
+{
+public:
+  EdgeListTopologyReaderHostsTest ();
+private:
+  virtual void DoRun (void);
+};
+
+EdgeListTopologyReaderHostsTest::EdgeListTopologyReaderHostsTest ()
+  : TestCase ("EdgeListTopologyReaderHostsTest")
+{
+}
+
+void
+EdgeListTopologyReaderHostsTest::DoRun (void)
+{
+  Ptr<EdgeListTopologyReader> inFile = CreateObject<EdgeListTopologyReader> ();
+  inFile->SetFileName ("./src/topology-read/examples/EdgeList_toposample.topo");
+  inFile->SetAttribute ("HostFileName", StringValue ("./src/topology-read/examples/EdgeList_toposample.es"));
+
+  NS_TEST_ASSERT_MSG_EQ (inFile->ReadGraph (), true, "read");
+  const TopologyGraph &graph = inFile->GetGraph ();
+  NS_TEST_EXPECT_MSG_EQ (graph.GetNNodes (), 7, "nodes");
+  NS_TEST_EXPECT_MSG_EQ (graph.GetNEdges (), 6, "links");
+  NS_TEST_EXPECT_MSG_EQ (graph.HasWeights (), false, "no weights");
+  NS_TEST_ASSERT_MSG_EQ (inFile->GetHosts ().size (), 4, "hosts");
+  NS_TEST_EXPECT_MSG_EQ (inFile->GetHosts ().front (), 4, "first host");
+  NS_TEST_EXPECT_MSG_EQ (inFile->GetHosts ().back (), 7, "last host");
+
+  inFile->SetFileName ("./src/topology-read/examples/missing.topo");
+  NS_TEST_EXPECT_MSG_EQ (inFile->ReadGraph (), false, "missing file");
+}
+
+class EdgeListTopologyReaderTestSuite : public TestSuite
+{
+public:
+  EdgeListTopologyReaderTestSuite ();
+};
+
+EdgeListTopologyReaderTestSuite::EdgeListTopologyReaderTestSuite ()
+  : TestSuite ("edge-list-topology-reader", UNIT)
+{
+  AddTestCase (new EdgeListTopologyReaderWeightsTest ());
+  AddTestCase (new EdgeListTopologyReaderHostsTest ());
+}
+
+static EdgeListTopologyReaderTestSuite edgeListTopologyReaderTestSuite;
+}
@@ -0,0 +1,137 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/topology-graph.h"
+#include "ns3/point-to-point-topology-helper.h"
+#include "ns3/ipv4.h"
+#include "ns3/simulator.h"
+
+namespace ns3 {
+
+class TopologyGraphTest : public TestCase
+{
+public:
+  TopologyGraphTest ();
+private:
+  virtual void DoRun (void);
+};
+
+TopologyGraphTest::TopologyGraphTest ()
+  : TestCase ("TopologyGraphTest")
+{
+}
+
+void
+TopologyGraphTest::DoRun (void)
+{
+  TopologyGraph graph;
+  graph.AddEdge (20, 5);
+  graph.AddEdge (5, 7);
+  graph.AddEdge (7, 20);
+  graph.AddEdge (20, 31);
+  graph.Build ();
+
+  NS_TEST_ASSERT_MSG_EQ (graph.GetNNodes (), 4, "nodes");
+  NS_TEST_ASSERT_MSG_EQ (graph.GetNEdges (), 4, "edges");
+  NS_TEST_EXPECT_MSG_EQ (graph.GetId (0), 5, "nodes are numbered in ID order");
+  NS_TEST_EXPECT_MSG_EQ (graph.GetId (3), 31, "nodes are numbered in ID order");
+  NS_TEST_EXPECT_MSG_EQ (graph.GetNode (20), 2, "ID lookup");
+  NS_TEST_EXPECT_MSG_EQ (graph.GetNode (6), TopologyGraph::NO_NODE, "unknown ID");
+  NS_TEST_EXPECT_MSG_EQ (graph.GetDegree (2), 3, "degree");
+
+  // Node 20's row lists its neighbours in the order of the edges
+  const std::vector<uint32_t> &offsets = graph.GetOffsets ();
+  const std::vector<uint32_t> &neighbours = graph.GetNeighbours ();
+  NS_TEST_EXPECT_MSG_EQ (neighbours[offsets[2]], 0, "first neighbour of 20");
+  NS_TEST_EXPECT_MSG_EQ (neighbours[offsets[2] + 1], 1, "second neighbour of 20");
+  NS_TEST_EXPECT_MSG_EQ (neighbours[offsets[2] + 2], 3, "third neighbour of 20");
+}
+
+class PointToPointTopologyHelperTest : public TestCase
+{
+public:
+  PointToPointTopologyHelperTest ();
+private:
+  virtual void DoRun (void);
+};
+
+PointToPointTopologyHelperTest::PointToPointTopologyHelperTest ()
+  : TestCase ("PointToPointTopologyHelperTest")
+{
+}
+
+void
+PointToPointTopologyHelperTest::DoRun (void)
+{
+  // A square with a diagonal and a repeated edge
+  TopologyGraph graph;
+  graph.AddEdge (1, 2);
+  graph.AddEdge (2, 3);
+  graph.AddEdge (3, 4);
+  graph.AddEdge (4, 1);
+  graph.AddEdge (1, 3);
+  graph.AddEdge (2, 1);
+  graph.Build ();
+
+  PointToPointTopologyHelper helper;
+  helper.SetMergeParallelEdges (true);
+  NodeContainer nodes = helper.Install (graph);
+
+  NS_TEST_ASSERT_MSG_EQ (nodes.GetN (), 4, "nodes");
+  NS_TEST_ASSERT_MSG_EQ (helper.GetNLinks (), 5, "the repeated edge is merged");
+  // Links are numbered in row order: 0-1, 0-3, 0-2, 1-2, 2-3
+  NS_TEST_EXPECT_MSG_EQ (helper.GetLink (0, 1), 0, "link 0-1");
+  NS_TEST_EXPECT_MSG_EQ (helper.GetLink (3, 0), 1, "link 0-3");
+  NS_TEST_EXPECT_MSG_EQ (helper.GetLink (2, 3), 4, "link 2-3");
+  NS_TEST_EXPECT_MSG_EQ (helper.GetLink (1, 3), PointToPointTopologyHelper::NO_LINK, "no link 1-3");
+  NS_TEST_EXPECT_MSG_EQ (helper.GetLink (graph.GetNode (1), graph.GetNode (5)), PointToPointTopologyHelper::NO_LINK, "unknown ID");
+  NS_TEST_EXPECT_MSG_EQ (helper.GetLink (TopologyGraph::NO_NODE, TopologyGraph::NO_NODE), PointToPointTopologyHelper::NO_LINK, "unknown nodes");
+  NS_TEST_EXPECT_MSG_EQ (helper.GetLinkNode (2, 0), 0, "lower end of link 0-2");
+  NS_TEST_EXPECT_MSG_EQ (helper.GetLinkNode (2, 1), 2, "higher end of link 0-2");
+  NS_TEST_EXPECT_MSG_EQ (helper.GetLinkChannel (3)->GetDevice (0), helper.GetLinkDevice (3, 0), "channel of link 1-2");
+
+  NS_TEST_EXPECT_MSG_EQ (helper.GetLinkAddress (0, 0), Ipv4Address ("10.1.1.1"), "first address");
+  NS_TEST_EXPECT_MSG_EQ (helper.GetLinkAddress (4, 1), Ipv4Address ("10.1.5.2"), "last address");
+  NS_TEST_EXPECT_MSG_EQ (helper.GetAddressNode (Ipv4Address ("10.1.4.2")), 2, "address lookup");
+  NS_TEST_EXPECT_MSG_EQ (helper.GetAddressNode (Ipv4Address ("10.1.6.1")), TopologyGraph::NO_NODE, "unused subnet");
+  NS_TEST_EXPECT_MSG_EQ (helper.GetAddressNode (Ipv4Address ("10.1.2.3")), TopologyGraph::NO_NODE, "unused host");
+
+  // Interfaces come up in link order, as with Ipv4AddressHelper
+  Ptr<Ipv4> ipv4 = nodes.Get (0)->GetObject<Ipv4> ();
+  NS_TEST_ASSERT_MSG_EQ (ipv4->GetNInterfaces (), 4, "loopback and three links");
+  NS_TEST_EXPECT_MSG_EQ (ipv4->GetAddress (1, 0).GetLocal (), Ipv4Address ("10.1.1.1"), "interface 1");
+  NS_TEST_EXPECT_MSG_EQ (ipv4->GetAddress (3, 0).GetLocal (), Ipv4Address ("10.1.3.1"), "interface 3");
+  NS_TEST_EXPECT_MSG_EQ (ipv4->GetAddress (3, 0).GetMask (), Ipv4Mask ("255.255.255.0"), "mask");
+  NS_TEST_EXPECT_MSG_EQ (ipv4->IsUp (3), true, "interface up");
+  Simulator::Destroy ();
+}
+
+class PointToPointTopologyHelperTestSuite : public TestSuite
+{
+public:
+  PointToPointTopologyHelperTestSuite ();
+};
+
+PointToPointTopologyHelperTestSuite::PointToPointTopologyHelperTestSuite ()
+  : TestSuite ("point-to-point-topology-helper", UNIT)
+{
+  AddTestCase (new TopologyGraphTest ());
+  AddTestCase (new PointToPointTopologyHelperTest ());
+}
+
+static PointToPointTopologyHelperTestSuite pointToPointTopologyHelperTestSuite;
+}
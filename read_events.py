@@ -0,0 +1,28 @@
+import sys
+import struct
+# Reads the binary event files the DDC drivers write with --events (see
+# examples/apanda/event-recorder.h), one (time ns, type, node, src, dst, seq,
+# ttl) tuple per event, so analysis can aggregate without parsing text.
+TYPES = ["RX", "SRX", "R", "D", "P", "F", "TCPRX"]
+HEADER = struct.Struct("<8sII")
+RECORD = struct.Struct("<qIIIIBB6x")
+BLOCK = 65536
+def read_events(fname):
+    f = open(fname, "rb")
+    magic, size, reserved = HEADER.unpack(f.read(HEADER.size))
+    if magic != "DDCEVT1\0" or size != RECORD.size:
+        raise ValueError(fname + " is not an event file this reader understands")
+    while True:
+        block = f.read(RECORD.size * BLOCK)
+        if not block:
+            break
+        for offset in xrange(0, len(block) - RECORD.size + 1, RECORD.size):
+            time, node, src, dst, seq, etype, ttl = RECORD.unpack_from(block, offset)
+            yield (time, etype, node, src, dst, seq, ttl)
+def main(args):
+    # Print every event as time (us),type,node,src,dst,seq,ttl
+    for fname in args:
+        for e in read_events(fname):
+            print str.format("{0},{1},{2},{3},{4},{5},{6}", e[0] / 1000.0, TYPES[e[1]], e[2], e[3], e[4], e[5], e[6])
+if __name__ == "__main__":
+    main(sys.argv[1:])